@@ -0,0 +1,233 @@
+#include "bench/bench.h"
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+using namespace Bench;
+using std::string;
+using std::vector;
+using Util::Blob;
+using Util::MutableBlob;
+
+namespace {
+
+// Settings which can be changed from the command line
+struct Options
+{
+  U64 minSize;
+  U64 maxSize;
+  double minTime;       // seconds per measurement
+  string filter;        // substring of benchmark names to run
+};
+
+struct Result
+{
+  string name;
+  U64 size;
+  U64 iterations;
+  double seconds;
+  U64 bytesPerOp;
+};
+
+vector<Benchmark> &registry()
+{
+  static vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+void usage(const char *program)
+{
+  std::cerr << "Usage: " << program << " [options]" << std::endl
+            << "  --filter=STR     Only run benchmarks whose name contains STR" << std::endl
+            << "  --min-size=N     Smallest size in bytes (default 8)" << std::endl
+            << "  --max-size=N     Largest size in bytes (default 1073741824)" << std::endl
+            << "  --min-time=S     Minimum seconds per measurement (default 0.1)" << std::endl
+            << "  --list           List benchmark names and exit" << std::endl;
+}
+
+bool parseOption(const char *arg, const char *name, const char **value)
+{
+  U64 len = strlen(name);
+  if (strncmp(arg, name, len) == 0 && arg[len] == '=') {
+    *value = &arg[len + 1];
+    return true;
+  }
+  return false;
+}
+
+double elapsed(U64 iterations, Loop &loop)
+{
+  auto start = std::chrono::steady_clock::now();
+  loop(iterations);
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(stop - start).count();
+}
+
+// Grow the iteration count until one run of the loop takes at least 'minTime'
+Result measure(const Benchmark &bench, U64 size, double minTime)
+{
+  Loop loop = bench.setup(size);
+  U64 iterations = 1;
+  double seconds = elapsed(iterations, loop);
+  while (seconds < minTime) {
+    double scale = (seconds > 0.0) ? (1.4 * minTime / seconds) : 100.0;
+    if (scale > 100.0) {
+      scale = 100.0;
+    }
+    if (scale < 2.0) {
+      scale = 2.0;
+    }
+    iterations = (U64)((double)iterations * scale);
+    seconds = elapsed(iterations, loop);
+  }
+  return Result{bench.name, size, iterations, seconds, bench.bytesPerOp};
+}
+
+string jsonEscape(const string &s)
+{
+  string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    }
+    else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+      out += buf;
+    }
+    else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+void writeJson(std::ostream &os, const vector<Result> &results, const Options &options)
+{
+  char host[256] = {0};
+  gethostname(host, sizeof(host) - 1);
+  char date[32] = {0};
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  os << "{\n  \"context\": {\n"
+     << "    \"date\": \"" << date << "\",\n"
+     << "    \"host\": \"" << jsonEscape(host) << "\",\n"
+     << "    \"compiler\": \"" << jsonEscape(__VERSION__) << "\",\n"
+     << "    \"min_time\": " << options.minTime << "\n"
+     << "  },\n  \"benchmarks\": [";
+  for (U64 i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    double nsPerOp = r.seconds * 1e9 / (double)r.iterations;
+    double bytesPerSecond = (double)(r.size * r.bytesPerOp) * (double)r.iterations / r.seconds;
+    os << ((i == 0) ? "\n" : ",\n")
+       << "    {\"name\": \"" << jsonEscape(r.name) << "\", "
+       << "\"size\": " << r.size << ", "
+       << "\"iterations\": " << r.iterations << ", "
+       << "\"ns_per_op\": " << nsPerOp << ", "
+       << "\"bytes_per_second\": " << bytesPerSecond << "}";
+  }
+  os << "\n  ]\n}" << std::endl;
+}
+
+} // anonymous namespace
+
+bool Bench::add(const string &_name, Setup _setup, U64 _maxSize, U64 _bytesPerOp)
+{
+  registry().push_back(Benchmark{_name, _setup, _maxSize, _bytesPerOp});
+  return true;
+}
+
+int Bench::run(int _argc, char **_argv)
+{
+  Options options{8, 1UL << 30, 0.1, ""};
+  bool list = false;
+
+  for (int i = 1; i < _argc; i++) {
+    const char *value;
+    if (parseOption(_argv[i], "--filter", &value)) {
+      options.filter = value;
+    }
+    else if (parseOption(_argv[i], "--min-size", &value)) {
+      options.minSize = strtoull(value, nullptr, 0);
+    }
+    else if (parseOption(_argv[i], "--max-size", &value)) {
+      options.maxSize = strtoull(value, nullptr, 0);
+    }
+    else if (parseOption(_argv[i], "--min-time", &value)) {
+      options.minTime = strtod(value, nullptr);
+    }
+    else if (strcmp(_argv[i], "--list") == 0) {
+      list = true;
+    }
+    else {
+      usage(_argv[0]);
+      return 1;
+    }
+  }
+
+  vector<Result> results;
+  for (const Benchmark &bench : registry()) {
+    if (bench.name.find(options.filter) == string::npos) {
+      continue;
+    }
+    if (list) {
+      std::cout << bench.name << std::endl;
+      continue;
+    }
+    // Sizes from 8 B to 1 GB in steps of 8x
+    for (U64 size = 8; size <= (1UL << 30); size <<= 3) {
+      if ((size < options.minSize) || (size > options.maxSize) || (size > bench.maxSize)) {
+        continue;
+      }
+      std::cerr << "[Bench] " << bench.name << " " << size << std::endl;
+      results.push_back(measure(bench, size, options.minTime));
+    }
+  }
+  if (!list) {
+    writeJson(std::cout, results, options);
+  }
+  return 0;
+}
+
+Blob Bench::randomBlob(U64 _size)
+{
+  MutableBlob blob(_size);
+  Byte *data = blob.data();
+
+  // xorshift64* is plenty for benchmark inputs and fast enough for 1 GB
+  U64 state = 0x9e3779b97f4a7c15UL ^ _size;
+  U64 i = 0;
+  for (; i + 8 <= _size; i += 8) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    U64 word = state * 0x2545f4914f6cdd1dUL;
+    memcpy((void *)&data[i], (const void *)&word, 8);
+  }
+  for (; i < _size; i++) {
+    data[i] = (Byte)(i * 131);
+  }
+  return blob;
+}
+
+string Bench::randomString(U64 _size, const string &_alphabet)
+{
+  Blob bytes = randomBlob(_size);
+  string out(_size, _alphabet[0]);
+  for (U64 i = 0; i < _size; i++) {
+    out[i] = _alphabet[bytes[i] % _alphabet.size()];
+  }
+  return out;
+}
+
+int main(int argc, char **argv)
+{
+  return Bench::run(argc, argv);
+}
@@ -0,0 +1,83 @@
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include "util/blob.h"
+#include "util/fixed_types.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+   A minimal benchmark harness for the Blob library.
+
+   Benchmarks are registered by name with a setup function. The harness calls
+   the setup function once for every size in the size sweep (8 B to 1 GB,
+   growing by 8x) and receives a loop function which runs the measured
+   operation a given number of times. The number of iterations is calibrated
+   so that each measurement runs for at least a minimum amount of time.
+
+   Results are written to stdout as a single JSON document so they can be
+   tracked across releases. Progress is written to stderr.
+*/
+
+namespace Bench {
+
+// Runs the measured operation 'iterations' times
+typedef std::function<void(U64 iterations)> Loop;
+
+// Prepares the inputs for one size and returns the measured loop
+typedef std::function<Loop(U64 size)> Setup;
+
+struct Benchmark
+{
+  std::string name;
+  Setup setup;
+  U64 maxSize;      // Sizes above this are skipped (e.g. quadratic codecs)
+  U64 bytesPerOp;   // Bytes processed per operation as a multiple of size
+};
+
+// Register a benchmark. Returns true so it may initialize a static.
+bool add(const std::string &name, Setup setup, U64 maxSize = ~0UL, U64 bytesPerOp = 1);
+
+// Run all registered benchmarks (see bench.cc for the command line options)
+int run(int argc, char **argv);
+
+// Calls 'fn' during static initialization to register a group of benchmarks
+struct Registrar
+{
+  explicit Registrar(std::function<void()> fn) { fn(); }
+};
+
+// Wraps a nullary callable in a Loop so the callable is inlined into the loop
+template<typename F>
+Loop loop(F f)
+{
+  return [f] (U64 iterations) mutable {
+    for (U64 i = 0; i < iterations; i++) {
+      f();
+    }
+  };
+}
+
+// Prevent the compiler from eliding a computed value
+template<typename T>
+inline void doNotOptimize(const T &value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Force pending memory writes to be considered observable
+inline void clobberMemory()
+{
+  asm volatile("" : : : "memory");
+}
+
+// A Blob of 'size' pseudo-random bytes (deterministic for a given size)
+Util::Blob randomBlob(U64 size);
+
+// A string of 'size' bytes drawn from 'alphabet'
+std::string randomString(U64 size, const std::string &alphabet);
+
+} // namespace Bench
+
+#endif // BENCH_BENCH_H
@@ -0,0 +1,296 @@
+#include "bench/bench.h"
+#include "util/blob.h"
+#include "util/blob_builder.h"
+#include <memory>
+#include <string>
+#include <utility>
+
+using namespace Bench;
+using Util::Blob;
+using Util::MutableBlob;
+using std::string;
+
+static const Registrar registrar([] {
+
+  // *** Construction ***
+
+  add("blob/construct/size", [] (U64 size) {
+    return loop([size] {
+      Blob b(size);
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/construct/size_zeros", [] (U64 size) {
+    return loop([size] {
+      Blob b(size, Blob::ScrubType::ZEROS);
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/construct/pointer", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Blob b(src.data(), src.size());
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/construct/string", [] (U64 size) {
+    string src = randomString(size, "abcdefghijklmnopqrstuvwxyz");
+    return loop([src] {
+      Blob b(src);
+      doNotOptimize(b.data());
+    });
+  });
+
+  // A buffer which is done with (e.g. from the network), copied or adopted.
+  // Both include producing the buffer.
+  add("blob/construct/string_copy", [] (U64 size) {
+    string src = randomString(size, "abcdefghijklmnopqrstuvwxyz");
+    return loop([src] {
+      string received(src);
+      Blob b(static_cast<const string &>(received));
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/construct/string_adopt", [] (U64 size) {
+    string src = randomString(size, "abcdefghijklmnopqrstuvwxyz");
+    return loop([src] {
+      string received(src);
+      Blob b(std::move(received));
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/construct/initializer_list", [] (U64 size) {
+    Blob src = randomBlob(size);
+    Blob head(src, size / 2, 0);
+    Blob tail(src, size - (size / 2), size / 2);
+    return loop([head, tail] {
+      Blob b({head, tail});
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/construct/mutable_size", [] (U64 size) {
+    return loop([size] {
+      MutableBlob b(size);
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/construct/mutable_copy", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      MutableBlob b(src);
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("blob/data_is", [] (U64 size) {
+    Blob src = randomBlob(size);
+    Blob dst;
+    return loop([src, dst] () mutable {
+      dst.dataIs(src.data(), src.size());
+      doNotOptimize(dst.data());
+    });
+  });
+
+  // *** Slicing, copy and move (independent of size; bytesPerOp = 0) ***
+
+  add("blob/slice", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Blob b(src, src.size() / 2, src.size() / 4);
+      doNotOptimize(b.data());
+    });
+  }, ~0UL, 0);
+
+  add("view/slice", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Util::BlobView v(src.view(), src.size() / 2, src.size() / 4);
+      doNotOptimize(v.data());
+    });
+  }, ~0UL, 0);
+
+  // Splitting into 16-byte fields, as a parser would
+  add("blob/split_fields", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      for (U64 offset = 0; offset < src.size(); offset += 16) {
+        Blob field(src, 16, offset);
+        doNotOptimize(field.data());
+      }
+    });
+  });
+
+  add("view/split_fields", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Util::BlobView view = src.view();
+      for (U64 offset = 0; offset < view.size(); offset += 16) {
+        Util::BlobView field(view, 16, offset);
+        doNotOptimize(field.data());
+      }
+    });
+  });
+
+  add("blob/copy", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Blob b(src);
+      doNotOptimize(b.data());
+    });
+  }, ~0UL, 0);
+
+  add("blob/move", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] () mutable {
+      Blob b(std::move(src));
+      doNotOptimize(b.data());
+      src = std::move(b);
+    });
+  }, ~0UL, 0);
+
+  // *** Byte access: through the accessors, and through a raw pointer ***
+
+  add("blob/access/index", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      U64 sum = 0;
+      for (U64 i = 0; i < src.size(); i++) {
+        sum += src[i];
+      }
+      doNotOptimize(sum);
+    });
+  });
+
+  add("blob/access/pointer", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      const Byte *data = src.data();
+      U64 n = src.size();
+      U64 sum = 0;
+      for (U64 i = 0; i < n; i++) {
+        sum += data[i];
+      }
+      doNotOptimize(sum);
+    });
+  });
+
+  add("blob/access/mutable_index", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(size);
+    return loop([dst] {
+      MutableBlob &blob = *dst;
+      for (U64 i = 0; i < blob.size(); i++) {
+        blob[i] = (Byte)i;
+      }
+      clobberMemory();
+    });
+  });
+
+  add("blob/access/mutable_pointer", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(size);
+    return loop([dst] {
+      Byte *data = dst->data();
+      U64 n = dst->size();
+      for (U64 i = 0; i < n; i++) {
+        data[i] = (Byte)i;
+      }
+      clobberMemory();
+    });
+  });
+
+  // *** Search through lowercase text for a needle which is not in it, and
+  // splitting into 64 byte lines ***
+
+  add("blob/find/needle", [] (U64 size) {
+    Blob src(randomString(size, "abcdefghijklmnopqrstuvwxyz"));
+    return loop([src] {
+      U64 at = src.find(Util::BlobView((const Byte *)"needle!", 7));
+      doNotOptimize(at);
+    });
+  });
+
+  add("blob/find/needle_string", [] (U64 size) {
+    string src = randomString(size, "abcdefghijklmnopqrstuvwxyz");
+    return loop([src] {
+      U64 at = src.find("needle!");
+      doNotOptimize(at);
+    });
+  });
+
+  add("blob/find/byte", [] (U64 size) {
+    Blob src(randomString(size, "abcdefghijklmnopqrstuvwxyz"));
+    return loop([src] {
+      U64 at = src.findByte('!');
+      doNotOptimize(at);
+    });
+  });
+
+  add("view/split_lines", [] (U64 size) {
+    string text = randomString(size, "abcdefghijklmnopqrstuvwxyz");
+    for (U64 i = 63; i < size; i += 64) {
+      text[i] = '\n';
+    }
+    Blob src(text);
+    return loop([src] {
+      U64 fields = 0;
+      for (const Util::BlobView &line : src.view().split('\n')) {
+        fields += line.size() > 0;
+      }
+      doNotOptimize(fields);
+    });
+  });
+
+  // *** Comparison of equal Blobs in separate containers (worst case) ***
+
+  add("blob/equals/default", [] (U64 size) {
+    Blob a = randomBlob(size);
+    Blob b(a.data(), a.size());
+    return loop([a, b] {
+      bool eq = (a == b);
+      doNotOptimize(eq);
+    });
+  });
+
+  add("blob/equals/const", [] (U64 size) {
+    Blob a = randomBlob(size);
+    Blob b(a.data(), a.size(), Blob::ScrubType::NONE, Blob::CompareType::CONST);
+    Blob c(a.data(), a.size(), Blob::ScrubType::NONE, Blob::CompareType::CONST);
+    return loop([b, c] {
+      bool eq = (b == c);
+      doNotOptimize(eq);
+    });
+  });
+
+  // *** Assembling output of unknown length from 64-byte pieces ***
+
+  add("builder/append_freeze", [] (U64 size) {
+    Blob piece = randomBlob(64);
+    return loop([piece, size] {
+      Util::BlobBuilder builder;
+      for (U64 n = 0; n < size; n += 64) {
+        builder.append(piece);
+      }
+      Blob b = builder.freeze();
+      doNotOptimize(b.data());
+    });
+  });
+
+  // The alternative: a std::string copied into a Blob
+  add("builder/string_copy", [] (U64 size) {
+    Blob piece = randomBlob(64);
+    return loop([piece, size] {
+      string s;
+      for (U64 n = 0; n < size; n += 64) {
+        s.append((const char *)piece.data(), piece.size());
+      }
+      Blob b(s);
+      doNotOptimize(b.data());
+    });
+  });
+});
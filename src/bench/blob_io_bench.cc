@@ -0,0 +1,109 @@
+#include "bench/bench.h"
+#include "util/blob_io.h"
+#include "util/blob.h"
+#include <memory>
+#include <vector>
+
+using namespace Bench;
+using Util::Blob;
+
+namespace {
+
+// Varints of about 'size' bytes: mostly one and two byte values, with some
+// up to ten bytes, or only one byte values
+Blob varints(U64 size, bool small = false)
+{
+  Blob random = randomBlob(size);
+  std::vector<Byte> data(size + Util::kMaxVarintSize);
+  U64 end = 0;
+  for (U64 i = 0; end < size; i++) {
+    Byte r = random[i % random.size()];
+    U64 value = (r < 160 || small) ? (r & 0x7f) : ((r < 240) ? r * 31UL : (U64)r << (r & 63));
+    end += Util::encodeVarint(value, &data[end]);
+  }
+  return Blob(data.data(), end);
+}
+
+U64 count(const Blob &_data)
+{
+  U64 n = 0;
+  for (U64 i = 0; i < _data.size(); i++) {
+    n += (_data[i] & 0x80) == 0;
+  }
+  return n;
+}
+
+} // anonymous namespace
+
+static const Registrar registrar([] {
+
+  // *** Decoding a message of varints ***
+
+  add("blob_io/varints/batch", [] (U64 size) {
+    Blob src = varints(size);
+    std::shared_ptr<std::vector<U64>> out = std::make_shared<std::vector<U64>>(count(src));
+    return loop([src, out] {
+      Util::BlobReader reader(src);
+      reader.readVarints(out->data(), out->size());
+      doNotOptimize(reader.ok());
+      clobberMemory();
+    });
+  });
+
+  add("blob_io/varints/batch_small", [] (U64 size) {
+    Blob src = varints(size, true);
+    std::shared_ptr<std::vector<U64>> out = std::make_shared<std::vector<U64>>(count(src));
+    return loop([src, out] {
+      Util::BlobReader reader(src);
+      reader.readVarints(out->data(), out->size());
+      doNotOptimize(reader.ok());
+      clobberMemory();
+    });
+  });
+
+  add("blob_io/varints/each", [] (U64 size) {
+    Blob src = varints(size);
+    std::shared_ptr<std::vector<U64>> out = std::make_shared<std::vector<U64>>(count(src));
+    return loop([src, out] {
+      Util::BlobReader reader(src);
+      for (U64 &value : *out) {
+        value = reader.readVarint();
+      }
+      doNotOptimize(reader.ok());
+      clobberMemory();
+    });
+  });
+
+  // The byte loop over operator[] which the reader replaces
+  add("blob_io/varints/bytewise", [] (U64 size) {
+    Blob src = varints(size);
+    std::shared_ptr<std::vector<U64>> out = std::make_shared<std::vector<U64>>(count(src));
+    return loop([src, out] {
+      U64 n = 0;
+      U64 value = 0;
+      U32 shift = 0;
+      for (U64 i = 0; i < src.size(); i++) {
+        value |= (U64)(src[i] & 0x7f) << shift;
+        shift += 7;
+        if ((src[i] & 0x80) == 0) {
+          (*out)[n++] = value;
+          value = 0;
+          shift = 0;
+        }
+      }
+      clobberMemory();
+    });
+  });
+
+  add("blob_io/fixed/u32", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Util::BlobReader reader(src);
+      U32 sum = 0;
+      while (reader.remaining() >= 4) {
+        sum += reader.readU32();
+      }
+      doNotOptimize(sum);
+    });
+  });
+});
@@ -0,0 +1,174 @@
+#include "bench/bench.h"
+#include "util/byte_encoders.h"
+#include "util/codec_batch.h"
+#include "util/blob.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Bench;
+using Util::Blob;
+using std::string;
+using std::unique_ptr;
+
+namespace {
+
+// The bignum codecs are quadratic in the input size
+const U64 kBignumMaxSize = 4096;
+
+// Binary output is 8x the input, so keep it within memory
+const U64 kBinMaxSize = 1UL << 27;
+
+void addEncoder(const string &name, Blob::Encoder encoder, U64 maxSize = ~0UL)
+{
+  add("encode/" + name, [encoder] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src, encoder] {
+      unique_ptr<string> s = src.data(encoder);
+      doNotOptimize(s->data());
+    });
+  }, maxSize);
+}
+
+// 'size' is the size of the decoded data; the throughput is reported in terms
+// of decoded bytes so encoders and decoders are directly comparable.
+void addDecoder(const string &name, Blob::Encoder encoder, Blob::Decoder decoder,
+  U64 maxSize = ~0UL)
+{
+  add("decode/" + name, [encoder, decoder] (U64 size) {
+    Blob src = randomBlob(size);
+    std::shared_ptr<string> encoded(src.data(encoder).release());
+    return loop([encoded, decoder] {
+      Blob b(*encoded, decoder);
+      doNotOptimize(b.data());
+    });
+  }, maxSize);
+}
+
+// The same codecs through the compile-time interface
+template<typename Codec>
+void addCodec(const string &name, U64 maxSize = ~0UL)
+{
+  add("encode_template/" + name, [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      string s = src.encode<Codec>();
+      doNotOptimize(s.data());
+    });
+  }, maxSize);
+  add("decode_template/" + name, [] (U64 size) {
+    Blob src = randomBlob(size);
+    string encoded = src.encode<Codec>();
+    return loop([encoded] {
+      Blob b = Blob::decode<Codec>(encoded);
+      doNotOptimize(b.data());
+    });
+  }, maxSize);
+}
+
+// Encoding the same Blob again, as when logging IDs, through the cache
+template<typename Codec>
+void addCached(const string &name, U64 maxSize = ~0UL)
+{
+  add("encode_cached/" + name, [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      std::shared_ptr<const string> s = src.cachedEncode<Codec>();
+      doNotOptimize(s->data());
+    });
+  }, maxSize);
+}
+
+// Comparing a Blob with its encoding: fused, and by decoding first
+template<typename Codec>
+void addEqualsEncoded(const string &name, Blob::Decoder decoder)
+{
+  add("equals_encoded/" + name, [] (U64 size) {
+    Blob src = randomBlob(size);
+    string encoded = src.encode<Codec>();
+    return loop([src, encoded] {
+      bool eq = src.equalsEncoded<Codec>(encoded, Blob::CompareType::CONST);
+      doNotOptimize(eq);
+    });
+  });
+  add("equals_decoded/" + name, [decoder] (U64 size) {
+    Blob src = randomBlob(size);
+    string encoded = src.encode<Codec>();
+    return loop([src, encoded, decoder] () mutable {
+      bool eq = (src.compare(Blob(encoded, decoder), Blob::CompareType::CONST) ==
+        Blob::Comparison::EQ);
+      doNotOptimize(eq);
+    });
+  });
+}
+
+// Encoding 'size' bytes of 32-byte IDs: in one batch, and one call each
+template<typename Codec>
+void addBatch(const string &name, Blob::Encoder encoder)
+{
+  const auto ids = [] (U64 size) {
+    Blob src = randomBlob(size < 32 ? 32 : size);
+    std::vector<Blob> blobs;
+    for (U64 offset = 0; offset + 32 <= src.size(); offset += 32) {
+      blobs.push_back(Blob(src, 32, offset));
+    }
+    return blobs;
+  };
+  add("batch/" + name, [ids] (U64 size) {
+    std::vector<Blob> blobs = ids(size);
+    std::shared_ptr<Util::EncodedBatch> batch = std::make_shared<Util::EncodedBatch>();
+    return loop([blobs, batch] {
+      batch->encode<Codec>(blobs);
+      doNotOptimize(batch->text().data());
+    });
+  }, kBignumMaxSize * 64);
+  add("batch_each/" + name, [ids, encoder] (U64 size) {
+    std::vector<Blob> blobs = ids(size);
+    return loop([blobs, encoder] {
+      for (const Blob &blob : blobs) {
+        unique_ptr<string> s = blob.data(encoder);
+        doNotOptimize(s->data());
+      }
+    });
+  }, kBignumMaxSize * 64);
+}
+
+} // anonymous namespace
+
+static const Registrar registrar([] {
+  addEncoder("string", Util::encode_string);
+  addEncoder("bin", Util::encode_bin, kBinMaxSize);
+  addEncoder("hex", Util::encode_hex);
+  addEncoder("base58", Util::encode_base58, kBignumMaxSize);
+  addEncoder("base62", Util::encode_base62, kBignumMaxSize);
+  addEncoder("base64", Util::encode_base64);
+
+  addDecoder("bin", Util::encode_bin, Util::decode_bin, kBinMaxSize);
+  addDecoder("hex", Util::encode_hex, Util::decode_hex);
+  addDecoder("base58", Util::encode_base58, Util::decode_base58, kBignumMaxSize);
+  addDecoder("base62", Util::encode_base62, Util::decode_base62, kBignumMaxSize);
+  addDecoder("base64", Util::encode_base64, Util::decode_base64);
+
+  addCodec<Util::Bin>("bin", kBinMaxSize);
+  addCodec<Util::Hex>("hex");
+  addCodec<Util::Base58>("base58", kBignumMaxSize);
+  addCodec<Util::Base62>("base62", kBignumMaxSize);
+  addCodec<Util::Base64>("base64");
+  addCodec<Util::Base64Pad>("base64_pad");
+  addCodec<Util::Base64Url>("base64_url");
+  addCodec<Util::Base64Mime>("base64_mime");
+  addCodec<Util::Base32>("base32");
+  addCodec<Util::Base32Crockford>("base32_crockford");
+  addCodec<Util::Z85>("z85");
+  addCodec<Util::Ascii85>("ascii85");
+
+  addCached<Util::Hex>("hex");
+  addCached<Util::Base58>("base58", kBignumMaxSize);
+
+  addEqualsEncoded<Util::Hex>("hex", Util::decode_hex);
+  addEqualsEncoded<Util::Base64>("base64", Util::decode_base64);
+
+  addBatch<Util::Hex>("hex", Util::encode_hex);
+  addBatch<Util::Base58>("base58", Util::encode_base58);
+  addBatch<Util::Base64>("base64", Util::encode_base64);
+});
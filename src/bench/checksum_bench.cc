@@ -0,0 +1,25 @@
+#include "bench/bench.h"
+#include "util/checksum.h"
+#include "util/blob.h"
+
+using namespace Bench;
+using Util::Blob;
+
+static const Registrar registrar([] {
+
+  add("checksum/crc32c", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      doNotOptimize(Util::crc32c(src.data(), src.size()));
+    });
+  });
+
+  // Verifying a Blob again after the first checksum is cached
+  add("checksum/crc32c_cached", [] (U64 size) {
+    Blob src = randomBlob(size);
+    src.crc32c();
+    return loop([src] {
+      doNotOptimize(src.crc32c());
+    });
+  }, ~0UL, 0);
+});
@@ -0,0 +1,65 @@
+#include "bench/bench.h"
+#include "util/compression.h"
+#include "util/blob.h"
+#include <string>
+
+using namespace Bench;
+using Util::Blob;
+using Util::Lz;
+using std::string;
+
+namespace {
+
+// Words drawn at random, like the logs and markup which are typically
+// compressed (about 2.4:1 with Lz)
+Blob textBlob(U64 size)
+{
+  static const string words[] = {"blob", "container", "scrub", "view", "<tag>", "</tag>",
+    "\"key\": ", "12345", ", ", "\n", "the ", "data "};
+  Blob choices = randomBlob(size / 4 + 1);
+  string text;
+  text.reserve(size + 16);
+  for (U64 i = 0; text.size() < size; i++) {
+    text += words[choices[i % choices.size()] % 12];
+  }
+  text.resize(size);
+  return Blob(text);
+}
+
+} // anonymous namespace
+
+// Throughput is in terms of uncompressed bytes for both directions
+static const Registrar registrar([] {
+
+  add("compress/lz/text", [] (U64 size) {
+    Blob src = textBlob(size);
+    return loop([src] {
+      Blob b = Util::compress<Lz>(src);
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("compress/lz/random", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Blob b = Util::compress<Lz>(src);
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("decompress/lz/text", [] (U64 size) {
+    Blob compressed = Util::compress<Lz>(textBlob(size));
+    return loop([compressed] {
+      Blob b = Util::decompress<Lz>(compressed);
+      doNotOptimize(b.data());
+    });
+  });
+
+  add("decompress/lz/random", [] (U64 size) {
+    Blob compressed = Util::compress<Lz>(randomBlob(size));
+    return loop([compressed] {
+      Blob b = Util::decompress<Lz>(compressed);
+      doNotOptimize(b.data());
+    });
+  });
+});
@@ -0,0 +1,34 @@
+#include "bench/bench.h"
+#include "util/container.h"
+#include <memory>
+
+using namespace Bench;
+using Util::Container;
+
+static const Registrar registrar([] {
+
+  // Allocation and deallocation without a scrubber
+  add("container/alloc", [] (U64 size) {
+    return loop([size] {
+      Container c(size, Util::scrub_null);
+      doNotOptimize(c.data());
+    });
+  });
+
+  // The scrubbers alone, over a buffer that stays allocated
+  add("scrub/zeros", [] (U64 size) {
+    std::shared_ptr<Container> c = std::make_shared<Container>(size, Util::scrub_null);
+    return loop([c] {
+      Util::scrub_zeros(c->data(), c->size());
+      clobberMemory();
+    });
+  });
+
+  add("scrub/null", [] (U64 size) {
+    std::shared_ptr<Container> c = std::make_shared<Container>(size, Util::scrub_null);
+    return loop([c] {
+      Util::scrub_null(c->data(), c->size());
+      clobberMemory();
+    });
+  }, ~0UL, 0);
+});
@@ -0,0 +1,34 @@
+#include "bench/bench.h"
+#include "util/blob.h"
+#include "util/parallel_copy.h"
+#include <memory>
+#include <string>
+
+using namespace Bench;
+using Util::Blob;
+using Util::MutableBlob;
+using Util::ParallelCopy;
+
+static const Registrar registrar([] {
+
+  // Scaling with the thread count. Every size goes through the pool, so the
+  // small sizes show what a copy costs below the default threshold.
+  for (U32 threads : {1U, 2U, 4U, 8U}) {
+    add("copy/parallel/threads_" + std::to_string(threads), [threads] (U64 size) {
+      Blob src = randomBlob(size);
+      std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(size);
+      return Loop([threads, size, src, dst] (U64 iterations) {
+        U32 savedThreads = ParallelCopy::threads();
+        U64 savedThreshold = ParallelCopy::threshold();
+        ParallelCopy::threadsIs(threads);
+        ParallelCopy::thresholdIs(0);
+        for (U64 i = 0; i < iterations; i++) {
+          ParallelCopy::copy(dst->data(), src.data(), size);
+          clobberMemory();
+        }
+        ParallelCopy::threadsIs(savedThreads);
+        ParallelCopy::thresholdIs(savedThreshold);
+      });
+    });
+  }
+});
@@ -0,0 +1,35 @@
+#include "bench/bench.h"
+#include "util/blob.h"
+#include "util/shared_blob.h"
+#include <cstring>
+
+using namespace Bench;
+using Util::Blob;
+using Util::MutableBlob;
+
+static const Registrar registrar([] {
+
+  // Handing filled data to a consumer: sealing it and mapping the received
+  // descriptor, against copying it across as a pipe would (the consumer's
+  // copy alone)
+  add("shared/handoff", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      Util::SharedMutableBlob out(src.size());
+      memcpy((void *)out.data(), (const void *)src.data(), src.size());
+      Util::SharedBlob sealed = out.seal();
+      Util::SharedBlob in(sealed.fd());
+      doNotOptimize(in[in.size() - 1]);
+    });
+  });
+
+  add("shared/copy", [] (U64 size) {
+    Blob src = randomBlob(size);
+    return loop([src] {
+      MutableBlob out(src.size());
+      memcpy((void *)out.data(), (const void *)src.data(), src.size());
+      Blob in(out.data(), out.size());
+      doNotOptimize(in[in.size() - 1]);
+    });
+  });
+});
@@ -0,0 +1,73 @@
+#include "bench/bench.h"
+#include "util/transform.h"
+#include "util/blob.h"
+#include <memory>
+
+using namespace Bench;
+using Util::Blob;
+using Util::BitOp;
+using Util::MutableBlob;
+
+static const Registrar registrar([] {
+
+  // *** In place on a MutableBlob, against the scalar loops they replace ***
+
+  add("transform/xor", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(randomBlob(size));
+    Blob operand = randomBlob(size);
+    return loop([dst, operand] {
+      Util::bitwise(*dst, operand, BitOp::XOR);
+      clobberMemory();
+    });
+  });
+
+  add("transform/xor_scalar", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(randomBlob(size));
+    Blob operand = randomBlob(size);
+    return loop([dst, operand] {
+      Byte *data = dst->data();
+      for (U64 i = 0; i < operand.size(); i++) {
+        data[i] ^= operand[i];
+      }
+      clobberMemory();
+    });
+  });
+
+  add("transform/xor_key", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(randomBlob(size));
+    Blob key = randomBlob(13);
+    return loop([dst, key] {
+      Util::bitwiseRepeating(*dst, key, BitOp::XOR);
+      clobberMemory();
+    });
+  });
+
+  add("transform/byte_swap_32", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(randomBlob(size));
+    return loop([dst] {
+      Util::byteSwap(*dst, 4);
+      clobberMemory();
+    });
+  });
+
+  add("transform/translate", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(randomBlob(size));
+    Blob table = randomBlob(256);
+    return loop([dst, table] {
+      Util::translate(*dst, table.data());
+      clobberMemory();
+    });
+  });
+
+  add("transform/translate_scalar", [] (U64 size) {
+    std::shared_ptr<MutableBlob> dst = std::make_shared<MutableBlob>(randomBlob(size));
+    Blob table = randomBlob(256);
+    return loop([dst, table] {
+      Byte *data = dst->data();
+      for (U64 i = 0; i < dst->size(); i++) {
+        data[i] = table[data[i]];
+      }
+      clobberMemory();
+    });
+  });
+});
@@ -1,26 +1,54 @@
 #include "util/blob.h"
-#include "util/compare.h"
+#include "util/checksum.h"
+#include "util/codec_stats.h"
+#include "util/dispatch.h"
+#include "util/parallel_copy.h"
 #include <cstring>  // XXX del
+#include <type_traits>
 
 using namespace Util;
 using std::string;
 using std::unique_ptr;
 using std::make_shared;
 
+namespace {
+
+// A deleter for an adopted std::string or std::vector. The container's
+// scrubber covers the data; spare capacity past it may hold earlier contents,
+// so with scrubbing that is zeroed here.
+template<typename T>
+Container::ReleaseType ownerDeleter(T *_owned, bool _scrub)
+{
+  return [_owned, _scrub] (Byte *, U64) {
+    U64 size = _owned->size();
+    if (_scrub && (_owned->capacity() > size)) {
+      _owned->resize(_owned->capacity());
+      scrub_zeros((Byte *)&(*_owned)[size], _owned->size() - size);
+    }
+    delete _owned;
+  };
+}
+
+} // anonymous namespace
+
+const U64 Blob::kNotFound;
+const U64 Blob::kCopyBelow;
+
 Blob::Blob(U64 _size, ScrubType _scrubType, Blob::CompareType _compareType)
   : container_(make_shared<Container>(_size, scrubberForType(_scrubType))), scrubType_(_scrubType),
-  compareType_(_compareType), comparator_(comparatorForType(_compareType)),
+  compareType_(_compareType),
   data_(container_->data()), size_(container_->size())
 {
-  // empty
+  attach();
 }
 
 Blob::Blob(const Byte *_stream, U64 _size, ScrubType _scrubType, Blob::CompareType _compareType)
   : container_(make_shared<Container>(_size, scrubberForType(_scrubType))),
-  scrubType_(_scrubType), compareType_(_compareType), comparator_(comparatorForType(_compareType)),
+  scrubType_(_scrubType), compareType_(_compareType),
   data_(container_->data()), size_(container_->size())
 {
-  memcpy((void *)container_->data(), (const void *)_stream, container_->size());
+  ParallelCopy::copy(container_->data(), _stream, container_->size());
+  attach();
 }
 
 Blob::Blob(const char *_stream, U64 _size, ScrubType _scrubType, Blob::CompareType _compareType)
@@ -31,7 +59,7 @@ Blob::Blob(const char *_stream, U64 _size, ScrubType _scrubType, Blob::CompareTy
 
 Blob::Blob(const Blob &_other, U64 _size, U64 _offset)
   : container_(_other.container_), scrubType_(_other.scrubType_),
-  comparator_(_other.comparator_), data_(nullptr), size_(0)
+  compareType_(_other.compareType_), data_(nullptr), size_(0)
 {
   // Sanitize inputs to prevent integer and buffer overflow opportunities
   // (only possible when copying Blobs; no way to know with Byte* buffers).
@@ -43,11 +71,18 @@ Blob::Blob(const Blob &_other, U64 _size, U64 _offset)
   }
   data_ = &(_other.data_[_offset]);
   size_ = _size;
+  attach();
 }
 
 Blob::Blob(const Byte *_data, U64 _size, Decoder _decoder)
 {
+#ifdef UTIL_CODEC_STATS
+  CodecCall call(_decoder.target_type(), true, _size);
+  unique_ptr<Blob> b = _decoder(_data, _size);
+  call.finish(b->size());
+#else
   unique_ptr<Blob> b = _decoder(_data, _size);
+#endif
   *this = std::move(*b);
 }
 
@@ -63,8 +98,89 @@ Blob::Blob(const string &_data, Decoder _decoder)
   // empty
 }
 
+// Adopt a buffer, which 'deleter' frees after scrubbing
+Blob::Blob(Byte *_data, U64 _size, ScrubType _scrubType, Blob::CompareType _compareType,
+  Deleter _deleter)
+  : Blob(make_shared<Container>(_data, _size, scrubberForType(_scrubType), _deleter), _scrubType,
+    _compareType)
+{
+  // empty
+}
+
+// Adopt the string's buffer. Short strings are copied instead (and the
+// original scrubbed): those kept within the string object itself must be,
+// and for the rest a copy costs little next to the allocations adopting
+// takes, and sizes the Blob's one allocation to the data rather than to the
+// string's capacity.
+Blob::Blob(string &&_data, ScrubType _scrubType, Blob::CompareType _compareType)
+  : container_(), scrubType_(_scrubType), compareType_(_compareType), data_(nullptr), size_(0)
+{
+  const char *begin = (const char *)&_data;
+  bool local = (_data.data() >= begin) && (_data.data() < begin + sizeof(_data));
+  if (local || (_data.size() < kCopyBelow)) {
+    dataIs(_data.data(), _data.size(), _scrubType, _compareType);
+    if (_scrubType != ScrubType::NONE) {
+      _data.resize(_data.capacity());
+      scrub_zeros((Byte *)&_data[0], _data.size());
+    }
+    _data.clear();
+    return;
+  }
+  unique_ptr<string> owned(new string(std::move(_data)));
+  container_ = make_shared<Container>((Byte *)&(*owned)[0], owned->size(),
+    scrubberForType(_scrubType), ownerDeleter(owned.get(), _scrubType != ScrubType::NONE));
+  owned.release();
+  data_ = container_->data();
+  size_ = container_->size();
+  attach();
+}
+
+Blob::Blob(std::vector<Byte> &&_data, ScrubType _scrubType, Blob::CompareType _compareType)
+  : container_(), scrubType_(_scrubType), compareType_(_compareType), data_(nullptr), size_(0)
+{
+  unique_ptr<std::vector<Byte>> owned(new std::vector<Byte>(std::move(_data)));
+  container_ = make_shared<Container>(owned->data(), owned->size(), scrubberForType(_scrubType),
+    ownerDeleter(owned.get(), _scrubType != ScrubType::NONE));
+  owned.release();
+  data_ = container_->data();
+  size_ = container_->size();
+  attach();
+}
+
+// Share an existing container, such as one adopting memory allocated
+// elsewhere. 'scrubType' describes what the container's scrubber does.
+Blob::Blob(std::shared_ptr<Container> _container, ScrubType _scrubType, Blob::CompareType _compareType)
+  : container_(_container), scrubType_(_scrubType), compareType_(_compareType),
+  data_(container_->data()), size_(container_->size())
+{
+  attach();
+}
+
+// Copy the viewed data into a new Blob with the view's scrub and compare types
+Blob::Blob(const BlobView &_view)
+  : Blob(_view.data(), _view.size(), _view.scrubType(), _view.compareType())
+{
+  // empty
+}
+
+// Share the owner's data when the view lies within it; otherwise copy
+Blob::Blob(const Blob &_owner, const BlobView &_view)
+  : Blob(_owner, 0, 0)
+{
+  if ((_view.data() >= _owner.data_) && (_view.size() <= _owner.size_) &&
+      ((U64)(_view.data() - _owner.data_) <= _owner.size_ - _view.size())) {
+    detach();
+    data_ = _view.data();
+    size_ = _view.size();
+    attach();
+  }
+  else {
+    *this = Blob(_view.data(), _view.size(), _owner.scrubType_, _owner.compareType_);
+  }
+}
+
 Blob::Blob(std::initializer_list<Blob> _blobs, ScrubType _scrubType, Blob::CompareType _compareType)
-  : container_(), scrubType_(_scrubType), compareType_(_compareType), comparator_(comparatorForType(_compareType)),
+  : container_(), scrubType_(_scrubType), compareType_(_compareType),
   data_(nullptr), size_(0)
 {
   // Determine the aggregate size of all Blobs
@@ -78,48 +194,28 @@ Blob::Blob(std::initializer_list<Blob> _blobs, ScrubType _scrubType, Blob::Compa
   data_ = mdata;
   U64 offset = 0;
   for (auto blob : _blobs) {
-    memcpy((void *)&(mdata[offset]), blob.data(), blob.size());
+    ParallelCopy::copy(&mdata[offset], blob.data(), blob.size());
     offset += blob.size();
   }
+  attach();
 }
 
-bool Blob::operator==(const Blob &_other) const
-{
-  return !operator!=(_other);
-}
 
-bool Blob::operator!=(const Blob &_other) const
+Blob::Comparison Blob::compare(const Blob &_other, CompareType _compareType) const
 {
-  // Two Blobs are equal when their data is equal, even if from
-  // separate data streams
-  return comparator_(*this, _other);
-}
-
-const Byte &Blob::operator[](U64 _index) const
-{
-  return data_[_index];
-}
-
-Blob::Comparison Blob::compare(const Blob &_other, CompareType _compareType)
-{
-  Comparator cmp = comparatorForType(_compareType);
-  if (cmp(*this, _other)) {
-    return Comparison::NE;
-  }
-  else {
-    return Comparison::EQ;
-  }
+  return view().compare(_other.view(), _compareType);
 }
 
 void Blob::dataIs(const Byte *_stream, U64 _size, ScrubType _scrubType, Blob::CompareType _compareType)
 {
+  detach();
   container_ = make_shared<Container>(_size, scrubberForType(_scrubType));
   scrubType_ = _scrubType;
   compareType_ = _compareType;
-  comparator_ = comparatorForType(_compareType);
   data_ = container_->data();
   size_ = container_->size();
-  memcpy((void *)container_->data(), (const void *)_stream, container_->size());
+  ParallelCopy::copy(container_->data(), _stream, container_->size());
+  attach();
 }
 
 void Blob::dataIs(const char *_stream, U64 _size, ScrubType _scrubType, Blob::CompareType _compareType)
@@ -127,38 +223,84 @@ void Blob::dataIs(const char *_stream, U64 _size, ScrubType _scrubType, Blob::Co
   dataIs((const Byte *)_stream, _size, _scrubType, _compareType);
 }
 
+void Blob::dataIs(string &&_data, ScrubType _scrubType, Blob::CompareType _compareType)
+{
+  *this = Blob(std::move(_data), _scrubType, _compareType);
+}
+
+void Blob::dataIs(std::vector<Byte> &&_data, ScrubType _scrubType, Blob::CompareType _compareType)
+{
+  *this = Blob(std::move(_data), _scrubType, _compareType);
+}
+
 void Blob::dataIsNull()
 {
+  detach();
   container_ = make_shared<Container>(0, scrubberForType(ScrubType::NONE));
   scrubType_ = ScrubType::NONE;
-  comparator_ = comparatorForType(Blob::CompareType::DEFAULT);
+  compareType_ = CompareType::DEFAULT;
   data_ = nullptr;
   size_ = 0;
+  attach();
 }
 
-const Byte *Blob::data() const
+// Copy the data into a container of its own when it uses less than
+// 'threshold' (a fraction, e.g. 0.01 for 1%) of the container it refers to,
+// releasing this Blob's hold on the rest. Returns true if the data was copied.
+bool Blob::compact(double _threshold)
 {
-  return data_;
+  if (!container_ || ((double)size_ >= _threshold * (double)container_->size())) {
+    return false;
+  }
+  *this = Blob(data_, size_, scrubType_, compareType_);
+  return true;
 }
 
 unique_ptr<string> Blob::data(Encoder _encoder) const
 {
+#ifdef UTIL_CODEC_STATS
+  CodecCall call(_encoder.target_type(), false, size_);
+  unique_ptr<string> s = _encoder(data_, size_);
+  call.finish(s->size());
+  return s;
+#else
   return _encoder(data_, size_);
+#endif
 }
 
-U64 Blob::size() const
+// Only a Blob spanning its whole container, which no MutableBlob can still
+// write, uses (and fills) the caches
+bool Blob::cacheable() const
 {
-  return size_;
+  return container_ && (data_ == container_->data()) && (size_ == container_->size()) &&
+    !container_->writable();
 }
 
-Blob::ScrubType Blob::scrubType() const
+U32 Blob::crc32c() const
 {
-  return scrubType_;
+  if (!cacheable()) {
+    return view().crc32c();
+  }
+  U32 crc;
+  if (!container_->checksum(&crc)) {
+    crc = view().crc32c();
+    container_->checksumIs(crc);
+  }
+  return crc;
 }
 
-Blob::CompareType Blob::compareType() const
+std::shared_ptr<const string> Blob::cached(const std::type_info &_codec,
+  const std::function<string()> &_encode) const
 {
-  return compareType_;
+  bool scrub = (scrubType_ != ScrubType::NONE);
+  if (!cacheable()) {
+    return Container::encodingOf(_encode(), scrub);
+  }
+  Container::Encoding text = container_->encoding(_codec);
+  if (!text) {
+    text = container_->encodingIs(_codec, _encode(), scrub);
+  }
+  return text;
 }
 
 Container::ScrubType Blob::scrubberForType(ScrubType _scrubType)
@@ -168,18 +310,8 @@ Container::ScrubType Blob::scrubberForType(ScrubType _scrubType)
     return scrub_zeros;
   }
   else {
-    // An empty lambda for ScrubType::NONE
-    return scrub_null;
-  }
-}
-
-Blob::Comparator Blob::comparatorForType(Blob::CompareType _compareType)
-{
-  if (_compareType == Blob::CompareType::DEFAULT) {
-    return compare_memcmp;
-  }
-  else {
-    return compare_constant;
+    // No scrubber for ScrubType::NONE (the Container skips the call)
+    return Container::ScrubType();
   }
 }
 
@@ -189,13 +321,13 @@ Blob::Comparator Blob::comparatorForType(Blob::CompareType _compareType)
 MutableBlob::MutableBlob(U64 _size, ScrubType _scrubType, Blob::CompareType _compareType)
   : Blob(_size, _scrubType, _compareType)
 {
-  // empty
+  writerIs(container_);
 }
 
 MutableBlob::MutableBlob(const Byte *_stream, U64 _size, ScrubType _scrubType, Blob::CompareType _compareType)
   : Blob(_stream, _size, _scrubType, _compareType)
 {
-  // empty
+  writerIs(container_);
 }
 
 MutableBlob::MutableBlob(const Blob &_other, ScrubType _scrubType, Blob::CompareType _compareType)
@@ -204,13 +336,149 @@ MutableBlob::MutableBlob(const Blob &_other, ScrubType _scrubType, Blob::Compare
   // empty
 }
 
-Byte &MutableBlob::operator[](U64 _index)
+MutableBlob::MutableBlob(MutableBlob &&_other)
+  : Blob(std::move(_other)), writing_(std::move(_other.writing_))
+{
+  // empty
+}
+
+MutableBlob &MutableBlob::operator=(MutableBlob &&_other)
+{
+  if (this != &_other) {
+    writerIs(nullptr);
+    Blob::operator=(std::move(_other));
+    writing_ = std::move(_other.writing_);
+  }
+  return *this;
+}
+
+MutableBlob::~MutableBlob()
 {
-  return container_->data()[_index];
+  writerIs(nullptr);
 }
 
-Byte *MutableBlob::data()
+void MutableBlob::dataIs(const Byte *_stream, U64 _size, ScrubType _scrubType,
+  Blob::CompareType _compareType)
 {
-  return container_->data();
+  Blob::dataIs(_stream, _size, _scrubType, _compareType);
+  writerIs(container_);
 }
 
+void MutableBlob::dataIs(const char *_stream, U64 _size, ScrubType _scrubType,
+  Blob::CompareType _compareType)
+{
+  Blob::dataIs(_stream, _size, _scrubType, _compareType);
+  writerIs(container_);
+}
+
+void MutableBlob::dataIs(std::string &&_data, ScrubType _scrubType, Blob::CompareType _compareType)
+{
+  Blob::dataIs(std::move(_data), _scrubType, _compareType);
+  writerIs(container_);
+}
+
+void MutableBlob::dataIs(std::vector<Byte> &&_data, ScrubType _scrubType,
+  Blob::CompareType _compareType)
+{
+  Blob::dataIs(std::move(_data), _scrubType, _compareType);
+  writerIs(container_);
+}
+
+void MutableBlob::dataIsNull()
+{
+  Blob::dataIsNull();
+  writerIs(nullptr);
+}
+
+bool MutableBlob::compact(double _threshold)
+{
+  bool compacted = Blob::compact(_threshold);
+  writerIs(container_);
+  return compacted;
+}
+
+void MutableBlob::containerIs(std::shared_ptr<Container> _container)
+{
+  Blob::operator=(Blob(_container, scrubType_, compareType_));
+  writerIs(container_);
+}
+
+// Hand the data back to the readers' caches once this object can no longer
+// write it, and keep them off the new data until it can't either
+void MutableBlob::writerIs(std::shared_ptr<Container> _container)
+{
+  if (writing_ == _container) {
+    return;
+  }
+  if (writing_) {
+    writing_->writableIs(false);
+  }
+  writing_ = std::move(_container);
+  if (writing_) {
+    writing_->writableIs(true);
+  }
+}
+
+// BlobView
+
+static_assert(std::is_trivially_copyable<BlobView>::value, "BlobView must be trivially copyable");
+
+// Views of different sizes are never equal. CompareType::CONST compares all
+// bytes of equally sized views regardless of where they differ.
+Blob::Comparison BlobView::compare(const BlobView &_other, Blob::CompareType _compareType) const
+{
+  bool equal = (size_ == _other.size_);
+  if (equal && (size_ != 0)) {
+    if (_compareType == Blob::CompareType::CONST) {
+      equal = (constantDifference(data_, _other.data_, size_) == 0);
+    }
+    else {
+      equal = (memcmp((const void *)data_, (const void *)_other.data_, size_) == 0);
+    }
+  }
+  return equal ? Blob::Comparison::EQ : Blob::Comparison::NE;
+}
+
+unique_ptr<string> BlobView::data(Blob::Encoder _encoder) const
+{
+#ifdef UTIL_CODEC_STATS
+  CodecCall call(_encoder.target_type(), false, size_);
+  unique_ptr<string> s = _encoder(data_, size_);
+  call.finish(s->size());
+  return s;
+#else
+  return _encoder(data_, size_);
+#endif
+}
+
+U32 BlobView::crc32c() const
+{
+  return Util::crc32c(data_, size_);
+}
+
+bool Util::operator==(const BlobView &_a, const BlobView &_b)
+{
+  return _a.compare(_b, _a.compareType()) == Blob::Comparison::EQ;
+}
+
+bool Util::operator!=(const BlobView &_a, const BlobView &_b)
+{
+  return _a.compare(_b, _a.compareType()) == Blob::Comparison::NE;
+}
+
+// The OR of the differences of all bytes, in time dependent only on 'size'
+UTIL_TARGET_CLONES U64 BlobView::constantDifference(const Byte *_a, const Byte *_b, U64 _size)
+{
+  U64 result = 0;
+  U64 i = 0;
+  for (; i + 8 <= _size; i += 8) {
+    U64 a, b;
+    memcpy((void *)&a, (const void *)&_a[i], 8);
+    memcpy((void *)&b, (const void *)&_b[i], 8);
+    result |= a ^ b;
+  }
+  for (; i < _size; i++) {
+    result |= (U64)(_a[i] ^ _b[i]);
+  }
+  return result;
+}
@@ -1,12 +1,19 @@
 #ifndef UTIL_BLOB_H
 #define UTIL_BLOB_H
 
+#include "util/codec.h"
 #include "util/container.h"
 #include "util/fixed_types.h"
+#include "util/search.h"
 #include <initializer_list>
 #include <functional>
 #include <string>
 #include <memory>
+#include <type_traits>
+#include <typeinfo>
+#include <cstring>
+#include <iterator>
+#include <vector>
 
 namespace Util {
 
@@ -25,7 +32,10 @@ namespace Util {
    - A Blob is read-only, and a MutableBlob is readable and writeable.
    - If a Blob is created from a raw pointer to data, the data will be copied.
      Otherwise if it's created from another Blob then none of the underlying
-     data will be copied.
+     data will be copied. A Blob can also adopt a buffer without copying it:
+     a raw pointer with a deleter, or a std::string (of at least kCopyBelow
+     bytes) or std::vector<Byte> moved into it. Adopted data is scrubbed (if
+     required) before release.
    - Blobs can be created as arbitrary subsets of existing Blobs without copying
      any underlying data.
    - The deletion of any Blob cannot affect any other Blob, even when Blobs are
@@ -38,8 +48,35 @@ namespace Util {
    - Blobs support clearing their data upon deallocation. This is enabled by
      setting the 'ScrubType' to something other than 'NONE' upon construction. All
      Blobs which are created from existing Blobs inherit this property.
+   - A BlobView is a non-owning pointer and size with the same read API. It is
+     trivially copyable and slices without touching any reference count, for
+     data which only needs to live as long as the Blob it was taken from. A view
+     is promoted explicitly to an owning Blob when it has to outlive it.
+   - crc32c() checksums the data. The checksum of a Blob spanning all of its
+     data is cached with the data, so verifying it again costs nothing. Data
+     is only cached once no MutableBlob can write it any more, so writing
+     costs nothing extra and a pointer kept for writing never sees a stale
+     checksum.
+   - cachedEncode<Codec>() and cachedData(encoder) cache the text encoding
+     of a Blob spanning all of its data with the data, one per codec, so
+     logging the same IDs again costs nothing. The text is shared and
+     immutable, and like the checksum only cached once the data is.
+   - A slice keeps all of its parent's data alive. compact() copies a slice
+     which uses little of that data, so the rest can be freed, and
+     Container::pinning() finds the containers pinned this way.
+   - find(), rfind() and findByte() search the data without copying it, and
+     split() iterates over the fields between delimiters as slices, finding
+     each one only when the iterator reaches it:
+
+       for (const Util::BlobView &line : records.view().split('\n')) {
+         Util::U64 tab = line.findByte('\t');
+         ...
+       }
 */
 
+class BlobView;
+template<typename T> class Split;
+
 class Blob
 {
  public:
@@ -55,9 +92,18 @@ class Blob
   {
     EQ, NE
   };
+  // True when not equal, like compare_memcmp and compare_constant (compare.h)
   typedef std::function<bool(const Blob &a, const Blob &b)> Comparator;
   typedef std::function<std::unique_ptr<std::string>(const Byte *data, U64 size)> Encoder;
   typedef std::function<std::unique_ptr<Blob>(const Byte *data, U64 size)> Decoder;
+  typedef Container::ReleaseType Deleter;
+
+  // Returned by the searches when there is no match
+  static const U64 kNotFound = ~0UL;
+
+  // Strings moved into a Blob which are shorter than this are copied rather
+  // than adopted
+  static const U64 kCopyBelow = 256;
 
  public:
   Blob(U64 size = 0, ScrubType scrubType = ScrubType::NONE,
@@ -70,34 +116,77 @@ class Blob
   Blob(const Byte *data, U64 size, Decoder decoder);
   Blob(const std::string &data);
   Blob(const std::string &data, Decoder decoder);
+  Blob(Byte *data, U64 size, ScrubType scrubType, CompareType compareType, Deleter deleter);
+  Blob(std::string &&data, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  Blob(std::vector<Byte> &&data, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
   Blob(std::initializer_list<Blob> blobs, ScrubType scrubType = ScrubType::NONE,
     CompareType compareType = CompareType::DEFAULT);
-  Blob(const Blob &) = default;
-  Blob(Blob &&) = default;
-  Blob &operator=(const Blob &) = default;
-  Blob &operator=(Blob &&) = default;
+  explicit Blob(std::shared_ptr<Container> container, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  explicit Blob(const BlobView &view);
+  Blob(const Blob &owner, const BlobView &view);
+  Blob(const Blob &other);
+  Blob(Blob &&other) noexcept;
+  Blob &operator=(const Blob &other);
+  Blob &operator=(Blob &&other) noexcept;
+  ~Blob();
   bool operator==(const Blob &other) const;
   bool operator!=(const Blob &other) const;
   const Byte &operator[](U64 index) const;
-  Comparison compare(const Blob &other, CompareType compareType);
+  Comparison compare(const Blob &other, CompareType compareType) const;
   void dataIs(const Byte *stream, U64 size, ScrubType scrubType = ScrubType::NONE,
     CompareType compareType = CompareType::DEFAULT);
   void dataIs(const char *stream, U64 size, ScrubType scrubType = ScrubType::NONE,
     CompareType compareType = CompareType::DEFAULT);
+  void dataIs(std::string &&data, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  void dataIs(std::vector<Byte> &&data, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
   void dataIsNull();
+  bool compact(double threshold);
   const Byte *data() const;
   std::unique_ptr<std::string> data(Encoder encoder) const;
+  template<typename F> std::shared_ptr<const std::string> cachedData(const F &encoder) const;
+  BlobView view() const;
+  template<typename Codec> std::string encode() const;
+  template<typename Codec, typename Sink> void encode(Sink &sink) const;
+  template<typename Codec> std::shared_ptr<const std::string> cachedEncode() const;
+  template<typename Codec> static Blob decode(const Byte *data, U64 size,
+    ScrubType scrubType = ScrubType::NONE, CompareType compareType = CompareType::DEFAULT);
+  template<typename Codec> static Blob decode(const std::string &data,
+    ScrubType scrubType = ScrubType::NONE, CompareType compareType = CompareType::DEFAULT);
+  template<typename Codec> static DecodeStatus tryDecode(const Byte *data, U64 size, Blob &out,
+    ScrubType scrubType = ScrubType::NONE, CompareType compareType = CompareType::DEFAULT);
+  template<typename Codec> static DecodeStatus tryDecode(const std::string &data, Blob &out,
+    ScrubType scrubType = ScrubType::NONE, CompareType compareType = CompareType::DEFAULT);
+  template<typename Codec> bool equalsEncoded(const Byte *text, U64 size,
+    CompareType compareType) const;
+  template<typename Codec> bool equalsEncoded(const std::string &text,
+    CompareType compareType) const;
+  template<typename Codec> bool equalsEncoded(const std::string &text, Codec codec,
+    CompareType compareType) const;
+  U32 crc32c() const;
+  U64 find(const BlobView &needle, U64 from = 0) const;
+  U64 rfind(const BlobView &needle, U64 before = kNotFound) const;
+  U64 findByte(Byte byte, U64 from = 0) const;
+  Split<Blob> split(Byte delimiter) const;
+  Split<Blob> split(const BlobView &delimiter) const;
   U64 size() const;
   ScrubType scrubType() const;
   CompareType compareType() const;
 
  protected:
   static Container::ScrubType scrubberForType(ScrubType scrubType);
-  static Comparator comparatorForType(CompareType compareType);
+  bool cacheable() const;
+  std::shared_ptr<const std::string> cached(const std::type_info &codec,
+    const std::function<std::string()> &encode) const;
+  void attach();
+  void detach();
   std::shared_ptr<Container> container_;
   ScrubType scrubType_;
   CompareType compareType_;
-  Comparator comparator_;
   const Byte *data_;
   U64 size_;
 };
@@ -112,13 +201,687 @@ class MutableBlob : public Blob
   MutableBlob(const Blob &other, ScrubType scrubType = ScrubType::NONE,
     CompareType compareType = CompareType::DEFAULT);
   MutableBlob(const MutableBlob &) = delete;
-  MutableBlob(MutableBlob &&) = default;
+  MutableBlob(MutableBlob &&other);
   MutableBlob &operator=(const MutableBlob &) = delete;
-  MutableBlob &operator=(MutableBlob &&) = default;
+  MutableBlob &operator=(MutableBlob &&other);
+  ~MutableBlob();
   Byte &operator[](U64 index);
   Byte *data();
+
+  // The Blob methods which replace the data, writing the new data instead
+  void dataIs(const Byte *stream, U64 size, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  void dataIs(const char *stream, U64 size, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  void dataIs(std::string &&data, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  void dataIs(std::vector<Byte> &&data, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  void dataIsNull();
+  bool compact(double threshold);
+
+ protected:
+  // For subclasses which allocate the data themselves (see shared_blob.h)
+  void containerIs(std::shared_ptr<Container> container);
+
+ private:
+  void writerIs(std::shared_ptr<Container> container);
+
+  // The container this MutableBlob writes, held apart from the data so that
+  // moving the data into a Blob leaves it to this object's lifetime
+  std::shared_ptr<Container> writing_;
+};
+
+// A view must not outlive the data it was taken from; a view of a Blob stays
+// valid while any Blob sharing that Blob's data exists
+class BlobView
+{
+ public:
+  BlobView();
+  BlobView(const Byte *data, U64 size, Blob::ScrubType scrubType = Blob::ScrubType::NONE,
+    Blob::CompareType compareType = Blob::CompareType::DEFAULT);
+  BlobView(const Blob &blob);
+  BlobView(const BlobView &other, U64 size, U64 offset = 0);
+  BlobView(const BlobView &) = default;
+  BlobView &operator=(const BlobView &) = default;
+  const Byte &operator[](U64 index) const;
+  Blob::Comparison compare(const BlobView &other, Blob::CompareType compareType) const;
+  const Byte *data() const;
+  std::unique_ptr<std::string> data(Blob::Encoder encoder) const;
+  template<typename Codec> std::string encode() const;
+  template<typename Codec, typename Sink> void encode(Sink &sink) const;
+  template<typename Codec> bool equalsEncoded(const Byte *text, U64 size,
+    Blob::CompareType compareType) const;
+  template<typename Codec> bool equalsEncoded(const std::string &text,
+    Blob::CompareType compareType) const;
+  template<typename Codec> bool equalsEncoded(const std::string &text, Codec codec,
+    Blob::CompareType compareType) const;
+  U32 crc32c() const;
+  U64 find(const BlobView &needle, U64 from = 0) const;
+  U64 rfind(const BlobView &needle, U64 before = Blob::kNotFound) const;
+  U64 findByte(Byte byte, U64 from = 0) const;
+  Split<BlobView> split(Byte delimiter) const;
+  Split<BlobView> split(const BlobView &delimiter) const;
+  U64 size() const;
+  Blob::ScrubType scrubType() const;
+  Blob::CompareType compareType() const;
+
+ private:
+  static U64 constantDifference(const Byte *a, const Byte *b, U64 size);
+  const Byte *data_;
+  U64 size_;
+  Blob::ScrubType scrubType_;
+  Blob::CompareType compareType_;
 };
 
+// Views compare with the left operand's compare type. As non-members they
+// also compare a Blob with a view on either side.
+bool operator==(const BlobView &a, const BlobView &b);
+bool operator!=(const BlobView &a, const BlobView &b);
+
+// The fields of a Blob or BlobView between delimiters, as a forward range.
+// Each field is found when the iterator reaches it, so nothing is allocated:
+// a Split<BlobView> yields views, and a Split<Blob> yields Blobs sharing the
+// source's data. Empty fields are kept, so 'n' delimiters separate 'n + 1'
+// fields. An empty delimiter yields the whole source. A multi-byte delimiter
+// is not copied and must outlive the iteration.
+template<typename T>
+class Split
+{
+ public:
+  class Iterator
+  {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    Iterator();
+    const T &operator*() const;
+    const T *operator->() const;
+    Iterator &operator++();
+    Iterator operator++(int);
+    bool operator==(const Iterator &other) const;
+    bool operator!=(const Iterator &other) const;
+
+   private:
+    friend class Split;
+    Iterator(const Split *split, U64 offset);
+    void findField();
+    const Split *split_;
+    U64 offset_;  // where the current field starts; kNotFound at the end
+    U64 next_;    // where the following field starts; kNotFound after the last
+    T field_;
+  };
+
+  Split(const T &source, Byte delimiter);
+  Split(const T &source, const BlobView &delimiter);
+  Iterator begin() const;
+  Iterator end() const;
+
+ private:
+  T source_;
+  Byte byte_;
+  BlobView delimiter_;  // empty for a single byte delimiter, held in 'byte_'
+  bool single_;
+};
+
+
+// Each Blob reports the bytes of its container it refers to, for
+// Container::pinning(), when the library was built to collect them. The
+// special members are inline for the common build, which only pays for the
+// test of the flag.
+inline void Blob::attach()
+{
+  if (Container::kPinning && container_) {
+    container_->attach(size_);
+  }
+}
+
+inline void Blob::detach()
+{
+  if (Container::kPinning && container_) {
+    container_->detach(size_);
+  }
+}
+
+inline Blob::Blob(const Blob &_other)
+  : container_(_other.container_), scrubType_(_other.scrubType_),
+  compareType_(_other.compareType_), data_(_other.data_), size_(_other.size_)
+{
+  attach();
+}
+
+// The reference moves with the container, so the counts are unchanged
+inline Blob::Blob(Blob &&_other) noexcept
+  : container_(std::move(_other.container_)), scrubType_(_other.scrubType_),
+  compareType_(_other.compareType_), data_(_other.data_), size_(_other.size_)
+{
+  // empty
+}
+
+inline Blob &Blob::operator=(const Blob &_other)
+{
+  if (this != &_other) {
+    detach();
+    container_ = _other.container_;
+    scrubType_ = _other.scrubType_;
+    compareType_ = _other.compareType_;
+    data_ = _other.data_;
+    size_ = _other.size_;
+    attach();
+  }
+  return *this;
+}
+
+inline Blob &Blob::operator=(Blob &&_other) noexcept
+{
+  if (this != &_other) {
+    detach();
+    container_ = std::move(_other.container_);
+    scrubType_ = _other.scrubType_;
+    compareType_ = _other.compareType_;
+    data_ = _other.data_;
+    size_ = _other.size_;
+  }
+  return *this;
+}
+
+inline Blob::~Blob()
+{
+  detach();
+}
+
+
+// The accessors are inline so that loops over a Blob's bytes compile to
+// loops over a pointer, also when linking with the shared library
+
+inline bool Blob::operator==(const Blob &_other) const
+{
+  return !operator!=(_other);
+}
+
+inline bool Blob::operator!=(const Blob &_other) const
+{
+  // Two Blobs are equal when their data is equal, even if from
+  // separate data streams
+  return view() != _other.view();
+}
+
+inline const Byte &Blob::operator[](U64 _index) const
+{
+  return data_[_index];
+}
+
+inline const Byte *Blob::data() const
+{
+  return data_;
+}
+
+inline BlobView Blob::view() const
+{
+  return BlobView(data_, size_, scrubType_, compareType_);
+}
+
+inline U64 Blob::size() const
+{
+  return size_;
+}
+
+inline Blob::ScrubType Blob::scrubType() const
+{
+  return scrubType_;
+}
+
+inline Blob::CompareType Blob::compareType() const
+{
+  return compareType_;
+}
+
+inline Byte &MutableBlob::operator[](U64 _index)
+{
+  return container_->data()[_index];
+}
+
+inline Byte *MutableBlob::data()
+{
+  return container_->data();
+}
+
+
+// BlobView construction and accessors are inline so views cost no more than
+// a pointer and size
+
+inline BlobView::BlobView()
+  : data_(nullptr), size_(0), scrubType_(Blob::ScrubType::NONE),
+  compareType_(Blob::CompareType::DEFAULT)
+{
+  // empty
+}
+
+inline BlobView::BlobView(const Byte *_data, U64 _size, Blob::ScrubType _scrubType,
+  Blob::CompareType _compareType)
+  : data_(_data), size_(_size), scrubType_(_scrubType), compareType_(_compareType)
+{
+  // empty
+}
+
+inline BlobView::BlobView(const Blob &_blob)
+  : data_(_blob.data()), size_(_blob.size()), scrubType_(_blob.scrubType()),
+  compareType_(_blob.compareType())
+{
+  // empty
+}
+
+inline BlobView::BlobView(const BlobView &_other, U64 _size, U64 _offset)
+  : data_(nullptr), size_(0), scrubType_(_other.scrubType_), compareType_(_other.compareType_)
+{
+  // Sanitize inputs as for Blob slices
+  if (_offset > _other.size_) {
+    _offset = _other.size_;
+  }
+  if (_size > (_other.size_ - _offset)) {
+    _size = _other.size_ - _offset;
+  }
+  data_ = &(_other.data_[_offset]);
+  size_ = _size;
+}
+
+inline const Byte &BlobView::operator[](U64 _index) const
+{
+  return data_[_index];
+}
+
+inline const Byte *BlobView::data() const
+{
+  return data_;
+}
+
+inline U64 BlobView::size() const
+{
+  return size_;
+}
+
+inline Blob::ScrubType BlobView::scrubType() const
+{
+  return scrubType_;
+}
+
+inline Blob::CompareType BlobView::compareType() const
+{
+  return compareType_;
+}
+
+
+// Searches take offsets in and return offsets relative to the searched data
+
+inline U64 BlobView::find(const BlobView &_needle, U64 _from) const
+{
+  if (_from > size_) {
+    return Blob::kNotFound;
+  }
+  U64 offset = findBytes(&data_[_from], size_ - _from, _needle.data_, _needle.size_);
+  return offset == Blob::kNotFound ? offset : _from + offset;
+}
+
+// The last occurrence which starts at or before 'before'
+inline U64 BlobView::rfind(const BlobView &_needle, U64 _before) const
+{
+  U64 size = size_;
+  if (_before < size_ && _needle.size_ < size_ - _before) {
+    size = _before + _needle.size_;
+  }
+  return rfindBytes(data_, size, _needle.data_, _needle.size_);
+}
+
+inline U64 BlobView::findByte(Byte _byte, U64 _from) const
+{
+  if (_from >= size_) {
+    return Blob::kNotFound;
+  }
+  const void *hit = memchr((const void *)&data_[_from], _byte, size_ - _from);
+  return hit == nullptr ? Blob::kNotFound : (U64)((const Byte *)hit - data_);
+}
+
+inline Split<BlobView> BlobView::split(Byte _delimiter) const
+{
+  return Split<BlobView>(*this, _delimiter);
+}
+
+inline Split<BlobView> BlobView::split(const BlobView &_delimiter) const
+{
+  return Split<BlobView>(*this, _delimiter);
+}
+
+inline U64 Blob::find(const BlobView &_needle, U64 _from) const
+{
+  return view().find(_needle, _from);
+}
+
+inline U64 Blob::rfind(const BlobView &_needle, U64 _before) const
+{
+  return view().rfind(_needle, _before);
+}
+
+inline U64 Blob::findByte(Byte _byte, U64 _from) const
+{
+  return view().findByte(_byte, _from);
+}
+
+inline Split<Blob> Blob::split(Byte _delimiter) const
+{
+  return Split<Blob>(*this, _delimiter);
+}
+
+inline Split<Blob> Blob::split(const BlobView &_delimiter) const
+{
+  return Split<Blob>(*this, _delimiter);
+}
+
+template<typename T>
+Split<T>::Split(const T &_source, Byte _delimiter)
+  : source_(_source), byte_(_delimiter), single_(true)
+{
+  // empty
+}
+
+template<typename T>
+Split<T>::Split(const T &_source, const BlobView &_delimiter)
+  : source_(_source), byte_(0), delimiter_(_delimiter), single_(false)
+{
+  // empty
+}
+
+template<typename T>
+typename Split<T>::Iterator Split<T>::begin() const
+{
+  return Iterator(this, 0);
+}
+
+template<typename T>
+typename Split<T>::Iterator Split<T>::end() const
+{
+  return Iterator(this, Blob::kNotFound);
+}
+
+template<typename T>
+Split<T>::Iterator::Iterator()
+  : split_(nullptr), offset_(Blob::kNotFound), next_(Blob::kNotFound)
+{
+  // empty
+}
+
+template<typename T>
+Split<T>::Iterator::Iterator(const Split *_split, U64 _offset)
+  : split_(_split), offset_(_offset), next_(Blob::kNotFound)
+{
+  findField();
+}
+
+template<typename T>
+void Split<T>::Iterator::findField()
+{
+  if (offset_ == Blob::kNotFound) {
+    field_ = T();
+    return;
+  }
+  const T &source = split_->source_;
+  U64 hit = Blob::kNotFound;
+  U64 skip = 1;
+  if (split_->single_) {
+    hit = source.findByte(split_->byte_, offset_);
+  }
+  else if (split_->delimiter_.size() > 0) {
+    hit = source.find(split_->delimiter_, offset_);
+    skip = split_->delimiter_.size();
+  }
+  if (hit == Blob::kNotFound) {
+    field_ = T(source, source.size() - offset_, offset_);
+    next_ = Blob::kNotFound;
+  }
+  else {
+    field_ = T(source, hit - offset_, offset_);
+    next_ = hit + skip;
+  }
+}
+
+template<typename T>
+const T &Split<T>::Iterator::operator*() const
+{
+  return field_;
+}
+
+template<typename T>
+const T *Split<T>::Iterator::operator->() const
+{
+  return &field_;
+}
+
+template<typename T>
+typename Split<T>::Iterator &Split<T>::Iterator::operator++()
+{
+  offset_ = next_;
+  findField();
+  return *this;
+}
+
+template<typename T>
+typename Split<T>::Iterator Split<T>::Iterator::operator++(int)
+{
+  Iterator previous = *this;
+  operator++();
+  return previous;
+}
+
+template<typename T>
+bool Split<T>::Iterator::operator==(const Iterator &_other) const
+{
+  return offset_ == _other.offset_;
+}
+
+template<typename T>
+bool Split<T>::Iterator::operator!=(const Iterator &_other) const
+{
+  return offset_ != _other.offset_;
+}
+
+// Compile-time codecs (see byte_encoders.h for the Codec interface)
+
+// Encode with a codec whose kernel is inlined; the result is returned by value
+template<typename Codec>
+std::string BlobView::encode() const
+{
+  std::string output(Codec::encodedSize(size_), '\0');
+  output.resize(Codec::encode(data_, size_, &output[0]));
+  return output;
+}
+
+// Encode into any sink providing 'append(const char *, size_t)', such as a
+// std::string. Block codecs are encoded in pieces through a stack buffer.
+template<typename Codec, typename Sink>
+void BlobView::encode(Sink &_sink) const
+{
+  if (Codec::kBlockSize == 0) {
+    std::string output = encode<Codec>();
+    _sink.append(output.data(), output.size());
+    return;
+  }
+  char buffer[1024];
+  const U64 blocks = sizeof(buffer) / Codec::encodedSize(Codec::kBlockSize);
+  const U64 chunk = (blocks > 0 ? blocks : 1) * Codec::kBlockSize;
+  for (U64 offset = 0; offset < size_; offset += chunk) {
+    U64 n = (size_ - offset < chunk) ? size_ - offset : chunk;
+    _sink.append(buffer, Codec::encode(&data_[offset], n, buffer));
+  }
+}
+
+// Return true if the text decodes to the viewed data, without allocating.
+// The text is decoded in pieces into a stack buffer and compared as it goes:
+// CompareType::DEFAULT stops at the first difference, while CompareType::CONST
+// decodes and compares all of the text so the time taken depends only on the
+// sizes. Invalid text is never equal: every piece but the last must decode to
+// whole groups, so padding or a short group can only end the text. Codecs
+// whose text cannot be split (kTextBlockSize == 0) are decoded whole, into
+// the stack buffer when it fits (as tokens do) and otherwise into one heap
+// buffer; the bignum codecs' arithmetic also allocates within GMP.
+template<typename Codec>
+bool BlobView::equalsEncoded(const Byte *_text, U64 _size, Blob::CompareType _compareType) const
+{
+  const bool constant = (_compareType == Blob::CompareType::CONST);
+  Byte stack[4096];
+  Byte *buffer = stack;
+  std::unique_ptr<Byte[]> heap;
+  U64 chunk = (_size > 0) ? _size : 1;
+  if (Codec::kTextBlockSize == 0) {
+    if (Codec::decodedSize(_text, _size) > sizeof(stack)) {
+      heap.reset(new Byte[Codec::decodedSize(_text, _size)]);
+      buffer = heap.get();
+    }
+  }
+  else {
+    const U64 groups = sizeof(stack) / Codec::decodedSize(_text, Codec::kTextBlockSize);
+    chunk = (groups > 0 ? groups : 1) * Codec::kTextBlockSize;
+  }
+  bool valid = true;
+  U64 difference = 0;
+  U64 offset = 0;
+
+  for (U64 i = 0; i < _size; i += chunk) {
+    U64 n = (_size - i > chunk) ? chunk : _size - i;
+    DecodeStatus status = Codec::decode(&_text[i], n, buffer);
+    bool last = (i + n == _size);
+    if (!status.ok() ||
+        (!last && (status.size != (n / Codec::kTextBlockSize) * Codec::kBlockSize))) {
+      valid = false;
+      break;
+    }
+    if (status.size > size_ - offset) {
+      difference = 1;
+      if (!constant) {
+        break;
+      }
+      offset = size_;
+    }
+    else {
+      if (constant) {
+        difference |= constantDifference(&data_[offset], buffer, status.size);
+      }
+      else if (memcmp((const void *)&data_[offset], (const void *)buffer, status.size) != 0) {
+        difference = 1;
+        break;
+      }
+      offset += status.size;
+    }
+  }
+  if (scrubType_ != Blob::ScrubType::NONE) {
+    // Only the decoded size of the largest piece can have been written
+    scrub_zeros(buffer, Codec::decodedSize(_text, (_size < chunk) ? _size : chunk));
+  }
+  return valid && (difference == 0) && (offset == size_);
+}
+
+template<typename Codec>
+bool BlobView::equalsEncoded(const std::string &_text, Blob::CompareType _compareType) const
+{
+  return equalsEncoded<Codec>((const Byte *)_text.data(), _text.size(), _compareType);
+}
+
+template<typename Codec>
+bool BlobView::equalsEncoded(const std::string &_text, Codec, Blob::CompareType _compareType) const
+{
+  return equalsEncoded<Codec>((const Byte *)_text.data(), _text.size(), _compareType);
+}
+
+// The Blob forms of the codec templates operate on a view of the Blob
+
+template<typename Codec>
+std::string Blob::encode() const
+{
+  return view().encode<Codec>();
+}
+
+template<typename Codec, typename Sink>
+void Blob::encode(Sink &_sink) const
+{
+  view().encode<Codec>(_sink);
+}
+
+// The cache is keyed by type, so it only takes encoders whose type says what
+// they do: codecs, and lambdas without captures such as 'encode_hex'
+template<typename Codec>
+std::shared_ptr<const std::string> Blob::cachedEncode() const
+{
+  return cached(typeid(Codec), [this] { return encode<Codec>(); });
+}
+
+template<typename F>
+std::shared_ptr<const std::string> Blob::cachedData(const F &_encoder) const
+{
+  static_assert(std::is_empty<F>::value, "only stateless encoders can be cached");
+  return cached(typeid(F), [this, &_encoder] { return std::move(*data(Encoder(_encoder))); });
+}
+
+template<typename Codec>
+bool Blob::equalsEncoded(const Byte *_text, U64 _size, CompareType _compareType) const
+{
+  return view().equalsEncoded<Codec>(_text, _size, _compareType);
+}
+
+template<typename Codec>
+bool Blob::equalsEncoded(const std::string &_text, CompareType _compareType) const
+{
+  return equalsEncoded<Codec>((const Byte *)_text.data(), _text.size(), _compareType);
+}
+
+template<typename Codec>
+bool Blob::equalsEncoded(const std::string &_text, Codec, CompareType _compareType) const
+{
+  return equalsEncoded<Codec>((const Byte *)_text.data(), _text.size(), _compareType);
+}
+
+// Decode with a codec whose kernel is inlined; the result is returned by
+// value. Input which is not valid for the codec results in an empty Blob.
+template<typename Codec>
+Blob Blob::decode(const Byte *_data, U64 _size, ScrubType _scrubType, CompareType _compareType)
+{
+  Blob output;
+  tryDecode<Codec>(_data, _size, output, _scrubType, _compareType);
+  return output;
+}
+
+template<typename Codec>
+Blob Blob::decode(const std::string &_data, ScrubType _scrubType, CompareType _compareType)
+{
+  return decode<Codec>((const Byte *)_data.data(), _data.size(), _scrubType, _compareType);
+}
+
+// Validate and decode in one pass. On success 'out' holds the decoded data;
+// otherwise it is empty and the status holds the offset of the first invalid
+// character.
+template<typename Codec>
+DecodeStatus Blob::tryDecode(const Byte *_data, U64 _size, Blob &_out, ScrubType _scrubType,
+  CompareType _compareType)
+{
+  MutableBlob output(Codec::decodedSize(_data, _size), _scrubType, _compareType);
+  DecodeStatus status = Codec::decode(_data, _size, output.data());
+  if (status.ok()) {
+    _out = Blob(output, status.size);
+  }
+  else {
+    _out = Blob(0, _scrubType, _compareType);
+  }
+  return status;
+}
+
+template<typename Codec>
+DecodeStatus Blob::tryDecode(const std::string &_data, Blob &_out, ScrubType _scrubType,
+  CompareType _compareType)
+{
+  return tryDecode<Codec>((const Byte *)_data.data(), _data.size(), _out, _scrubType, _compareType);
+}
+
 } // namespace Util
 
 #endif // UTIL_BLOB_H
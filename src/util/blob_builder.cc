@@ -0,0 +1,170 @@
+#include "util/blob_builder.h"
+#include "util/container.h"
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace Util;
+
+namespace {
+
+const U64 kMinimumCapacity = 64;
+
+U64 pageSize()
+{
+  static const U64 size = (U64)sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+U64 roundToPages(U64 size)
+{
+  return (size + pageSize() - 1) & ~(pageSize() - 1);
+}
+
+Byte *mapPages(U64 size)
+{
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  return (Byte *)data;
+}
+
+} // anonymous namespace
+
+BlobBuilder::BlobBuilder(U64 _capacity, Blob::ScrubType _scrubType, Blob::CompareType _compareType)
+  : data_(nullptr), size_(0), capacity_(0), mapped_(false), scrubType_(_scrubType),
+  compareType_(_compareType)
+{
+  reserve(_capacity);
+}
+
+BlobBuilder::~BlobBuilder()
+{
+  release();
+}
+
+void BlobBuilder::reserve(U64 _capacity)
+{
+  if (_capacity > capacity_) {
+    grow(_capacity);
+  }
+}
+
+void BlobBuilder::clear()
+{
+  if ((data_ != nullptr) && (scrubType_ != Blob::ScrubType::NONE)) {
+    scrub_zeros(data_, size_);
+  }
+  size_ = 0;
+}
+
+// Reallocate to at least 'minimum' bytes, doubling the capacity at least
+void BlobBuilder::grow(U64 _minimum)
+{
+  U64 capacity = 2 * capacity_;
+  if (capacity < _minimum) {
+    capacity = _minimum;
+  }
+  if (capacity < kMinimumCapacity) {
+    capacity = kMinimumCapacity;
+  }
+
+  Byte *data;
+  if (mapped_) {
+    // Pages are moved, not copied, so nothing is left to scrub
+    capacity = roundToPages(capacity);
+    void *moved = mremap((void *)data_, capacity_, capacity, MREMAP_MAYMOVE);
+    if (moved == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    data = (Byte *)moved;
+  }
+  else if (capacity >= kMapThreshold) {
+    capacity = roundToPages(capacity);
+    data = mapPages(capacity);
+    if (size_ > 0) {
+      memcpy((void *)data, (const void *)data_, size_);
+    }
+    release();
+    mapped_ = true;
+  }
+  else if (scrubType_ == Blob::ScrubType::NONE) {
+    data = (Byte *)realloc((void *)data_, capacity);
+    if (data == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+  else {
+    // realloc() could free the old data unscrubbed
+    data = (Byte *)malloc(capacity);
+    if (data == nullptr) {
+      throw std::bad_alloc();
+    }
+    if (size_ > 0) {
+      memcpy((void *)data, (const void *)data_, size_);
+    }
+    release();
+  }
+  data_ = data;
+  capacity_ = capacity;
+}
+
+// Scrub (if required) and free the buffer, keeping 'size_'
+void BlobBuilder::release()
+{
+  if (data_ == nullptr) {
+    return;
+  }
+  if (scrubType_ != Blob::ScrubType::NONE) {
+    scrub_zeros(data_, size_);
+  }
+  if (mapped_) {
+    munmap((void *)data_, capacity_);
+  }
+  else {
+    free((void *)data_);
+  }
+  data_ = nullptr;
+  capacity_ = 0;
+  mapped_ = false;
+}
+
+// The buffer is adopted by a Container which frees it the way it was
+// allocated. Unused mapped pages are returned to the system first.
+Blob BlobBuilder::freeze()
+{
+  if (data_ == nullptr) {
+    return Blob(0, scrubType_, compareType_);
+  }
+  Container::ReleaseType releaser;
+  if (mapped_) {
+    U64 used = roundToPages(size_ > 0 ? size_ : 1);
+    if (used < capacity_) {
+      munmap((void *)&data_[used], capacity_ - used);
+      capacity_ = used;
+    }
+    U64 mapping = capacity_;
+    releaser = [mapping] (Byte *_data, U64) {
+      munmap((void *)_data, mapping);
+    };
+  }
+  else {
+    releaser = [] (Byte *_data, U64) {
+      free((void *)_data);
+    };
+  }
+  Container::ScrubType scrubber;
+  if (scrubType_ != Blob::ScrubType::NONE) {
+    scrubber = scrub_zeros;
+  }
+  Blob frozen(std::make_shared<Container>(data_, size_, scrubber, releaser), scrubType_,
+    compareType_);
+  data_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+  mapped_ = false;
+  return frozen;
+}
@@ -0,0 +1,116 @@
+#ifndef UTIL_BLOB_BUILDER_H
+#define UTIL_BLOB_BUILDER_H
+
+#include "util/blob.h"
+#include "util/fixed_types.h"
+#include <cstring>
+
+namespace Util {
+
+/*
+   A BlobBuilder assembles data of unknown length and then hands it over as
+   an immutable Blob without copying (freeze()).
+
+   The buffer grows geometrically, so appending costs amortized constant time
+   per byte. Small buffers are on the heap; buffers of kMapThreshold bytes or
+   more are mapped pages which grow with mremap(), moving pages rather than
+   copying data.
+
+   With ScrubType::ZEROS the builder never leaves a copy of its data behind:
+   a heap buffer being replaced is scrubbed before it is freed, and remapping
+   moves the pages themselves. The frozen Blob scrubs its data on release as
+   usual.
+*/
+class BlobBuilder
+{
+ public:
+  static const U64 kMapThreshold = 1UL << 20;
+
+  explicit BlobBuilder(U64 capacity = 0, Blob::ScrubType scrubType = Blob::ScrubType::NONE,
+    Blob::CompareType compareType = Blob::CompareType::DEFAULT);
+  BlobBuilder(const BlobBuilder &) = delete;
+  BlobBuilder &operator=(const BlobBuilder &) = delete;
+  ~BlobBuilder();
+  void reserve(U64 capacity);
+  void append(const Byte *data, U64 size);
+  void append(const BlobView &blob);
+  void append(Byte byte);
+
+  // Grow by 'size' bytes and return them to be written in place
+  Byte *extend(U64 size);
+
+  // Discard the data, keeping the capacity
+  void clear();
+
+  // Hand the data over as a Blob with the builder's scrub and compare types;
+  // the builder is then empty and may be reused
+  Blob freeze();
+  Byte *data();
+  const Byte *data() const;
+  U64 size() const;
+  U64 capacity() const;
+
+ private:
+  void grow(U64 minimum);
+  void release();
+
+  Byte *data_;
+  U64 size_;
+  U64 capacity_;
+  bool mapped_;       // whether 'data_' is mapped pages rather than heap
+  Blob::ScrubType scrubType_;
+  Blob::CompareType compareType_;
+};
+
+// Appending is inline so that small appends cost a copy and a comparison
+
+inline void BlobBuilder::append(const Byte *_data, U64 _size)
+{
+  if (_size > 0) {
+    memcpy((void *)extend(_size), (const void *)_data, _size);
+  }
+}
+
+inline void BlobBuilder::append(const BlobView &_blob)
+{
+  append(_blob.data(), _blob.size());
+}
+
+inline void BlobBuilder::append(Byte _byte)
+{
+  *extend(1) = _byte;
+}
+
+inline Byte *BlobBuilder::extend(U64 _size)
+{
+  if (_size > capacity_ - size_) {
+    grow(size_ + _size);
+  }
+  Byte *space = &data_[size_];
+  size_ += _size;
+  return space;
+}
+
+inline Byte *BlobBuilder::data()
+{
+  return data_;
+}
+
+inline const Byte *BlobBuilder::data() const
+{
+  return data_;
+}
+
+inline U64 BlobBuilder::size() const
+{
+  return size_;
+}
+
+inline U64 BlobBuilder::capacity() const
+{
+  return capacity_;
+}
+
+} // namespace Util
+
+#endif // UTIL_BLOB_BUILDER_H
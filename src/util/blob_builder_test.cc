@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include "util/blob_builder.h"
+#include "util/blob.h"
+#include <string>
+
+using namespace Util;
+using std::string;
+
+TEST(BlobBuilderTest, Append) {
+  BlobBuilder builder;
+  EXPECT_EQ(0U, builder.size());
+  builder.append(Blob(string("hello")));
+  builder.append((Byte)' ');
+  builder.append((const Byte *)"world", 5);
+  builder.append(nullptr, 0);
+  memcpy((void *)builder.extend(1), (const void *)"!", 1);
+  EXPECT_EQ(12U, builder.size());
+  EXPECT_GE(builder.capacity(), builder.size());
+  EXPECT_EQ(Blob(string("hello world!")), builder.freeze());
+
+  // Frozen builders are empty and reusable
+  EXPECT_EQ(0U, builder.size());
+  EXPECT_EQ(0U, builder.freeze().size());
+  builder.append((Byte)'x');
+  EXPECT_EQ(Blob(string("x")), builder.freeze());
+}
+
+TEST(BlobBuilderTest, Growth) {
+  // Cross from the heap to mapped pages and keep growing
+  BlobBuilder builder;
+  string expected;
+  U64 reallocations = 0;
+  U64 capacity = builder.capacity();
+  for (U64 i = 0; expected.size() < 3 * BlobBuilder::kMapThreshold; i++) {
+    string piece = std::to_string(i) + ",";
+    builder.append((const Byte *)piece.data(), piece.size());
+    expected += piece;
+    if (builder.capacity() != capacity) {
+      reallocations++;
+      capacity = builder.capacity();
+    }
+  }
+  EXPECT_LT(reallocations, 20U);
+  EXPECT_EQ(expected.size(), builder.size());
+  EXPECT_EQ(0, memcmp((const void *)builder.data(), (const void *)expected.data(), expected.size()));
+
+  Blob frozen = builder.freeze();
+  EXPECT_EQ(Blob(expected), frozen);
+}
+
+TEST(BlobBuilderTest, ReserveAndClear) {
+  BlobBuilder builder(1000, Blob::ScrubType::ZEROS, Blob::CompareType::CONST);
+  EXPECT_GE(builder.capacity(), 1000U);
+  const Byte *data = builder.data();
+  builder.append(Blob(string(1000, 's')));
+  EXPECT_EQ(data, builder.data());
+
+  builder.clear();
+  EXPECT_EQ(0U, builder.size());
+  EXPECT_EQ(0, builder.data()[0]);
+  builder.reserve(10);
+  EXPECT_EQ(data, builder.data());
+
+  builder.append(Blob(string("secret")));
+  Blob frozen = builder.freeze();
+  EXPECT_EQ(data, frozen.data());  // not copied
+  EXPECT_EQ(Blob::ScrubType::ZEROS, frozen.scrubType());
+  EXPECT_EQ(Blob::CompareType::CONST, frozen.compareType());
+
+  // Nothing to scrub before anything is allocated, or once it is handed over
+  builder.clear();
+  BlobBuilder empty(0, Blob::ScrubType::ZEROS);
+  empty.clear();
+  EXPECT_EQ(0U, empty.size());
+
+  // Large reservations are mapped; frozen pages outlive the builder
+  Blob mapped;
+  {
+    BlobBuilder big(BlobBuilder::kMapThreshold);
+    big.append(Blob(string(100, 'm')));
+    mapped = big.freeze();
+  }
+  EXPECT_EQ(Blob(string(100, 'm')), mapped);
+}
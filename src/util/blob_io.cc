@@ -0,0 +1,94 @@
+#include "util/blob_io.h"
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace Util;
+
+namespace {
+
+// A block is 16 bytes; a 64-bit load at any of them must stay in bounds
+const U64 kBlock = 16;
+const U64 kBlockReach = kBlock + 8;
+
+// Bit i is set where byte i ends a varint (its high bit is clear)
+inline U32 varintEnds(const Byte *_data)
+{
+#ifdef __SSE2__
+  return ~(U32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)_data)) & 0xffff;
+#else
+  U32 ends = 0;
+  for (U32 i = 0; i < kBlock; i++) {
+    ends |= (U32)((_data[i] >> 7) ^ 1) << i;
+  }
+  return ends;
+#endif
+}
+
+// The value of a varint of 1 to 8 bytes, from the word its bytes start
+inline U64 gather(const Byte *_data, U64 _length)
+{
+  U64 x;
+  memcpy((void *)&x, (const void *)_data, sizeof(x));
+  x = Detail::littleEndian(x) & (~0UL >> (64 - 8 * _length)) & 0x7f7f7f7f7f7f7f7fUL;
+  x = (x & 0x007f007f007f007fUL) | ((x & 0x7f007f007f007f00UL) >> 1);
+  x = (x & 0x00003fff00003fffUL) | ((x & 0x3fff00003fff0000UL) >> 2);
+  return (x & 0x000000000fffffffUL) | ((x & 0x0fffffff00000000UL) >> 4);
+}
+
+} // anonymous namespace
+
+U64 Util::decodeVarints(const Byte *_data, U64 _size, U64 *_out, U64 _count, U64 &_consumed)
+{
+  U64 n = 0;
+  U64 offset = 0;
+
+  // A block holds at most 16 varints, so while that many are still wanted
+  // only the data is bounds checked, once per block
+  while (_count - n >= kBlock && _size - offset >= kBlockReach) {
+    const Byte *block = &_data[offset];
+    U32 ends = varintEnds(block);
+    if (ends == 0xffff) {
+      // Sixteen one-byte values
+      for (U64 i = 0; i < kBlock; i++) {
+        _out[n + i] = block[i];
+      }
+      n += kBlock;
+      offset += kBlock;
+      continue;
+    }
+    if (ends == 0) {
+      break;  // too long; reported below
+    }
+
+    // Each varint ending in the block; one which continues past the end
+    // starts the next block
+    U64 position = 0;
+    for (; ends != 0; ends &= ends - 1) {
+      U64 length = (U64)__builtin_ctz(ends) + 1 - position;
+      if (length <= 8) {
+        _out[n] = gather(&block[position], length);
+      }
+      else if (decodeVarint(&block[position], length, _out[n]) == 0) {
+        _consumed = offset + position;
+        return n;
+      }
+      n++;
+      position += length;
+    }
+    offset += position;
+  }
+
+  // The rest, and any error, one at a time
+  while (n < _count) {
+    U64 length = decodeVarint(&_data[offset], _size - offset, _out[n]);
+    if (length == 0) {
+      break;
+    }
+    offset += length;
+    n++;
+  }
+  _consumed = offset;
+  return n;
+}
@@ -0,0 +1,444 @@
+#ifndef UTIL_BLOB_IO_H
+#define UTIL_BLOB_IO_H
+
+#include "util/blob.h"
+#include "util/fixed_types.h"
+#include <cstring>
+
+namespace Util {
+
+/*
+   Typed reading and writing of binary protocols: fixed-width integers in
+   either byte order, and LEB128 varints (unsigned, and signed with zigzag
+   encoding as in Protocol Buffers). Loads and stores go through memcpy(), so
+   any offset is safe.
+
+   A BlobReader walks a view and a BlobWriter fills a MutableBlob. A read or
+   write which does not fit sets a sticky failure instead of touching memory
+   out of bounds: ok() turns false, later reads return 0 and later writes
+   are dropped, so a message can be parsed or built straight through and
+   checked once at the end.
+
+     Util::BlobReader reader(message);
+     U32 type = reader.readU32();
+     U64 count = reader.readVarint();
+     std::vector<U64> ids(count);
+     reader.readVarints(ids.data(), count);
+     if (!reader.ok()) ...
+
+   decodeVarints() decodes a run of varints in bulk. It takes the high bits
+   of 16 bytes at a time as a mask (one SSE2 movemask where available). A
+   block without continuation bits is 16 one-byte values; otherwise each
+   value ending in the block is gathered from one unaligned 64-bit load,
+   with its 7-bit groups joined by three shift-and-mask steps.
+   Bounds are checked once per block, not per byte.
+*/
+
+// The longest encoding of a 64-bit value
+const U64 kMaxVarintSize = 10;
+
+U64 varintSize(U64 value);
+
+// Writes the varint to 'out' (room for varintSize() bytes); returns its size
+U64 encodeVarint(U64 value, Byte *out);
+
+// Decodes one varint; returns its size, or 0 when the data ends first or it
+// is not a valid 64-bit value (longer than 10 bytes, or overflowing)
+U64 decodeVarint(const Byte *data, U64 size, U64 &value);
+
+// Decodes up to 'count' consecutive varints into 'out'; returns the number
+// decoded, which is less than 'count' where the data ends or a varint is not
+// valid, and sets 'consumed' to the bytes they took
+U64 decodeVarints(const Byte *data, U64 size, U64 *out, U64 count, U64 &consumed);
+
+// Zigzag encoding maps small negative and positive values to small codes
+inline U64 zigzagEncode(S64 _value)
+{
+  return ((U64)_value << 1) ^ (U64)(_value >> 63);
+}
+
+inline S64 zigzagDecode(U64 _code)
+{
+  return (S64)((_code >> 1) ^ (~(_code & 1) + 1));
+}
+
+class BlobReader
+{
+ public:
+  explicit BlobReader(const BlobView &data);
+
+  bool ok() const;
+  U64 offset() const;
+  U64 remaining() const;
+
+  // Fixed-width integers, little-endian unless 'Be'
+  U8 readU8();
+  U16 readU16();
+  U32 readU32();
+  U64 readU64();
+  U16 readU16Be();
+  U32 readU32Be();
+  U64 readU64Be();
+
+  U64 readVarint();
+  S64 readSignedVarint();
+
+  // Fills 'count' values or fails
+  void readVarints(U64 *out, U64 count);
+
+  // The next 'size' bytes, without copying
+  BlobView readBytes(U64 size);
+  void skip(U64 size);
+
+ private:
+  template<typename T> T load();
+  void fail();
+
+  BlobView data_;
+  U64 offset_;
+  bool ok_;
+};
+
+class BlobWriter
+{
+ public:
+  // Like a pointer from MutableBlob::data(), the writer must not outlive the
+  // MutableBlob, which keeps checksums from being cached while it writes
+  explicit BlobWriter(MutableBlob &blob, U64 offset = 0);
+
+  bool ok() const;
+  U64 offset() const;
+  U64 remaining() const;
+
+  void writeU8(U8 value);
+  void writeU16(U16 value);
+  void writeU32(U32 value);
+  void writeU64(U64 value);
+  void writeU16Be(U16 value);
+  void writeU32Be(U32 value);
+  void writeU64Be(U64 value);
+
+  void writeVarint(U64 value);
+  void writeSignedVarint(S64 value);
+  void writeBytes(const BlobView &bytes);
+
+ private:
+  template<typename T> void store(T value);
+  void fail();
+
+  Byte *data_;
+  U64 size_;
+  U64 offset_;
+  bool ok_;
+};
+
+
+// Everything but the bulk decoder is inline, as the calls are per field
+
+namespace Detail {
+
+// Integers are stored little-endian; these convert to and from the host order
+inline U8 littleEndian(U8 _value)
+{
+  return _value;
+}
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+inline U16 littleEndian(U16 _value)
+{
+  return __builtin_bswap16(_value);
+}
+
+inline U32 littleEndian(U32 _value)
+{
+  return __builtin_bswap32(_value);
+}
+
+inline U64 littleEndian(U64 _value)
+{
+  return __builtin_bswap64(_value);
+}
+#else
+inline U16 littleEndian(U16 _value)
+{
+  return _value;
+}
+
+inline U32 littleEndian(U32 _value)
+{
+  return _value;
+}
+
+inline U64 littleEndian(U64 _value)
+{
+  return _value;
+}
+#endif
+
+} // namespace Detail
+
+inline U64 varintSize(U64 _value)
+{
+  // One byte per started group of 7 bits; zero takes one byte
+  U32 bits = 64 - (U32)__builtin_clzll(_value | 1);
+  return (bits + 6) / 7;
+}
+
+inline U64 encodeVarint(U64 _value, Byte *_out)
+{
+  U64 n = 0;
+  while (_value >= 0x80) {
+    _out[n++] = (Byte)(_value | 0x80);
+    _value >>= 7;
+  }
+  _out[n++] = (Byte)_value;
+  return n;
+}
+
+inline U64 decodeVarint(const Byte *_data, U64 _size, U64 &_value)
+{
+  U64 value = 0;
+  U64 limit = _size < kMaxVarintSize ? _size : kMaxVarintSize;
+  for (U64 i = 0; i < limit; i++) {
+    value |= (U64)(_data[i] & 0x7f) << (7 * i);
+    if ((_data[i] & 0x80) == 0) {
+      // The tenth byte holds only the top bit
+      if (i == kMaxVarintSize - 1 && _data[i] > 1) {
+        return 0;
+      }
+      _value = value;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+inline BlobReader::BlobReader(const BlobView &_data)
+  : data_(_data), offset_(0), ok_(true)
+{
+  // empty
+}
+
+inline bool BlobReader::ok() const
+{
+  return ok_;
+}
+
+inline U64 BlobReader::offset() const
+{
+  return offset_;
+}
+
+inline U64 BlobReader::remaining() const
+{
+  return data_.size() - offset_;
+}
+
+inline void BlobReader::fail()
+{
+  ok_ = false;
+  offset_ = data_.size();
+}
+
+template<typename T>
+T BlobReader::load()
+{
+  if (sizeof(T) > data_.size() - offset_) {
+    fail();
+    return 0;
+  }
+  T value;
+  memcpy((void *)&value, (const void *)&data_.data()[offset_], sizeof(value));
+  offset_ += sizeof(T);
+  return Detail::littleEndian(value);
+}
+
+inline U8 BlobReader::readU8()
+{
+  return load<U8>();
+}
+
+inline U16 BlobReader::readU16()
+{
+  return load<U16>();
+}
+
+inline U32 BlobReader::readU32()
+{
+  return load<U32>();
+}
+
+inline U64 BlobReader::readU64()
+{
+  return load<U64>();
+}
+
+inline U16 BlobReader::readU16Be()
+{
+  return __builtin_bswap16(load<U16>());
+}
+
+inline U32 BlobReader::readU32Be()
+{
+  return __builtin_bswap32(load<U32>());
+}
+
+inline U64 BlobReader::readU64Be()
+{
+  return __builtin_bswap64(load<U64>());
+}
+
+inline U64 BlobReader::readVarint()
+{
+  U64 value = 0;
+  U64 n = decodeVarint(&data_.data()[offset_], data_.size() - offset_, value);
+  if (n == 0) {
+    fail();
+    return 0;
+  }
+  offset_ += n;
+  return value;
+}
+
+inline S64 BlobReader::readSignedVarint()
+{
+  return zigzagDecode(readVarint());
+}
+
+inline void BlobReader::readVarints(U64 *_out, U64 _count)
+{
+  U64 consumed = 0;
+  U64 n = decodeVarints(&data_.data()[offset_], data_.size() - offset_, _out, _count, consumed);
+  if (n < _count) {
+    fail();
+    return;
+  }
+  offset_ += consumed;
+}
+
+inline BlobView BlobReader::readBytes(U64 _size)
+{
+  if (_size > data_.size() - offset_) {
+    fail();
+    return BlobView();
+  }
+  BlobView bytes(data_, _size, offset_);
+  offset_ += _size;
+  return bytes;
+}
+
+inline void BlobReader::skip(U64 _size)
+{
+  if (_size > data_.size() - offset_) {
+    fail();
+    return;
+  }
+  offset_ += _size;
+}
+
+inline BlobWriter::BlobWriter(MutableBlob &_blob, U64 _offset)
+  : data_(_blob.data()), size_(_blob.size()), offset_(_offset), ok_(_offset <= _blob.size())
+{
+  if (!ok_) {
+    offset_ = size_;
+  }
+}
+
+inline void BlobWriter::fail()
+{
+  ok_ = false;
+  offset_ = size_;
+}
+
+inline bool BlobWriter::ok() const
+{
+  return ok_;
+}
+
+inline U64 BlobWriter::offset() const
+{
+  return offset_;
+}
+
+inline U64 BlobWriter::remaining() const
+{
+  return size_ - offset_;
+}
+
+template<typename T>
+void BlobWriter::store(T _value)
+{
+  if (sizeof(T) > size_ - offset_) {
+    fail();
+    return;
+  }
+  _value = Detail::littleEndian(_value);
+  memcpy((void *)&data_[offset_], (const void *)&_value, sizeof(_value));
+  offset_ += sizeof(T);
+}
+
+inline void BlobWriter::writeU8(U8 _value)
+{
+  store<U8>(_value);
+}
+
+inline void BlobWriter::writeU16(U16 _value)
+{
+  store<U16>(_value);
+}
+
+inline void BlobWriter::writeU32(U32 _value)
+{
+  store<U32>(_value);
+}
+
+inline void BlobWriter::writeU64(U64 _value)
+{
+  store<U64>(_value);
+}
+
+inline void BlobWriter::writeU16Be(U16 _value)
+{
+  store<U16>(__builtin_bswap16(_value));
+}
+
+inline void BlobWriter::writeU32Be(U32 _value)
+{
+  store<U32>(__builtin_bswap32(_value));
+}
+
+inline void BlobWriter::writeU64Be(U64 _value)
+{
+  store<U64>(__builtin_bswap64(_value));
+}
+
+inline void BlobWriter::writeVarint(U64 _value)
+{
+  if (size_ - offset_ >= kMaxVarintSize || varintSize(_value) <= size_ - offset_) {
+    offset_ += encodeVarint(_value, &data_[offset_]);
+  }
+  else {
+    fail();
+  }
+}
+
+inline void BlobWriter::writeSignedVarint(S64 _value)
+{
+  writeVarint(zigzagEncode(_value));
+}
+
+inline void BlobWriter::writeBytes(const BlobView &_bytes)
+{
+  if (_bytes.size() > size_ - offset_) {
+    fail();
+    return;
+  }
+  if (_bytes.size() > 0) {
+    memcpy((void *)&data_[offset_], (const void *)_bytes.data(), _bytes.size());
+  }
+  offset_ += _bytes.size();
+}
+
+} // namespace Util
+
+#endif // UTIL_BLOB_IO_H
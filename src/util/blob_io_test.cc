@@ -0,0 +1,162 @@
+#include "gtest/gtest.h"
+#include "util/blob_io.h"
+#include "util/blob.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+std::vector<Byte> encodeAll(const std::vector<U64> &values)
+{
+  std::vector<Byte> data(values.size() * kMaxVarintSize);
+  U64 size = 0;
+  for (U64 value : values) {
+    size += encodeVarint(value, &data[size]);
+  }
+  data.resize(size);
+  return data;
+}
+
+// Values of every encoded length, mostly short as in real messages
+std::vector<U64> randomValues(U64 count, U32 seed)
+{
+  std::default_random_engine gen(seed);
+  std::uniform_int_distribution<U32> bits(0, 63);
+  std::uniform_int_distribution<U64> any;
+  std::vector<U64> values(count);
+  for (U64 i = 0; i < count; i++) {
+    U32 b = bits(gen);
+    values[i] = b < 32 ? any(gen) & 0x7f : any(gen) >> b;
+  }
+  return values;
+}
+
+} // anonymous namespace
+
+
+TEST(BlobIoTest, Varint) {
+  Byte out[kMaxVarintSize];
+  EXPECT_EQ(1UL, encodeVarint(0, out));
+  EXPECT_EQ(0, out[0]);
+  EXPECT_EQ(2UL, encodeVarint(300, out));
+  EXPECT_EQ(0xac, out[0]);
+  EXPECT_EQ(0x02, out[1]);
+  EXPECT_EQ(10UL, encodeVarint(~0UL, out));
+  EXPECT_EQ(0x01, out[9]);
+
+  for (U64 value : {0UL, 1UL, 127UL, 128UL, 16383UL, 16384UL, 1UL << 56, ~0UL}) {
+    U64 size = encodeVarint(value, out);
+    EXPECT_EQ(varintSize(value), size);
+    U64 decoded = 0;
+    EXPECT_EQ(size, decodeVarint(out, size, decoded));
+    EXPECT_EQ(value, decoded);
+    EXPECT_EQ(0UL, decodeVarint(out, size - 1, decoded));   // truncated
+  }
+
+  // Too long, and overflowing 64 bits
+  const Byte tooLong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+  const Byte overflow[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02};
+  U64 value = 0;
+  EXPECT_EQ(0UL, decodeVarint(tooLong, sizeof(tooLong), value));
+  EXPECT_EQ(0UL, decodeVarint(overflow, sizeof(overflow), value));
+
+  for (S64 v : {0L, 1L, -1L, 63L, -64L, (S64)(~0UL >> 1), (S64)(1UL << 63)}) {
+    EXPECT_EQ(v, zigzagDecode(zigzagEncode(v)));
+  }
+  EXPECT_EQ(1UL, zigzagEncode(-1));
+  EXPECT_EQ(2UL, zigzagEncode(1));
+}
+
+TEST(BlobIoTest, DecodeVarints) {
+  for (U32 seed = 1; seed <= 4; seed++) {
+    std::vector<U64> values = randomValues(1000, seed);
+    if (seed == 1) {
+      values.assign(1000, 5);   // all one byte
+    }
+    std::vector<Byte> data = encodeAll(values);
+    std::vector<U64> out(values.size() + 1, 0);
+    U64 consumed = 0;
+    EXPECT_EQ(values.size(), decodeVarints(data.data(), data.size(), out.data(), values.size(),
+      consumed));
+    EXPECT_EQ(data.size(), consumed);
+    out.pop_back();
+    EXPECT_EQ(values, out);
+
+    // Stopping at the count, and at the end of the data
+    EXPECT_EQ(7UL, decodeVarints(data.data(), data.size(), out.data(), 7, consumed));
+    EXPECT_EQ(encodeAll(std::vector<U64>(values.begin(), values.begin() + 7)).size(), consumed);
+    EXPECT_EQ(values.size() - 1, decodeVarints(data.data(), data.size() - 1, out.data(),
+      values.size(), consumed));
+  }
+
+  // An invalid varint in the middle stops the batch before it
+  std::vector<U64> values = randomValues(100, 5);
+  std::vector<Byte> data = encodeAll(std::vector<U64>(values.begin(), values.begin() + 50));
+  U64 good = data.size();
+  data.insert(data.end(), 12, 0x80);
+  std::vector<Byte> rest = encodeAll(values);
+  data.insert(data.end(), rest.begin(), rest.end());
+  std::vector<U64> out(values.size());
+  U64 consumed = 0;
+  EXPECT_EQ(50UL, decodeVarints(data.data(), data.size(), out.data(), out.size(), consumed));
+  EXPECT_EQ(good, consumed);
+}
+
+TEST(BlobIoTest, ReaderWriter) {
+  MutableBlob blob(64);
+  BlobWriter writer(blob);
+  writer.writeU8(0x01);
+  writer.writeU16(0x0302);
+  writer.writeU32Be(0x04050607);
+  writer.writeU64(0x0f0e0d0c0b0a0908UL);
+  writer.writeVarint(300);
+  writer.writeSignedVarint(-2);
+  writer.writeBytes(BlobView((const Byte *)"xyz", 3));
+  EXPECT_TRUE(writer.ok());
+  EXPECT_EQ(21UL, writer.offset());
+  for (U32 i = 0; i < 15; i++) {
+    EXPECT_EQ(i + 1, blob[i]);
+  }
+
+  BlobReader reader(BlobView(blob.view(), writer.offset()));
+  EXPECT_EQ(0x01, reader.readU8());
+  EXPECT_EQ(0x0302, reader.readU16());
+  EXPECT_EQ(0x04050607U, reader.readU32Be());
+  EXPECT_EQ(0x0f0e0d0c0b0a0908UL, reader.readU64());
+  EXPECT_EQ(300UL, reader.readVarint());
+  EXPECT_EQ(-2, reader.readSignedVarint());
+  BlobView bytes = reader.readBytes(3);
+  EXPECT_EQ(BlobView((const Byte *)"xyz", 3), bytes);
+  EXPECT_EQ(&blob.view().data()[18], bytes.data());   // not copied
+  EXPECT_TRUE(reader.ok());
+  EXPECT_EQ(0UL, reader.remaining());
+
+  // Failures are sticky
+  EXPECT_EQ(0, reader.readU8());
+  EXPECT_FALSE(reader.ok());
+
+  const Byte zeros[5] = {};
+  MutableBlob small(zeros, sizeof(zeros));
+  BlobWriter full(small);
+  full.writeU32(1);
+  full.writeU16(2);
+  full.writeU8(3);
+  EXPECT_FALSE(full.ok());
+  EXPECT_EQ(1, small[0]);
+  EXPECT_EQ(0, small[4]);   // nothing written after the failure
+
+  std::vector<U64> values = randomValues(300, 6);
+  std::vector<Byte> data = encodeAll(values);
+  Blob encoded(data.data(), data.size());
+  BlobReader many(encoded);
+  std::vector<U64> out(values.size());
+  many.readVarints(out.data(), out.size());
+  EXPECT_TRUE(many.ok());
+  EXPECT_EQ(values, out);
+  many.readVarints(out.data(), 1);
+  EXPECT_FALSE(many.ok());
+}
@@ -0,0 +1,288 @@
+#include "util/blob_pack.h"
+#include "util/blob_io.h"
+#include "util/container.h"
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+const char kMagic[8] = {'B', 'L', 'O', 'B', 'P', 'A', 'C', 'K'};
+
+// Writes are gathered up to this size; larger entries are written directly
+const U64 kBufferSize = 64 * 1024;
+
+// Write all of 'size' bytes, retrying after partial writes and signals
+bool writeAll(int fd, const Byte *data, U64 size)
+{
+  while (size > 0) {
+    ssize_t n = ::write(fd, (const void *)data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    size -= (U64)n;
+  }
+  return true;
+}
+
+// The header in file order: little-endian, whatever the host's order
+PackHeader toFile(PackHeader _header)
+{
+  _header.version = Detail::littleEndian(_header.version);
+  _header.alignment = Detail::littleEndian(_header.alignment);
+  _header.count = Detail::littleEndian(_header.count);
+  _header.payloadOffset = Detail::littleEndian(_header.payloadOffset);
+  _header.payloadSize = Detail::littleEndian(_header.payloadSize);
+  _header.indexOffset = Detail::littleEndian(_header.indexOffset);
+  return _header;
+}
+
+// Byte swapping is its own inverse
+PackHeader fromFile(const PackHeader &_header)
+{
+  return toFile(_header);
+}
+
+U64 roundUp(U64 value, U64 alignment)
+{
+  return ((value + alignment - 1) / alignment) * alignment;
+}
+
+} // anonymous namespace
+
+
+// PackWriter
+
+PackWriter::PackWriter()
+  : fd_(-1), alignment_(1), offset_(0), index_(), buffer_()
+{
+  // empty
+}
+
+PackWriter::~PackWriter()
+{
+  if (fd_ >= 0) {
+    finish();
+  }
+}
+
+// Create (or truncate) the file and reserve the header page. Entries are
+// padded within the file, which matches padding within the payload (and in
+// memory, where the mapping is page aligned) only for powers of two up to
+// the page size.
+bool PackWriter::open(const string &_path, U32 _alignment)
+{
+  if (((_alignment & (_alignment - 1)) != 0) || (_alignment > kPackPageSize)) {
+    errno = EINVAL;
+    return false;
+  }
+  if (fd_ >= 0) {
+    finish();
+  }
+  fd_ = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+  alignment_ = (_alignment == 0) ? 1 : _alignment;
+  offset_ = kPackPageSize;
+  index_.clear();
+  buffer_.assign(kPackPageSize, 0);
+  buffer_.reserve(kBufferSize);
+  return true;
+}
+
+bool PackWriter::append(const BlobView &_blob)
+{
+  if ((fd_ < 0) || !pad(alignment_)) {
+    return false;
+  }
+  // The index is kept in file order
+  index_.push_back(PackEntry{Detail::littleEndian(offset_ - kPackPageSize),
+    Detail::littleEndian(_blob.size())});
+  return write(_blob.data(), _blob.size());
+}
+
+// Write the index, then the header which makes the pack valid
+bool PackWriter::finish()
+{
+  if (fd_ < 0) {
+    return false;
+  }
+  PackHeader header;
+  memset((void *)&header, 0, sizeof(header));
+  memcpy((void *)header.magic, (const void *)kMagic, sizeof(kMagic));
+  header.version = PackHeader::kVersion;
+  header.alignment = alignment_;
+  header.count = index_.size();
+  header.payloadOffset = kPackPageSize;
+  header.payloadSize = offset_ - kPackPageSize;
+  bool ok = pad(kPackPageSize);
+  header.indexOffset = offset_;
+  ok = ok && write((const Byte *)index_.data(), index_.size() * sizeof(PackEntry)) && flush();
+  header = toFile(header);
+  ok = ok && (::pwrite(fd_, (const void *)&header, sizeof(header), 0) == (ssize_t)sizeof(header));
+  int error = errno;
+  if ((::close(fd_) != 0) && ok) {
+    ok = false;
+    error = errno;
+  }
+  fd_ = -1;
+  index_.clear();
+  errno = error;
+  return ok;
+}
+
+U64 PackWriter::count() const
+{
+  return index_.size();
+}
+
+bool PackWriter::write(const Byte *_data, U64 _size)
+{
+  offset_ += _size;
+  if (buffer_.size() + _size <= kBufferSize) {
+    buffer_.insert(buffer_.end(), _data, _data + _size);
+    return (buffer_.size() < kBufferSize) || flush();
+  }
+  return flush() && writeAll(fd_, _data, _size);
+}
+
+bool PackWriter::flush()
+{
+  bool ok = writeAll(fd_, buffer_.data(), buffer_.size());
+  buffer_.clear();
+  return ok;
+}
+
+// Write zeros up to the next multiple of 'alignment'
+bool PackWriter::pad(U64 _alignment)
+{
+  U64 padding = roundUp(offset_, _alignment) - offset_;
+  if (padding == 0) {
+    return true;
+  }
+  offset_ += padding;
+  buffer_.insert(buffer_.end(), padding, 0);
+  return (buffer_.size() < kBufferSize) || flush();
+}
+
+
+// PackReader
+
+PackReader::PackReader()
+  : payload_(), index_(nullptr), count_(0)
+{
+  // empty
+}
+
+// Map the whole file read-only and check that the header describes regions
+// within it. The mapping is owned by a Container, so it is unmapped when
+// neither the reader nor any entry refers to it.
+bool PackReader::open(const string &_path, Blob::CompareType _compareType)
+{
+  close();
+  int fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    int error = errno;
+    ::close(fd);
+    errno = error;
+    return false;
+  }
+  if ((U64)st.st_size < kPackPageSize) {
+    ::close(fd);
+    errno = EINVAL;
+    return false;
+  }
+  U64 fileSize = (U64)st.st_size;
+  void *map = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  std::shared_ptr<Container> mapping = std::make_shared<Container>((Byte *)map, fileSize,
+    Container::ScrubType(), [] (Byte *_data, U64 _size) {
+      ::munmap((void *)_data, _size);
+    });
+
+  PackHeader header;
+  memcpy((void *)&header, (const void *)map, sizeof(header));
+  header = fromFile(header);
+  bool valid = (memcmp((const void *)header.magic, (const void *)kMagic, sizeof(kMagic)) == 0) &&
+    (header.version == PackHeader::kVersion) &&
+    (header.payloadOffset <= fileSize) && (header.payloadSize <= fileSize - header.payloadOffset) &&
+    (header.indexOffset % sizeof(U64) == 0) && (header.indexOffset <= fileSize) &&
+    (header.count <= (fileSize - header.indexOffset) / sizeof(PackEntry));
+  if (!valid) {
+    errno = EINVAL;
+    return false;
+  }
+  payload_ = Blob(Blob(mapping, Blob::ScrubType::NONE, _compareType), header.payloadSize,
+    header.payloadOffset);
+  index_ = (const PackEntry *)&((const Byte *)map)[header.indexOffset];
+  count_ = header.count;
+  return true;
+}
+
+// Release the reader's reference to the mapping; entries keep their own
+void PackReader::close()
+{
+  payload_ = Blob();
+  index_ = nullptr;
+  count_ = 0;
+}
+
+U64 PackReader::count() const
+{
+  return count_;
+}
+
+Blob PackReader::operator[](U64 _index) const
+{
+  U64 offset, size;
+  if (!locate(_index, &offset, &size)) {
+    return Blob();
+  }
+  return Blob(payload_, size, offset);
+}
+
+BlobView PackReader::view(U64 _index) const
+{
+  U64 offset, size;
+  if (!locate(_index, &offset, &size)) {
+    return BlobView();
+  }
+  return BlobView(payload_.view(), size, offset);
+}
+
+// Entries are checked on access rather than when opening, so opening a pack
+// costs the same however many entries it holds
+bool PackReader::locate(U64 _index, U64 *_offset, U64 *_size) const
+{
+  if (_index >= count_) {
+    return false;
+  }
+  PackEntry entry = index_[_index];
+  entry.offset = Detail::littleEndian(entry.offset);
+  entry.size = Detail::littleEndian(entry.size);
+  if ((entry.offset > payload_.size()) || (entry.size > payload_.size() - entry.offset)) {
+    return false;
+  }
+  *_offset = entry.offset;
+  *_size = entry.size;
+  return true;
+}
@@ -0,0 +1,106 @@
+#ifndef UTIL_BLOB_PACK_H
+#define UTIL_BLOB_PACK_H
+
+#include "util/blob.h"
+#include "util/fixed_types.h"
+#include <string>
+#include <vector>
+
+namespace Util {
+
+/*
+   A blob pack stores many Blobs in one file which is read back by mapping it
+   into memory, so that every entry is a zero-copy Blob slice of the mapping
+   found in O(1) by its index. Nothing is deserialized or allocated per entry.
+
+   File layout (all integers are 64-bit unless noted, and little-endian on
+   any host; the structs below are converted when written and read):
+
+     offset 0               PackHeader, padded to kPackPageSize
+     payloadOffset          payload: the entries' data back to back, each
+                            starting at a multiple of the writer's alignment
+     indexOffset            index: one PackEntry per entry, in append order
+
+   The payload and the index both start on a page boundary. The header is
+   written last, so a pack whose writer did not finish is never readable.
+
+   Entries stay valid after the reader is closed or destroyed: each one holds
+   a reference to the mapping, which is unmapped with the last of them.
+*/
+
+static const U64 kPackPageSize = 4096;
+
+struct PackHeader
+{
+  static const U32 kVersion = 1;
+
+  char magic[8];      // "BLOBPACK"
+  U32 version;        // kVersion
+  U32 alignment;      // alignment of each entry within the payload
+  U64 count;          // number of entries
+  U64 payloadOffset;
+  U64 payloadSize;
+  U64 indexOffset;
+};
+
+struct PackEntry
+{
+  U64 offset;         // from the start of the payload
+  U64 size;
+};
+
+// Writes a pack by appending Blobs. Small entries are gathered in a buffer
+// so the file is written in large pieces. Methods return false on I/O
+// errors (with errno set), after which the pack is unusable. The alignment
+// is a power of two no larger than kPackPageSize (0 means 1); open() fails
+// with EINVAL for any other.
+class PackWriter
+{
+ public:
+  PackWriter();
+  PackWriter(const PackWriter &) = delete;
+  PackWriter &operator=(const PackWriter &) = delete;
+  ~PackWriter();  // finishes the pack if still open
+  bool open(const std::string &path, U32 alignment = 1);
+  bool append(const BlobView &blob);
+  bool finish();
+  U64 count() const;
+
+ private:
+  bool write(const Byte *data, U64 size);
+  bool flush();
+  bool pad(U64 alignment);
+
+  int fd_;
+  U32 alignment_;
+  U64 offset_;                  // bytes written (or buffered) so far
+  std::vector<PackEntry> index_;
+  std::vector<Byte> buffer_;
+};
+
+// Maps a pack and returns its entries. A reader which failed to open (or was
+// never opened) has no entries.
+class PackReader
+{
+ public:
+  PackReader();
+  bool open(const std::string &path, Blob::CompareType compareType = Blob::CompareType::DEFAULT);
+  void close();
+  U64 count() const;
+
+  // The entry at 'index', or an empty Blob if 'index' is out of range or the
+  // entry lies outside of the payload
+  Blob operator[](U64 index) const;
+  BlobView view(U64 index) const;
+
+ private:
+  bool locate(U64 index, U64 *offset, U64 *size) const;
+
+  Blob payload_;                // a slice of the mapping
+  const PackEntry *index_;      // within the mapping
+  U64 count_;
+};
+
+} // namespace Util
+
+#endif // UTIL_BLOB_PACK_H
@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include "util/blob_pack.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+// A temporary file which is removed when it goes out of scope
+class TempPath
+{
+ public:
+  TempPath()
+  {
+    char name[] = "/tmp/blob_pack_test.XXXXXX";
+    int fd = mkstemp(name);
+    if (fd >= 0) {
+      close(fd);
+    }
+    path_ = name;
+  }
+  ~TempPath() { unlink(path_.c_str()); }
+  const string &path() const { return path_; }
+
+ private:
+  string path_;
+};
+
+} // anonymous namespace
+
+
+TEST(BlobPackTest, RoundTrip) {
+  TempPath tmp;
+  string big(100000, 'x');
+  big[99999] = 'y';
+  {
+    PackWriter writer;
+    ASSERT_TRUE(writer.open(tmp.path()));
+    EXPECT_TRUE(writer.append(Blob(string("hello"))));
+    EXPECT_TRUE(writer.append(Blob()));
+    EXPECT_TRUE(writer.append(Blob(big)));
+    EXPECT_TRUE(writer.append(Blob(string("world"))));
+    EXPECT_EQ(4U, writer.count());
+    EXPECT_TRUE(writer.finish());
+    EXPECT_FALSE(writer.append(Blob(string("late"))));
+  }
+
+  PackReader reader;
+  ASSERT_TRUE(reader.open(tmp.path(), Blob::CompareType::CONST));
+  ASSERT_EQ(4U, reader.count());
+  EXPECT_EQ(Blob(string("hello")), reader[0]);
+  EXPECT_EQ(0U, reader[1].size());
+  EXPECT_EQ(Blob(big), reader[2]);
+  EXPECT_EQ(Blob(string("world")), reader[3]);
+  EXPECT_EQ(Blob::CompareType::CONST, reader[0].compareType());
+  EXPECT_EQ(Blob(string("world")).view(), reader.view(3));
+
+  // Out of range
+  EXPECT_EQ(0U, reader[4].size());
+  EXPECT_EQ(0U, reader.view(4).size());
+
+  // Integers are stored little-endian: the count follows the magic, version
+  // and alignment
+  FILE *file = fopen(tmp.path().c_str(), "rb");
+  ASSERT_NE(nullptr, file);
+  Byte header[24];
+  EXPECT_EQ(sizeof(header), fread(header, 1, sizeof(header), file));
+  fclose(file);
+  EXPECT_EQ(1, header[8]);
+  EXPECT_EQ(1, header[12]);
+  EXPECT_EQ(4, header[16]);
+  for (U32 i = 17; i < 24; i++) {
+    EXPECT_EQ(0, header[i]);
+  }
+}
+
+TEST(BlobPackTest, Alignment) {
+  TempPath tmp;
+  PackWriter writer;
+  ASSERT_TRUE(writer.open(tmp.path(), 64));
+  for (U64 i = 1; i <= 10; i++) {
+    EXPECT_TRUE(writer.append(Blob(string(i * 7, (char)('a' + i)))));
+  }
+  EXPECT_TRUE(writer.finish());
+
+  PackReader reader;
+  ASSERT_TRUE(reader.open(tmp.path()));
+  ASSERT_EQ(10U, reader.count());
+  for (U64 i = 0; i < 10; i++) {
+    Blob entry = reader[i];
+    EXPECT_EQ(0U, (U64)entry.data() % 64);
+    EXPECT_EQ(Blob(string((i + 1) * 7, (char)('a' + i + 1))), entry);
+  }
+  // Alignments which do not divide the page would misalign the payload
+  for (U32 alignment : {3U, 96U, 8192U}) {
+    errno = 0;
+    EXPECT_FALSE(writer.open(tmp.path(), alignment));
+    EXPECT_EQ(EINVAL, errno);
+  }
+  ASSERT_TRUE(reader.open(tmp.path()));   // the file was left alone
+  EXPECT_EQ(10U, reader.count());
+  ASSERT_TRUE(writer.open(tmp.path(), 4096));
+  EXPECT_TRUE(writer.append(Blob(string("a"))));
+  EXPECT_TRUE(writer.append(Blob(string("b"))));
+  EXPECT_TRUE(writer.finish());
+  ASSERT_TRUE(reader.open(tmp.path()));
+  EXPECT_EQ(0U, (U64)reader[1].data() % 4096);
+}
+
+TEST(BlobPackTest, Invalid) {
+  TempPath tmp;
+  PackReader reader;
+
+  // Empty file, reported as such whatever errno held before
+  errno = ENOENT;
+  EXPECT_FALSE(reader.open(tmp.path()));
+  EXPECT_EQ(EINVAL, errno);
+  EXPECT_EQ(0U, reader.count());
+
+  // A writer which never finished leaves the header unwritten
+  {
+    PackWriter writer;
+    ASSERT_TRUE(writer.open(tmp.path()));
+    EXPECT_TRUE(writer.append(Blob(string(200000, 'z'))));
+    ASSERT_EQ(0, truncate(tmp.path().c_str(), 8192));
+    PackReader early;
+    EXPECT_FALSE(early.open(tmp.path()));
+  }
+
+  EXPECT_FALSE(reader.open("/nonexistent/blob_pack_test"));
+}
+
+TEST(BlobPackTest, EntriesOutliveReader) {
+  TempPath tmp;
+  {
+    PackWriter writer;
+    ASSERT_TRUE(writer.open(tmp.path()));
+    EXPECT_TRUE(writer.append(Blob(string("first"))));
+    EXPECT_TRUE(writer.append(Blob(string("second"))));
+  }  // finished by the destructor
+
+  Blob entry;
+  {
+    PackReader reader;
+    ASSERT_TRUE(reader.open(tmp.path()));
+    entry = reader[1];
+    reader.close();
+    EXPECT_EQ(0U, reader.count());
+  }
+  unlink(tmp.path().c_str());
+  EXPECT_EQ(Blob(string("second")), entry);
+}
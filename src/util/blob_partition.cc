@@ -0,0 +1,125 @@
+#include "util/blob_partition.h"
+#include <cstdint>
+
+using namespace Util;
+
+BlobPartition::State::State(MutableBlob &&_blob)
+  : blob(std::move(_blob)), outstanding(0)
+{
+  // empty
+}
+
+BlobPartition::BlobPartition()
+  : data_(nullptr), size_(0), offset_(0)
+{
+  // empty
+}
+
+BlobPartition::BlobPartition(std::shared_ptr<State> _state, Byte *_data, U64 _size, U64 _offset)
+  : state_(std::move(_state)), data_(_data), size_(_size), offset_(_offset)
+{
+  // empty
+}
+
+BlobPartition::BlobPartition(BlobPartition &&_other)
+  : state_(std::move(_other.state_)), data_(_other.data_), size_(_other.size_),
+  offset_(_other.offset_)
+{
+  _other.data_ = nullptr;
+  _other.size_ = 0;
+  _other.offset_ = 0;
+}
+
+BlobPartition &BlobPartition::operator=(BlobPartition &&_other)
+{
+  if (this != &_other) {
+    release();
+    state_ = std::move(_other.state_);
+    data_ = _other.data_;
+    size_ = _other.size_;
+    offset_ = _other.offset_;
+    _other.data_ = nullptr;
+    _other.size_ = 0;
+    _other.offset_ = 0;
+  }
+  return *this;
+}
+
+BlobPartition::~BlobPartition()
+{
+  release();
+}
+
+void BlobPartition::release()
+{
+  if (state_) {
+    // The lock orders this partition's writes before join() returns
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (--state_->outstanding == 0) {
+      state_->released.notify_all();
+    }
+  }
+  state_.reset();
+  data_ = nullptr;
+  size_ = 0;
+  offset_ = 0;
+}
+
+
+// Each boundary is rounded up to the next cache line of the data's address
+PartitionedBlob::PartitionedBlob(MutableBlob &&_blob, U32 _count)
+  : state_(std::make_shared<BlobPartition::State>(std::move(_blob))),
+  data_(state_->blob.data()), bounds_((_count == 0 ? 1 : _count) + 1UL, 0),
+  taken_(bounds_.size() - 1, false), joined_(false)
+{
+  const U64 size = state_->blob.size();
+  const uintptr_t base = (uintptr_t)data_;
+  const U64 parts = taken_.size();
+  const U64 share = (size + parts - 1) / parts;
+  for (U64 i = 1; i < parts; i++) {
+    uintptr_t end = (base + i * share + kLineSize - 1) & ~(uintptr_t)(kLineSize - 1);
+    U64 bound = (U64)(end - base);
+    bounds_[i] = bound < size ? bound : size;
+  }
+  bounds_[parts] = size;
+}
+
+U32 PartitionedBlob::count() const
+{
+  return (U32)taken_.size();
+}
+
+U64 PartitionedBlob::size() const
+{
+  return bounds_.back();
+}
+
+BlobPartition PartitionedBlob::take(U32 _index)
+{
+  if (joined_ || _index >= taken_.size() || taken_[_index]) {
+    return BlobPartition();
+  }
+  taken_[_index] = true;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->outstanding++;
+  }
+  U64 offset = bounds_[_index];
+  return BlobPartition(state_, &data_[offset], bounds_[_index + 1] - offset, offset);
+}
+
+Blob PartitionedBlob::join()
+{
+  if (joined_) {
+    return whole_;
+  }
+  joined_ = true;
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  while (state_->outstanding > 0) {
+    state_->released.wait(lock);
+  }
+  // Nothing writes the data any more, so let its readers cache checksums
+  whole_ = Blob(state_->blob, state_->blob.size());
+  state_->blob.dataIsNull();
+  return whole_;
+}
@@ -0,0 +1,134 @@
+#ifndef UTIL_BLOB_PARTITION_H
+#define UTIL_BLOB_PARTITION_H
+
+#include "util/blob.h"
+#include "util/fixed_types.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Util {
+
+/*
+   A PartitionedBlob fills one MutableBlob from several threads. It takes
+   the MutableBlob over and splits its data into disjoint partitions, each a
+   writable range which can be moved to its own thread, so the single-writer
+   rule holds per partition with no locking while writing.
+
+   Every partition but the first starts on a cache line (kLineSize), so no
+   two threads ever write to the same line. A partition keeps the data alive
+   on its own and is released when it is destroyed or release() is called.
+   join() waits until every partition handed out has been released and then
+   returns all of the data as one Blob, without copying it.
+
+     Util::PartitionedBlob parts(Util::MutableBlob(size), threads);
+     for (U32 i = 0; i < parts.count(); i++) {
+       std::thread([] (Util::BlobPartition part) {
+         fill(part.data(), part.size(), part.offset());
+       }, parts.take(i)).detach();
+     }
+     Util::Blob whole = parts.join();
+
+   Partitions are handed out by the owning thread: take() and join() are
+   not to be called concurrently.
+*/
+
+class PartitionedBlob;
+
+// A writable range of a PartitionedBlob. It is move-only, like MutableBlob.
+class BlobPartition
+{
+ public:
+  BlobPartition();
+  BlobPartition(const BlobPartition &) = delete;
+  BlobPartition(BlobPartition &&other);
+  BlobPartition &operator=(const BlobPartition &) = delete;
+  BlobPartition &operator=(BlobPartition &&other);
+  ~BlobPartition();
+
+  Byte &operator[](U64 index);
+  Byte *data();
+  U64 size() const;
+
+  // Where the partition starts in the whole data
+  U64 offset() const;
+
+  // Give up write access; the partition is empty afterwards
+  void release();
+
+ private:
+  friend class PartitionedBlob;
+  struct State;
+  BlobPartition(std::shared_ptr<State> state, Byte *data, U64 size, U64 offset);
+
+  std::shared_ptr<State> state_;
+  Byte *data_;
+  U64 size_;
+  U64 offset_;
+};
+
+class PartitionedBlob
+{
+ public:
+  static const U64 kLineSize = 64;
+
+  // At least one partition; partitions of small data may be empty
+  PartitionedBlob(MutableBlob &&blob, U32 count);
+  PartitionedBlob(const PartitionedBlob &) = delete;
+  PartitionedBlob &operator=(const PartitionedBlob &) = delete;
+
+  U32 count() const;
+  U64 size() const;
+
+  // Partition 'index'. Each is handed out once; taking it again, or after
+  // join(), returns an empty partition.
+  BlobPartition take(U32 index);
+
+  // Blocks until every partition taken has been released. Later calls
+  // return the same data.
+  Blob join();
+
+ private:
+  std::shared_ptr<BlobPartition::State> state_;
+  Byte *data_;
+  std::vector<U64> bounds_;   // count() + 1 offsets
+  std::vector<bool> taken_;
+  bool joined_;
+  Blob whole_;
+};
+
+// The data and the number of partitions still out, shared by the partitions
+struct BlobPartition::State
+{
+  explicit State(MutableBlob &&blob);
+
+  MutableBlob blob;
+  std::mutex mutex;
+  std::condition_variable released;
+  U32 outstanding;
+};
+
+inline Byte &BlobPartition::operator[](U64 _index)
+{
+  return data_[_index];
+}
+
+inline Byte *BlobPartition::data()
+{
+  return data_;
+}
+
+inline U64 BlobPartition::size() const
+{
+  return size_;
+}
+
+inline U64 BlobPartition::offset() const
+{
+  return offset_;
+}
+
+} // namespace Util
+
+#endif // UTIL_BLOB_PARTITION_H
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "util/blob_partition.h"
+#include "util/blob.h"
+#include "util/byte_encoders.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace Util;
+
+TEST(BlobPartitionTest, Bounds) {
+  for (U64 size : {0UL, 1UL, 100UL, 1000UL, 65536UL, 100003UL}) {
+    for (U32 count : {0U, 1U, 3U, 8U}) {
+      PartitionedBlob parts(MutableBlob(size), count);
+      EXPECT_EQ(count == 0 ? 1U : count, parts.count());
+      EXPECT_EQ(size, parts.size());
+      U64 end = 0;
+      const Byte *base = nullptr;
+      for (U32 i = 0; i < parts.count(); i++) {
+        BlobPartition part = parts.take(i);
+        if (i == 0) {
+          base = part.data();
+        }
+        // Contiguous, and each after the first starts on a cache line
+        EXPECT_EQ(end, part.offset());
+        EXPECT_EQ(&base[end], part.data());
+        if (i > 0 && part.size() > 0) {
+          EXPECT_EQ(0U, (uintptr_t)part.data() % PartitionedBlob::kLineSize);
+        }
+        end += part.size();
+      }
+      EXPECT_EQ(size, end);
+    }
+  }
+}
+
+TEST(BlobPartitionTest, Threads) {
+  const U64 size = 1 << 20;
+  MutableBlob buffer(size);
+  const Byte *original = buffer.data();
+  PartitionedBlob parts(std::move(buffer), 4);
+
+  // Each taken once
+  BlobPartition first = parts.take(0);
+  EXPECT_EQ(0UL, parts.take(0).size());
+  EXPECT_EQ(0UL, parts.take(4).size());
+
+  std::vector<std::thread> writers;
+  writers.emplace_back([] (BlobPartition part) {
+    for (U64 i = 0; i < part.size(); i++) {
+      part[i] = (Byte)(part.offset() + i);
+    }
+  }, std::move(first));
+  for (U32 t = 1; t < parts.count(); t++) {
+    writers.emplace_back([] (BlobPartition part) {
+      for (U64 i = 0; i < part.size(); i++) {
+        part.data()[i] = (Byte)(part.offset() + i);
+      }
+    }, parts.take(t));
+  }
+  Blob whole = parts.join();
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+
+  // Rejoined without a copy
+  EXPECT_EQ(original, whole.data());
+  ASSERT_EQ(size, whole.size());
+  for (U64 i = 0; i < size; i++) {
+    ASSERT_EQ((Byte)i, whole[i]);
+  }
+  EXPECT_EQ(0UL, parts.take(1).size());
+
+  // Joined data is no longer writable, so it caches like any other
+  EXPECT_EQ(whole.data(), parts.join().data());
+  EXPECT_EQ(whole.cachedEncode<Hex>(), whole.cachedEncode<Hex>());
+}
+
+TEST(BlobPartitionTest, JoinWaits) {
+  PartitionedBlob parts(MutableBlob(256), 2);
+  BlobPartition held = parts.take(1);
+  const U64 offset = held.offset();
+  std::atomic<bool> released(false);
+  std::thread holder([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    held[0] = 42;
+    released = true;
+    held.release();
+    EXPECT_EQ(0UL, held.size());
+  });
+  Blob whole = parts.join();   // partition 0 was never taken
+  EXPECT_TRUE(released);
+  EXPECT_EQ(42, whole[offset]);
+  holder.join();
+
+  // Partitions keep the data alive on their own
+  BlobPartition survivor;
+  {
+    PartitionedBlob temporary(MutableBlob(128), 1);
+    survivor = temporary.take(0);
+  }
+  survivor[127] = 1;
+  EXPECT_EQ(128UL, survivor.size());
+}
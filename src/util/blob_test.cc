@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 #include "util/blob.h"
+#include "util/compare.h"
 #include <cstring>
+#include <string>
+#include <vector>
 
 using namespace Util;
 using std::string;
@@ -95,6 +98,15 @@ TEST(BlobTest, Equals) {
   // Same data, same lengths, same pointers
   EXPECT_FALSE(b3 != b7);
   EXPECT_TRUE(b3 == b7);
+
+  // The comparators return true when not equal
+  for (const Blob::Comparator &differ : {Blob::Comparator(compare_memcmp),
+                                         Blob::Comparator(compare_constant)}) {
+    EXPECT_TRUE(differ(b1, b2));
+    EXPECT_TRUE(differ(b2, b3));
+    EXPECT_FALSE(differ(b2, b6));
+    EXPECT_FALSE(differ(Blob(), Blob()));
+  }
 }
 
 TEST(BlobTest, ArrayOperator) {
@@ -142,3 +154,178 @@ TEST(BlobTest, MutableWrite) {
   EXPECT_EQ(0x4, b1[3]);
 }
 
+
+TEST(BlobTest, View) {
+  Blob blob(buf1, 4, Blob::ScrubType::ZEROS, Blob::CompareType::CONST);
+  BlobView view = blob.view();
+  EXPECT_EQ(blob.data(), view.data());
+  EXPECT_EQ(blob.size(), view.size());
+  EXPECT_EQ(Blob::ScrubType::ZEROS, view.scrubType());
+  EXPECT_EQ(Blob::CompareType::CONST, view.compareType());
+
+  // Slicing clamps to the viewed data like Blob slices
+  BlobView tail(view, 3, 1);
+  EXPECT_EQ(blob.data() + 1, tail.data());
+  EXPECT_EQ(3UL, tail.size());
+  EXPECT_EQ(0x2, tail[0]);
+  EXPECT_EQ(0UL, BlobView(view, 2, 5).size());
+  EXPECT_EQ(2UL, BlobView(view, 8, 2).size());
+
+  // Comparison with views and Blobs, of either compare type
+  EXPECT_TRUE(tail == BlobView(buf1 + 1, 3));
+  EXPECT_TRUE(tail != BlobView(buf1, 3));
+  EXPECT_TRUE(view == blob);
+  EXPECT_TRUE(BlobView(buf2, 3) == Blob(buf1, 3));
+  EXPECT_EQ(Blob::Comparison::EQ, tail.compare(Blob(buf1 + 1, 3), Blob::CompareType::DEFAULT));
+  EXPECT_EQ(Blob::Comparison::NE, tail.compare(BlobView(buf1, 4), Blob::CompareType::CONST));
+  EXPECT_TRUE(BlobView() == Blob());
+
+  // Promotion by copying keeps the view's types
+  Blob copy(tail);
+  EXPECT_NE(tail.data(), copy.data());
+  EXPECT_TRUE(copy == tail);
+  EXPECT_EQ(Blob::ScrubType::ZEROS, copy.scrubType());
+  EXPECT_EQ(Blob::CompareType::CONST, copy.compareType());
+
+  // Promotion by sharing the owner's data, or copying what lies outside it
+  Blob shared(blob, tail);
+  EXPECT_EQ(tail.data(), shared.data());
+  EXPECT_EQ(tail.size(), shared.size());
+  Blob outside(blob, BlobView(buf3, 3));
+  EXPECT_NE((const Byte *)buf3, outside.data());
+  EXPECT_TRUE(outside == Blob(buf3, 3));
+
+  // Shared promotions keep the data alive
+  BlobView kept;
+  {
+    Blob owner(buf3, 3);
+    Blob field(owner, BlobView(owner, 2, 1));
+    owner = Blob();
+    kept = field.view();
+    EXPECT_EQ(0xb, kept[0]);
+    EXPECT_EQ(0xc, kept[1]);
+  }
+}
+
+TEST(BlobTest, Adopt) {
+  // A raw buffer is freed by its deleter, after scrubbing
+  Byte *buffer = new Byte[4];
+  memcpy((void *)buffer, (const void *)buf1, 4);
+  int deleted = 0;
+  bool scrubbed = false;
+  {
+    Blob adopted(buffer, 4, Blob::ScrubType::ZEROS, Blob::CompareType::DEFAULT,
+      [&deleted, &scrubbed] (Byte *_data, U64 _size) {
+        scrubbed = (_size == 4) && (_data[0] == 0) && (_data[3] == 0);
+        deleted++;
+        delete[] _data;
+      });
+    EXPECT_EQ(buffer, adopted.data());
+    Blob slice(adopted, 2, 1);
+    adopted = Blob();
+    EXPECT_EQ(0, deleted);
+    EXPECT_EQ(0x2, slice[0]);
+  }
+  EXPECT_EQ(1, deleted);
+  EXPECT_TRUE(scrubbed);
+
+  // Strings and vectors hand over their storage
+  string text(1000, 't');
+  const char *textData = text.data();
+  Blob fromString(std::move(text), Blob::ScrubType::ZEROS);
+  EXPECT_EQ((const Byte *)textData, fromString.data());
+  EXPECT_EQ(1000UL, fromString.size());
+  EXPECT_EQ(Blob::ScrubType::ZEROS, fromString.scrubType());
+
+  std::vector<Byte> bytes(buf3, buf3 + 3);
+  const Byte *bytesData = bytes.data();
+  Blob fromVector(std::move(bytes));
+  EXPECT_EQ(bytesData, fromVector.data());
+  EXPECT_EQ(Blob(buf3, 3), fromVector);
+
+  // Short strings hold their characters inline, so those are copied
+  string shortText("key");
+  Blob fromShort(std::move(shortText), Blob::ScrubType::ZEROS);
+  EXPECT_EQ(Blob(string("key")), fromShort);
+  EXPECT_TRUE(shortText.empty());
+
+  // As are strings too short to be worth adopting
+  string smallText(Blob::kCopyBelow - 1, 's');
+  const char *smallData = smallText.data();
+  Blob fromSmall(std::move(smallText), Blob::ScrubType::ZEROS);
+  EXPECT_NE((const Byte *)smallData, fromSmall.data());
+  EXPECT_EQ(Blob(string(Blob::kCopyBelow - 1, 's')), fromSmall);
+  EXPECT_TRUE(smallText.empty());
+  string justLarge(Blob::kCopyBelow, 'l');
+  const char *largeData = justLarge.data();
+  EXPECT_EQ((const Byte *)largeData, Blob(std::move(justLarge)).data());
+
+  Blob reassigned;
+  reassigned.dataIs(string(500, 'r'));
+  EXPECT_EQ(500UL, reassigned.size());
+  reassigned.dataIs(std::vector<Byte>(buf2, buf2 + 3), Blob::ScrubType::NONE,
+    Blob::CompareType::CONST);
+  EXPECT_EQ(Blob(buf2, 3), reassigned);
+  EXPECT_EQ(Blob::CompareType::CONST, reassigned.compareType());
+}
+
+TEST(BlobTest, Compact) {
+  MutableBlob big(1 << 20, Blob::ScrubType::ZEROS, Blob::CompareType::CONST);
+  memset((void *)big.data(), 0x5a, big.size());
+  Blob key(big, 40, 1000);
+
+  // Slices using at least the threshold stay shared
+  EXPECT_FALSE(key.compact(0.00001));
+  EXPECT_EQ(big.data() + 1000, key.data());
+
+  EXPECT_TRUE(key.compact(0.01));
+  EXPECT_NE(big.data() + 1000, key.data());
+  EXPECT_EQ(40UL, key.size());
+  EXPECT_EQ(Blob(big, 40, 1000), key);
+  EXPECT_EQ(Blob::ScrubType::ZEROS, key.scrubType());
+  EXPECT_EQ(Blob::CompareType::CONST, key.compareType());
+
+  // Now the only user of its container
+  EXPECT_FALSE(key.compact(0.5));
+  EXPECT_FALSE(Blob().compact(0.5));
+}
+
+#ifdef UTIL_CONTAINER_PINNING
+TEST(BlobTest, Pinning) {
+  PinningReport before = Container::pinning(0);
+  EXPECT_TRUE(before.enabled);
+  Blob key;
+  {
+    Blob big(1 << 20);
+    key = Blob(big, 40, 1000);
+    Blob copy(key);
+    PinningReport during = Container::pinning(0);
+    EXPECT_EQ(before.containers + 1, during.containers);
+    EXPECT_EQ(before.pinnedBytes + (1 << 20), during.pinnedBytes);
+    // References beyond the container's size are capped
+    EXPECT_EQ(before.referencedBytes + (1 << 20), during.referencedBytes);
+  }
+
+  // Only the key pins the buffer now
+  PinningReport pinned = Container::pinning(1);
+  EXPECT_EQ(before.pinnedBytes + (1 << 20), pinned.pinnedBytes);
+  EXPECT_EQ(before.referencedBytes + 40, pinned.referencedBytes);
+  ASSERT_EQ(1U, pinned.worst.size());
+  EXPECT_EQ(1UL << 20, pinned.worst[0].size);
+  EXPECT_EQ(40U, pinned.worst[0].referencedBytes);
+  EXPECT_EQ(1U, pinned.worst[0].blobs);
+
+  key.compact(0.01);
+  PinningReport after = Container::pinning(0);
+  EXPECT_EQ(before.pinnedBytes + 40, after.pinnedBytes);
+  EXPECT_EQ(before.referencedBytes + 40, after.referencedBytes);
+}
+#else
+TEST(BlobTest, PinningDisabled) {
+  Blob big(1 << 20);
+  PinningReport report = Container::pinning();
+  EXPECT_FALSE(report.enabled);
+  EXPECT_EQ(0U, report.containers);
+  EXPECT_TRUE(report.worst.empty());
+}
+#endif
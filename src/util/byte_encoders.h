@@ -4,394 +4,1100 @@
 #include "util/fixed_types.h"
 #include "util/make_unique.h"
 #include "util/blob.h"
+#include "util/codec.h"
+#include "util/codec_kernels.h"
 #include <cstddef>  // C++11 include fix for GMP up to 5.1.3
 #include <gmpxx.h>
+#include <cstring>
+#include <algorithm>
 #include <string>
 #include <functional>
 #include <memory>
 
 namespace Util {
 
+/*
+   Byte encoders convert binary data to text and back. Each encoding is a
+   codec class (see codec.h for the interface) which can be used at compile
+   time with Blob::encode<Codec>() and Blob::decode<Codec>(). Decoders
+   validate their input in the same pass as decoding and report the offset
+   of the first invalid character; large inputs are decoded with vectorized
+   kernels from codec_kernels.h where available.
+
+   The lambdas 'encode_*' and 'decode_*' adapt each codec to the run-time
+   Blob::Encoder and Blob::Decoder interfaces. The decoders return an empty
+   Blob when the input is not valid.
+*/
+
+// Adapt a codec to the Blob::Encoder interface
+template<typename Codec>
+std::unique_ptr<std::string> encodeWith(const Byte *data, U64 size)
+{
+  std::unique_ptr<std::string> outputPtr(new std::string(Codec::encodedSize(size), '\0'));
+  std::string &output = *outputPtr.get();
+  output.resize(Codec::encode(data, size, &output[0]));
+  return outputPtr;
+}
+
+// Adapt a codec to the Blob::Decoder interface
+template<typename Codec>
+std::unique_ptr<Blob> decodeWith(const Byte *data, U64 size)
+{
+  return Util::make_unique<Blob>(Blob::decode<Codec>(data, size));
+}
+
+// The offset of the first of 'count' characters at 'offset' which is not a
+// digit in the given decode table (one of them is known to be invalid)
+inline U64 firstInvalid(const Byte *table, const Byte *data, U64 offset, U64 count)
+{
+  for (U64 i = offset; i < offset + count; i++) {
+    if (table[data[i]] & 0x80) {
+      return i;
+    }
+  }
+  return offset + count;
+}
+
 
 // *** String Encoder ***
-auto encode_string = [] (const Byte *data, U64 size)
+struct String
+{
+  static const U64 kBlockSize = 1;
+  static const U64 kTextBlockSize = 1;
+
+  static U64 encodedSize(U64 size)
+  {
+    return size;
+  }
+
+  static U64 encode(const Byte *data, U64 size, char *out)
+  {
+    memcpy((void *)out, (const void *)data, size);
+    return size;
+  }
+
+  static U64 decodedSize(const Byte *, U64 size)
+  {
+    return size;
+  }
+
+  static DecodeStatus decode(const Byte *data, U64 size, Byte *out)
+  {
+    memcpy((void *)out, (const void *)data, size);
+    return DecodeStatus::success(size);
+  }
+};
+
+const auto encode_string = [] (const Byte *data, U64 size)
 {
   return Util::make_unique<std::string>((const char *)data, size);
 };
 
 
 // *** Base 2 (Binary) Encoder ***
-auto encode_bin = [] (const Byte *data, U64 size)
+struct Bin
 {
-  const U64 outputSize = 8 * size;
-  std::unique_ptr<std::string> outputPtr(new std::string);
-  std::string &output = *outputPtr.get();
-  output.reserve(outputSize);
-
-  Byte bin[8];
-  for (U64 i = 0; i < size; i++) {
-    bin[0] = 0x30 | (data[i] >> 7);
-    bin[1] = 0x30 | ((data[i] >> 6) & 0x1);
-    bin[2] = 0x30 | ((data[i] >> 5) & 0x1);
-    bin[3] = 0x30 | ((data[i] >> 4) & 0x1);
-    bin[4] = 0x30 | ((data[i] >> 3) & 0x1);
-    bin[5] = 0x30 | ((data[i] >> 2) & 0x1);
-    bin[6] = 0x30 | ((data[i] >> 1) & 0x1);
-    bin[7] = 0x30 | (data[i] & 0x1);
-    output.append((const char *)bin, 8);
+  static const U64 kBlockSize = 1;
+  static const U64 kTextBlockSize = 8;
+
+  static U64 encodedSize(U64 size)
+  {
+    return 8 * size;
   }
-  return outputPtr;
-};
 
-auto decode_bin = [] (const Byte *data, U64 size)
-{
-  size &= ~0x7UL;
-  U64 outSize = size / 8;
+  static U64 encode(const Byte *data, U64 size, char *out)
+  {
+    for (U64 i = 0; i < size; i++) {
+      *out++ = (char)(0x30 | (data[i] >> 7));
+      *out++ = (char)(0x30 | ((data[i] >> 6) & 0x1));
+      *out++ = (char)(0x30 | ((data[i] >> 5) & 0x1));
+      *out++ = (char)(0x30 | ((data[i] >> 4) & 0x1));
+      *out++ = (char)(0x30 | ((data[i] >> 3) & 0x1));
+      *out++ = (char)(0x30 | ((data[i] >> 2) & 0x1));
+      *out++ = (char)(0x30 | ((data[i] >> 1) & 0x1));
+      *out++ = (char)(0x30 | (data[i] & 0x1));
+    }
+    return 8 * size;
+  }
 
-  MutableBlob outBlob(outSize);
-  Byte *out = outBlob.data();
-  U64 inPos = 0;
+  static U64 decodedSize(const Byte *, U64 size)
+  {
+    return size / 8;
+  }
+
+  // Each character must be '0' or '1' and the size a multiple of 8
+  static DecodeStatus decode(const Byte *data, U64 size, Byte *out)
+  {
+    U64 outSize = size / 8;
 
-  for (U64 i = 0; i < outSize; i++) {
-    out[i]  = (data[inPos++] & 0x1) << 7;
-    out[i] |= (data[inPos++] & 0x1) << 6;
-    out[i] |= (data[inPos++] & 0x1) << 5;
-    out[i] |= (data[inPos++] & 0x1) << 4;
-    out[i] |= (data[inPos++] & 0x1) << 3;
-    out[i] |= (data[inPos++] & 0x1) << 2;
-    out[i] |= (data[inPos++] & 0x1) << 1;
-    out[i] |=  data[inPos++] & 0x1;
+    for (U64 i = 0; i < outSize; i++) {
+      U64 word;
+      memcpy((void *)&word, (const void *)&data[8 * i], 8);
+      if ((word & ~0x0101010101010101UL) != 0x3030303030303030UL) {
+        U64 j = 8 * i;
+        while ((data[j] & 0xfe) == 0x30) {
+          j++;
+        }
+        return DecodeStatus::failure(j);
+      }
+      // Gather the low bit of each character, first character highest
+      out[i] = (Byte)(((word & 0x0101010101010101UL) * 0x8040201008040201UL) >> 56);
+    }
+    if (size % 8 != 0) {
+      return DecodeStatus::failure(8 * outSize);
+    }
+    return DecodeStatus::success(outSize);
   }
-  return Util::make_unique<Blob>(outBlob);
+};
+
+const auto encode_bin = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Bin>(data, size);
+};
+
+const auto decode_bin = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Bin>(data, size);
 };
 
 
 // *** Base 16 (Hex) Encoder ***
-auto encode_hex = [] (const Byte *data, U64 size)
+struct Hex
 {
-  static const char hex[16] =
-      {'0', '1', '2', '3', '4', '5', '6', '7',
-       '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+  static const U64 kBlockSize = 1;
+  static const U64 kTextBlockSize = 2;
 
-  const U64 outputSize = 2 * size;
-  std::unique_ptr<std::string> outputPtr(new std::string());
-  std::string &output = *outputPtr.get();
-  output.reserve(outputSize);
+  static U64 encodedSize(U64 size)
+  {
+    return 2 * size;
+  }
 
-  for (U64 i = 0; i < size; i++) {
-    output.push_back(hex[(data[i] >> 4)]);
-    output.push_back(hex[(data[i] & 0xf)]);
+  static U64 encode(const Byte *data, U64 size, char *out)
+  {
+    static const char hex[16] =
+        {'0', '1', '2', '3', '4', '5', '6', '7',
+         '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+    U64 i = 0;
+    if (size >= 16) {
+      i = Kernels::encode_hex_bulk(data, size, out);
+    }
+    for (; i < size; i++) {
+      out[2 * i] = hex[(data[i] >> 4)];
+      out[2 * i + 1] = hex[(data[i] & 0xf)];
+    }
+    return 2 * size;
+  }
+
+  static U64 decodedSize(const Byte *, U64 size)
+  {
+    return size / 2;
+  }
+
+  // Digits may be upper or lower case; a dangling nibble is invalid
+  static DecodeStatus decode(const Byte *data, U64 size, Byte *out)
+  {
+    U64 i = 0;
+    if (size >= 64) {
+      i = Kernels::decode_hex_bulk(data, size & ~0x1UL, out);
+    }
+    for (; i + 1 < size; i += 2) {
+      Byte nib1 = Kernels::kHexValues[data[i]];
+      Byte nib2 = Kernels::kHexValues[data[i + 1]];
+      if ((nib1 | nib2) & 0x80) {
+        return DecodeStatus::failure((nib1 & 0x80) ? i : i + 1);
+      }
+      out[i / 2] = (Byte)((nib1 << 4) | nib2);
+    }
+    if (size & 0x1) {
+      return DecodeStatus::failure(size - 1);
+    }
+    return DecodeStatus::success(size / 2);
   }
-  return outputPtr;
 };
 
-auto decode_hex = [] (const Byte *data, U64 size)
+const auto encode_hex = [] (const Byte *data, U64 size)
 {
-  // Ignore a dangling nibble if present
-  size &= ~0x1UL;
+  return encodeWith<Hex>(data, size);
+};
 
-  U64 outSize = size / 2;
-  MutableBlob outBlob(outSize);
-  Byte *out = outBlob.data();
-  U64 inPos = 0;
+const auto decode_hex = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Hex>(data, size);
+};
 
-  for (U64 i = 0; i < outSize; i++) {
-    Byte nib1 = data[inPos++];
-    Byte nib2 = data[inPos++];
-    nib1 -= (nib1 > 0x40) ? 0x37 : 0x30;
-    nib2 -= (nib2 > 0x40) ? 0x37 : 0x30;
-    out[i] = (nib1 << 4) | nib2;
+
+// *** Base 32 Encoder family ***
+//
+// Each group of 5 bytes becomes 8 digits. 'Alphabet' supplies the digits
+// ('digits()') and a decode table ('values()'); both alphabets decode either
+// case. With 'Pad' the final group is padded with '=' to 8 digits, which
+// decoding then requires exactly.
+struct Base32StandardAlphabet
+{
+  static const char *digits()
+  {
+    return "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+  }
+
+  static const Byte *values()
+  {
+    return Kernels::kBase32Values;
   }
-  return make_unique<Blob>(outBlob);
 };
 
+// Crockford's alphabet omits I, L, O and U; I and L decode as 1 and O as 0.
+// The optional hyphens and check digit are not supported.
+struct Base32CrockfordAlphabet
+{
+  static const char *digits()
+  {
+    return "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+  }
 
-// *** Base 58 Encoder (Bitcoin-like encoding) ***
-auto encode_base58 = [] (const Byte *data, U64 size)
+  static const Byte *values()
+  {
+    return Kernels::kBase32CrockfordValues;
+  }
+};
+
+template<typename Alphabet, bool Pad>
+struct Base32Codec
 {
-  static const char *b58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+  static const U64 kBlockSize = 5;
+  static const U64 kTextBlockSize = 8;
+
+  static U64 encodedSize(U64 size)
+  {
+    U64 stragglers = size % 5;
+    return (size / 5) * 8 + ((stragglers == 0) ? 0 : (Pad ? 8 : tailDigits(stragglers)));
+  }
 
-  // Count leading zeros
-  U64 leadingZeros = 0;
-  for (U64 i = 0; i < size; i++) {
-    if (data[i] == 0x00) {
-      leadingZeros += 1;
+  static U64 encode(const Byte *data, U64 size, char *out)
+  {
+    const char *digits = Alphabet::digits();
+    char *pos = out;
+    U64 i = 0;
+    if (size >= 32) {
+      i = Kernels::encode_base32_bulk(data, size, pos, digits);
+      pos += (i / 5) * 8;
+    }
+    for (; i + 5 <= size; i += 5) {
+      encodeGroup(&data[i], pos, digits);
+      pos += 8;
     }
-    else {
-      break;
+    U64 stragglers = size - i;
+    if (stragglers != 0) {
+      Byte group[5] = {0, 0, 0, 0, 0};
+      char chars[8];
+      memcpy((void *)group, (const void *)&data[i], stragglers);
+      encodeGroup(group, chars, digits);
+      U64 n = tailDigits(stragglers);
+      memcpy((void *)pos, (const void *)chars, n);
+      pos += n;
+      for (; Pad && (n < 8); n++) {
+        *pos++ = '=';
+      }
     }
+    return (U64)(pos - out);
   }
-  // Ouput reserve size: log(256) / log(58), rounded up
-  const U64 reserve = (size - leadingZeros) * 138 / 100 + 1 + leadingZeros;
 
-  std::unique_ptr<Byte[]> outPtr(new Byte[reserve]);
-  Byte *out = outPtr.get();
-  Byte *pos = &out[reserve];
+  // Padding only makes this an over-estimate
+  static U64 decodedSize(const Byte *, U64 size)
+  {
+    return (size / 8) * 5 + ((size % 8) * 5) / 8;
+  }
+
+  static DecodeStatus decode(const Byte *data, U64 size, Byte *out)
+  {
+    const Byte *values = Alphabet::values();
+
+    U64 end = size;
+    U64 padding = 0;
+    while (Pad && (padding < 6) && (end > 0) && (data[end - 1] == '=')) {
+      end--;
+      padding++;
+    }
 
-  mpz_class d("58");  // divisor
-  mpz_class n, r;     // dividend and remainder
-  mpz_import(n.get_mpz_t(), size, 1, 1, 0, 0, data);
+    Byte *pos = out;
+    U64 i = 0;
+    if (end >= 64) {
+      i = Kernels::decode_base32_bulk(data, end, pos, values);
+      pos += (i / 8) * 5;
+    }
+    for (; i + 8 <= end; i += 8) {
+      U64 bad = decodeGroup(&data[i], pos, values);
+      if (bad < 8) {
+        return DecodeStatus::failure(i + bad);
+      }
+      pos += 5;
+    }
 
-  while (mpz_get_ui(n.get_mpz_t()) != 0U) {
-    pos--;
-    mpz_fdiv_qr(n.get_mpz_t(), r.get_mpz_t(), n.get_mpz_t(), d.get_mpz_t());
-    *pos = (Byte) b58[mpz_get_ui(r.get_mpz_t())];
+    // The final partial group: 2, 4, 5 or 7 digits (or nothing)
+    U64 stragglers = end - i;
+    if ((stragglers == 1) || (stragglers == 3) || (stragglers == 6)) {
+      return DecodeStatus::failure(end - 1);
+    }
+    if (stragglers != 0) {
+      Byte chars[8];
+      Byte group[5];
+      memset((void *)chars, Alphabet::digits()[0], 8);
+      memcpy((void *)chars, (const void *)&data[i], stragglers);
+      U64 bad = decodeGroup(chars, group, values);
+      if (bad < stragglers) {
+        return DecodeStatus::failure(i + bad);
+      }
+      U64 n = (stragglers * 5) / 8;
+      memcpy((void *)pos, (const void *)group, n);
+      pos += n;
+    }
+
+    // Padding must complete the final group exactly
+    U64 expected = (stragglers == 0) ? 0 : 8 - stragglers;
+    if (Pad && (padding != expected)) {
+      return DecodeStatus::failure(end + ((padding < expected) ? padding : expected));
+    }
+    return DecodeStatus::success((U64)(pos - out));
+  }
+
+ private:
+  // The digits needed for a final group of 1 to 4 bytes
+  static U64 tailDigits(U64 stragglers)
+  {
+    return (stragglers * 8 + 4) / 5;
   }
-  for (U64 i = 0; i < leadingZeros; i++) {
-    pos--;
-    *pos = (Byte) b58[0];
+
+  static void encodeGroup(const Byte *in, char *out, const char *digits)
+  {
+    U64 n = ((U64)in[0] << 32) | ((U64)in[1] << 24) | ((U64)in[2] << 16) |
+      ((U64)in[3] << 8) | in[4];
+    for (int j = 0; j < 8; j++) {
+      out[j] = digits[(n >> (35 - 5 * j)) & 0x1f];
+    }
+  }
+
+  // Decode 8 digits into 5 bytes; returns the index of the first invalid
+  // digit, or 8 if all are valid
+  static U64 decodeGroup(const Byte *in, Byte *out, const Byte *values)
+  {
+    U64 n = 0;
+    Byte invalid = 0;
+    for (int j = 0; j < 8; j++) {
+      Byte v = values[in[j]];
+      invalid |= v;
+      n = (n << 5) | v;
+    }
+    if (invalid & 0x80) {
+      return firstInvalid(values, in, 0, 8);
+    }
+    out[0] = (Byte)(n >> 32);
+    out[1] = (Byte)(n >> 24);
+    out[2] = (Byte)(n >> 16);
+    out[3] = (Byte)(n >> 8);
+    out[4] = (Byte)n;
+    return 8;
   }
-  U64 encodedSize = (U64)(&out[reserve] - pos);
-  return make_unique<std::string>((char *)pos, encodedSize);
 };
 
-/* TODO see if this or the other is faster
-auto decode_base58 = [] (const Byte *data, U64 size)
-{
-  static const char *b58 =
-    "\x00\x01\x02\x03\x04\x05\x06\x07\x08\xff\xff\xff\xff\xff\xff\xff\x09\x0A\x0B\x0C"
-    "\x0D\x0E\x0F\x10\xff\x11\x12\x13\x14\x15\xff\x16\x17\x18\x19\x1A\x1B\x1C\x1D\x1E"
-    "\x1F\x20\xff\xff\xff\xff\xff\xff\x21\x22\x23\x24\x25\x26\x27\x28\x29\x2A\x2B\xff"
-    "\x2C\x2D\x2E\x2F\x30\x31\x32\x33\x34\x35\x36\x37\x38\x39\xff\xff\xff\xff\xff";
+// RFC 4648 section 6, padded
+typedef Base32Codec<Base32StandardAlphabet, true> Base32;
 
-  mpz_class p(0); // product and multiplicand
+// Crockford's base 32: no padding, and safe to read aloud and retype
+typedef Base32Codec<Base32CrockfordAlphabet, false> Base32Crockford;
 
-  // Apply "p = p * 58 + n" for all n in 'data'
-  for (U64 i = 0; i < size; i++) {
-    Byte n = (Byte) b58[(data[i] & 0x7f) - 0x31];
-    mpz_mul_ui(p.get_mpz_t(), p.get_mpz_t(), 58);
-    mpz_add_ui(p.get_mpz_t(), p.get_mpz_t(), n);
-  }
+const auto encode_base32 = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Base32>(data, size);
+};
 
-  // Allocate and copy the output
-  U64 outSize = (mpz_sizeinbase(p.get_mpz_t(), 2) + 7) / 8;
-  Util::MutableBlob out(outSize);
-  mpz_export((void *)out.data(), nullptr, 1, 1, 0, 0, p.get_mpz_t());
+const auto decode_base32 = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Base32>(data, size);
+};
 
-  // Return a unique pointer to a Blob
-  return make_unique<Util::Blob>(out);
+const auto encode_base32_crockford = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Base32Crockford>(data, size);
 };
-*/
 
-auto decode_base58 = [] (const Byte *data, U64 size)
+const auto decode_base32_crockford = [] (const Byte *data, U64 size)
 {
-  // Count leading zeros
-  U64 leadingZeros = 0;
-  for (U64 i = 0; i < size; i++) {
-    if (data[i] == (Byte) '1') {
-      leadingZeros += 1;
-    }
-    else {
-      break;
-    }
+  return decodeWith<Base32Crockford>(data, size);
+};
+
+
+// *** Bignum (GMP) encoders for arbitrary bases ***
+//
+// 'Alphabet' supplies the digits ('digits()'), a reserve ratio of output
+// chars to input bytes times 100 ('kRatio', log(256) / log(base) rounded up)
+// and a decode table ('values()'). Leading zero bytes are encoded as leading
+// zero digits.
+template<U32 Base, typename Alphabet>
+struct BignumCodec
+{
+  static const U64 kBlockSize = 0;
+  static const U64 kTextBlockSize = 0;
+
+  static U64 encodedSize(U64 size)
+  {
+    return size * Alphabet::kRatio / 100 + 1;
   }
-  mpz_class p(0); // product and multiplicand
 
-  // Apply "p = p * 58 + n" for all n in 'data'
-  for (U64 i = 0; i < size; i++) {
-    Byte n = data[i];
-    if (n > 0x6c) {
-      n -= 0x41;
+  // Bignum storage kept across calls when encoding many inputs (see
+  // codec_batch.h), so each input costs no allocation
+  struct Scratch
+  {
+    mpz_class n;
+  };
+
+  static U64 encode(const Byte *data, U64 size, char *out)
+  {
+    Scratch scratch;
+    return encode(data, size, out, scratch);
+  }
+
+  static U64 encode(const Byte *data, U64 size, char *out, Scratch &scratch)
+  {
+    // Count leading zeros
+    U64 leadingZeros = 0;
+    while ((leadingZeros < size) && (data[leadingZeros] == 0x00)) {
+      leadingZeros++;
+    }
+    const U64 reserve = (size - leadingZeros) * Alphabet::kRatio / 100 + 1 + leadingZeros;
+    char *end = &out[reserve];
+    char *pos = end;
+
+    // Divide by base^10 (< 2^64) and split each remainder into ten digits in
+    // a machine word; the most significant remainder has no leading zeros
+    U64 chunk = 1;
+    for (U32 j = 0; j < 10; j++) {
+      chunk *= Base;
     }
-    else if (n > 0x60) {
-      n -= 0x40;
+    mpz_ptr n = scratch.n.get_mpz_t();
+    mpz_import(n, size, 1, 1, 0, 0, data);
+    while (mpz_sgn(n) != 0) {
+      U64 word = mpz_tdiv_q_ui(n, n, chunk);
+      bool last = mpz_sgn(n) == 0;
+      for (U32 j = 0; j < 10 && (!last || word != 0); j++) {
+        pos--;
+        *pos = Alphabet::digits()[word % Base];
+        word /= Base;
+      }
     }
-    else if (n > 0x4f) {
-      n -= 0x3a;
+    for (U64 i = 0; i < leadingZeros; i++) {
+      pos--;
+      *pos = Alphabet::digits()[0];
     }
-    else if (n > 0x49) {
-      n -= 0x39;
+    // The digits were produced from the end; move them to the front
+    U64 encodedSize = (U64)(end - pos);
+    memmove((void *)out, (const void *)pos, encodedSize);
+    return encodedSize;
+  }
+
+  // Every digit carries more than 5 bits, so the output never exceeds the input
+  static U64 decodedSize(const Byte *, U64 size)
+  {
+    return size;
+  }
+
+  static DecodeStatus decode(const Byte *data, U64 size, Byte *out)
+  {
+    const Byte *values = Alphabet::values();
+
+    // Count leading zeros
+    U64 leadingZeros = 0;
+    while ((leadingZeros < size) && (data[leadingZeros] == (Byte)Alphabet::digits()[0])) {
+      leadingZeros++;
+    }
+    mpz_class p(0); // product and multiplicand
+
+    // Apply "p = p * base + n" for all n in 'data', accumulating up to ten
+    // digits in a machine word between bignum operations (base^10 < 2^64)
+    for (U64 i = 0; i < size; ) {
+      U64 word = 0;
+      U64 scale = 1;
+      for (U64 j = 0; (j < 10) && (i < size); j++, i++) {
+        Byte n = values[data[i]];
+        if (n & 0x80) {
+          return DecodeStatus::failure(i);
+        }
+        word = word * Base + n;
+        scale *= Base;
+      }
+      mpz_mul_ui(p.get_mpz_t(), p.get_mpz_t(), scale);
+      mpz_add_ui(p.get_mpz_t(), p.get_mpz_t(), word);
     }
-    else if (n > 0x40) {
-      n -= 0x38;
+
+    // Copy the output after the leading zeros
+    for (U64 i = 0; i < leadingZeros; i++) {
+      out[i] = 0x00;
     }
-    else {
-      n -= 0x31;
+    U64 outSize = 0;
+    if (mpz_sgn(p.get_mpz_t()) != 0) {
+      outSize = (mpz_sizeinbase(p.get_mpz_t(), 2) + 7) / 8;
+      mpz_export((void *)&out[leadingZeros], nullptr, 1, 1, 0, 0, p.get_mpz_t());
     }
-    mpz_mul_ui(p.get_mpz_t(), p.get_mpz_t(), 58);
-    mpz_add_ui(p.get_mpz_t(), p.get_mpz_t(), n);
+    return DecodeStatus::success(outSize + leadingZeros);
   }
+};
+
 
-  // Allocate and copy the output
-  U64 outSize = (mpz_sizeinbase(p.get_mpz_t(), 2) + 7) / 8 + leadingZeros;
-  MutableBlob out(outSize);
-  Byte *outData = out.data();
-  for (U64 i = 0; i < leadingZeros; i++) {
-    *outData++ = 0x00;
+// *** Base 58 Encoder (Bitcoin-like encoding) ***
+struct Base58Alphabet
+{
+  static const char *digits()
+  {
+    return "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
   }
-  mpz_export((void *)outData, nullptr, 1, 1, 0, 0, p.get_mpz_t());
 
-  // Return a unique pointer to a Blob
-  return make_unique<Blob>(out);
+  static const U64 kRatio = 138;
+
+  static const Byte *values()
+  {
+    return Kernels::kBase58Values;
+  }
+};
+
+typedef BignumCodec<58, Base58Alphabet> Base58;
+
+const auto encode_base58 = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Base58>(data, size);
+};
+
+const auto decode_base58 = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Base58>(data, size);
 };
 
 
 // *** Base 62 Encoder ***
-auto encode_base62 = [] (const Byte *data, U64 size)
+struct Base62Alphabet
 {
-  static const char *b62 = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  static const char *digits()
+  {
+    return "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  }
 
-  // Count leading zeros
-  U64 leadingZeros = 0;
-  for (U64 i = 0; i < size; i++) {
-    if (data[i] == 0x00) {
-      leadingZeros += 1;
-    }
-    else {
-      break;
-    }
+  static const U64 kRatio = 137;
+
+  static const Byte *values()
+  {
+    return Kernels::kBase62Values;
   }
-  // Output reserve size: log(256) / log(62), rounded up
-  const U64 reserve = (size - leadingZeros) * 137 / 100 + 1 + leadingZeros;
+};
+
+typedef BignumCodec<62, Base62Alphabet> Base62;
 
-  std::unique_ptr<Byte[]> outPtr(new Byte[reserve]);
-  Byte *out = outPtr.get();
-  Byte *pos = &out[reserve];
+const auto encode_base62 = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Base62>(data, size);
+};
 
-  mpz_class d("62");  // divisor
-  mpz_class n, r;     // dividend and remainder
-  mpz_import(n.get_mpz_t(), size, 1, 1, 0, 0, data);
+const auto decode_base62 = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Base62>(data, size);
+};
 
-  while (mpz_get_ui(n.get_mpz_t()) != 0U) {
-    pos--;
-    mpz_fdiv_qr(n.get_mpz_t(), r.get_mpz_t(), n.get_mpz_t(), d.get_mpz_t());
-    *pos = (Byte) b62[mpz_get_ui(r.get_mpz_t())];
+
+// *** Base 64 Encoder family ***
+//
+// One kernel generates every variant from three options: the alphabet, '='
+// padding to a multiple of 4 digits, and wrapping lines at 'LineLength'
+// digits (a multiple of 4) with CRLF. Each variant is produced in a single
+// pass. Decoding is strict about padding (required exactly when 'Pad') and
+// accepts CR and LF anywhere when lines are wrapped.
+struct Base64StandardAlphabet
+{
+  static const Kernels::Base64Tables &tables()
+  {
+    return Kernels::kBase64Standard;
   }
-  for (U64 i = 0; i < leadingZeros; i++) {
-    pos--;
-    *pos = (Byte) b62[0];
+};
+
+struct Base64UrlAlphabet
+{
+  static const Kernels::Base64Tables &tables()
+  {
+    return Kernels::kBase64Url;
   }
-  U64 encodedSize = (U64)(&out[reserve] - pos);
-  return make_unique<std::string>((char *)pos, encodedSize);
 };
 
-auto decode_base62 = [] (const Byte *data, U64 size)
+template<typename Alphabet, bool Pad, U32 LineLength = 0>
+struct Base64Codec
 {
-  // Count leading zeros
-  U64 leadingZeros = 0;
-  for (U64 i = 0; i < size; i++) {
-    if (data[i] == (Byte) '0') {
-      leadingZeros += 1;
+  static_assert(LineLength % 4 == 0, "Base 64 lines must hold whole groups");
+
+  // Wrapped output cannot be produced in independent pieces
+  static const U64 kBlockSize = (LineLength == 0) ? 3 : 0;
+  static const U64 kTextBlockSize = (LineLength == 0) ? 4 : 0;
+
+  static U64 encodedSize(U64 size)
+  {
+    U64 chars = (size / 3) * 4;
+    if (size % 3) {
+      chars += Pad ? 4 : (size % 3) + 1;
     }
-    else {
-      break;
+    if ((LineLength != 0) && (chars != 0)) {
+      chars += 2 * ((chars - 1) / LineLength);
     }
+    return chars;
   }
-  mpz_class p(0); // product and multiplicand
 
-  // Apply "p = p * 62 + n" for all n in 'data'
-  for (U64 i = 0; i < size; i++) {
-    Byte n = data[i];
-    n -= ((n > 0x60) ? 0x3D : ((n > 0x40) ? 0x37 : 0x30));
-    mpz_mul_ui(p.get_mpz_t(), p.get_mpz_t(), 62);
-    mpz_add_ui(p.get_mpz_t(), p.get_mpz_t(), n);
+  static U64 encode(const Byte *data, U64 size, char *out)
+  {
+    const U64 lineBytes = (LineLength != 0) ? (LineLength / 4) * 3 : size;
+    char *pos = out;
+    U64 offset = 0;
+    while (true) {
+      U64 n = (size - offset < lineBytes) ? size - offset : lineBytes;
+      pos += encodeLine(&data[offset], n, pos);
+      offset += n;
+      if (offset >= size) {
+        break;
+      }
+      *pos++ = '\r';
+      *pos++ = '\n';
+    }
+    return (U64)(pos - out);
   }
 
-  // Allocate and copy the output
-  U64 outSize = (mpz_sizeinbase(p.get_mpz_t(), 2) + 7) / 8 + leadingZeros;
-  Util::MutableBlob out(outSize);
-  Byte *outData = out.data();
-  for (U64 i = 0; i < leadingZeros; i++) {
-    *outData++ = 0x00;
+  // Padding and line breaks only make this an over-estimate
+  static U64 decodedSize(const Byte *, U64 size)
+  {
+    U64 stragglers = size & 0x3;
+    return ((size >> 2) * 3) + ((stragglers >= 2) ? stragglers - 1 : 0);
   }
-  mpz_export((void *)outData, nullptr, 1, 1, 0, 0, p.get_mpz_t());
 
-  // Return a unique pointer to a Blob
-  return make_unique<Blob>(out);
+  static DecodeStatus decode(const Byte *data, U64 size, Byte *out)
+  {
+    const Byte *values = Alphabet::tables().values;
+
+    // Find the end of the digits: before any trailing line breaks, then
+    // before any padding
+    U64 end = size;
+    while ((LineLength != 0) && (end > 0) && isLineBreak(data[end - 1])) {
+      end--;
+    }
+    U64 padding = 0;
+    while (Pad && (padding < 2) && (end > 0) && (data[end - 1] == '=')) {
+      end--;
+      padding++;
+    }
+
+    // Decode each run of digits between line breaks. A group of 4 digits may
+    // straddle a line break, so up to 3 digits are carried between runs.
+    Byte *pos = out;
+    Byte carry[4];
+    U64 carryOffset[4];
+    U64 carried = 0;
+    U64 start = 0;
+    while (start < end) {
+      U64 stop = start;
+      if (LineLength != 0) {
+        while ((stop < end) && !isLineBreak(data[stop])) {
+          stop++;
+        }
+      }
+      else {
+        stop = end;
+      }
+      U64 i = start;
+      while ((carried > 0) && (carried < 4) && (i < stop)) {
+        carryOffset[carried] = i;
+        carry[carried++] = data[i++];
+      }
+      if (carried == 4) {
+        U64 bad = decodeGroup(carry, pos, values);
+        if (bad < 4) {
+          return DecodeStatus::failure(carryOffset[bad]);
+        }
+        pos += 3;
+        carried = 0;
+      }
+      if (carried == 0) {
+        DecodeStatus run = decodeRun(data, i, stop, pos, values);
+        if (!run.ok()) {
+          return run;
+        }
+        pos += run.size;
+        i += (run.size / 3) * 4;
+        while (i < stop) {
+          carryOffset[carried] = i;
+          carry[carried++] = data[i++];
+        }
+      }
+      start = stop;
+      while ((start < end) && isLineBreak(data[start])) {
+        start++;
+      }
+    }
+
+    // The final partial group: 2 or 3 digits (or nothing)
+    if (carried == 1) {
+      return DecodeStatus::failure(carryOffset[0]);
+    }
+    if (carried > 1) {
+      carry[3] = (Byte)Alphabet::tables().digits[0];
+      if (carried == 2) {
+        carry[2] = (Byte)Alphabet::tables().digits[0];
+      }
+      Byte group[3];
+      U64 bad = decodeGroup(carry, group, values);
+      if (bad < carried) {
+        return DecodeStatus::failure(carryOffset[bad]);
+      }
+      for (U64 j = 0; j + 1 < carried; j++) {
+        *pos++ = group[j];
+      }
+    }
+
+    // Padding must complete the final group exactly
+    U64 expected = (carried == 0) ? 0 : 4 - carried;
+    if (Pad && (padding != expected)) {
+      return DecodeStatus::failure(end + ((padding < expected) ? padding : expected));
+    }
+    return DecodeStatus::success((U64)(pos - out));
+  }
+
+ private:
+  static bool isLineBreak(Byte c)
+  {
+    return (c == '\r') || (c == '\n');
+  }
+
+  // Encode one line: whole groups, then the padded or unpadded remainder
+  static U64 encodeLine(const Byte *data, U64 size, char *out)
+  {
+    const char *digits = Alphabet::tables().digits;
+    char *pos = out;
+    U64 i = 0;
+    if (size >= 32) {
+      i = Kernels::encode_base64_bulk(data, size, pos, Alphabet::tables());
+      pos += (i / 3) * 4;
+    }
+    for (; i + 3 <= size; i += 3) {
+      U32 n = ((U32)data[i] << 16) | ((U32)data[i + 1] << 8) | data[i + 2];
+      *pos++ = digits[(n >> 18) & 0x3f];
+      *pos++ = digits[(n >> 12) & 0x3f];
+      *pos++ = digits[(n >> 6) & 0x3f];
+      *pos++ = digits[n & 0x3f];
+    }
+    U64 stragglers = size - i;
+    if (stragglers != 0) {
+      U32 n = (U32)data[i] << 16;
+      if (stragglers > 1) {
+        n |= (U32)data[i + 1] << 8;
+      }
+      *pos++ = digits[(n >> 18) & 0x3f];
+      *pos++ = digits[(n >> 12) & 0x3f];
+      if (stragglers > 1) {
+        *pos++ = digits[(n >> 6) & 0x3f];
+      }
+      else if (Pad) {
+        *pos++ = '=';
+      }
+      if (Pad) {
+        *pos++ = '=';
+      }
+    }
+    return (U64)(pos - out);
+  }
+
+  // Decode 4 digits into 3 bytes; returns the index of the first invalid
+  // digit, or 4 if all are valid
+  static U64 decodeGroup(const Byte *in, Byte *out, const Byte *values)
+  {
+    U32 A = values[in[0]];
+    U32 B = values[in[1]];
+    U32 C = values[in[2]];
+    U32 D = values[in[3]];
+    if ((A | B | C | D) & 0x80) {
+      return firstInvalid(values, in, 0, 4);
+    }
+    U32 n = (A << 18) | (B << 12) | (C << 6) | D;
+    out[0] = (Byte)(n >> 16);
+    out[1] = (Byte)(n >> 8);
+    out[2] = (Byte)n;
+    return 4;
+  }
+
+  // Decode the whole groups of digits in [start, stop); the status size is
+  // the number of bytes written
+  static DecodeStatus decodeRun(const Byte *data, U64 start, U64 stop, Byte *out,
+    const Byte *values)
+  {
+    U64 i = start;
+    if (stop - start >= 64) {
+      i += Kernels::decode_base64_bulk(&data[start], stop - start, out, Alphabet::tables());
+    }
+    Byte *pos = &out[((i - start) / 4) * 3];
+    for (; i + 4 <= stop; i += 4) {
+      U64 bad = decodeGroup(&data[i], pos, values);
+      if (bad < 4) {
+        return DecodeStatus::failure(i + bad);
+      }
+      pos += 3;
+    }
+    return DecodeStatus::success((U64)(pos - out));
+  }
 };
 
-// *** Base 64 Encoder (without padding) ***
-auto encode_base64 = [] (const Byte *data, U64 size)
+// Standard alphabet without padding (the original Blob encoding)
+typedef Base64Codec<Base64StandardAlphabet, false> Base64;
+
+// Standard alphabet with padding (RFC 4648 section 4)
+typedef Base64Codec<Base64StandardAlphabet, true> Base64Pad;
+
+// URL and filename safe alphabet without padding (RFC 4648 section 5)
+typedef Base64Codec<Base64UrlAlphabet, false> Base64Url;
+
+// URL and filename safe alphabet with padding
+typedef Base64Codec<Base64UrlAlphabet, true> Base64UrlPad;
+
+// MIME: padded, wrapped at 76 characters with CRLF (RFC 2045)
+typedef Base64Codec<Base64StandardAlphabet, true, 76> Base64Mime;
+
+const auto encode_base64 = [] (const Byte *data, U64 size)
 {
-  static const char *base64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  return encodeWith<Base64>(data, size);
+};
 
-  U64 i = 0;
-  U64 j = 0;
-  Byte array3[3];
-  Byte array4[4];
+const auto decode_base64 = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Base64>(data, size);
+};
 
-  U64 outputSize = ((size + ((size % 3) ? (3 - (size % 3)) : 0)) / 3) * 4;
-  std::unique_ptr<std::string> outputPtr(new std::string());
-  std::string &output = *outputPtr.get();
-  output.reserve(outputSize);
+const auto encode_base64_pad = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Base64Pad>(data, size);
+};
+
+const auto decode_base64_pad = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Base64Pad>(data, size);
+};
+
+const auto encode_base64_url = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Base64Url>(data, size);
+};
+
+const auto decode_base64_url = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Base64Url>(data, size);
+};
+
+const auto encode_base64_mime = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Base64Mime>(data, size);
+};
+
+const auto decode_base64_mime = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Base64Mime>(data, size);
+};
+
+
+// *** Base 85 Encoder family ***
+//
+// Each group of 4 bytes (a big-endian 32-bit value) becomes 5 digits. A
+// final group of 1 to 3 bytes is padded with zeros and written as its first
+// 1 to 3 digits plus one, as in Ascii85 (Z85 itself only allows whole
+// groups). 'Alphabet' supplies the digits ('digits()'), a decode table
+// ('values()') and the digit abbreviating a whole zero group ('kZeroGroup',
+// or '\0' for none).
+struct Z85Alphabet
+{
+  static const char *digits()
+  {
+    return "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#";
+  }
+
+  static const Byte *values()
+  {
+    return Kernels::kZ85Values;
+  }
+
+  static const char kZeroGroup = '\0';
+};
+
+struct Ascii85Alphabet
+{
+  static const char *digits()
+  {
+    return "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstu";
+  }
+
+  static const Byte *values()
+  {
+    return Kernels::kAscii85Values;
+  }
+
+  static const char kZeroGroup = 'z';
+};
+
+template<typename Alphabet>
+struct Base85Codec
+{
+  static const U64 kBlockSize = 4;
 
-  while (size--) {
-    array3[i++] = *(data++);
-    if (i == 3) {
-      i = 0;
-      array4[0] = (array3[0] & 0xfc) >> 2;
-      array4[1] = ((array3[0] & 0x03) << 4) + ((array3[1] & 0xf0) >> 4);
-      array4[2] = ((array3[1] & 0x0f) << 2) + ((array3[2] & 0xc0) >> 6);
-      array4[3] = array3[2] & 0x3f;
+  // A zero group abbreviation makes group lengths vary
+  static const U64 kTextBlockSize = (Alphabet::kZeroGroup == '\0') ? 5 : 0;
 
-      output += base64[array4[0]];
-      output += base64[array4[1]];
-      output += base64[array4[2]];
-      output += base64[array4[3]];
+  static U64 encodedSize(U64 size)
+  {
+    return (size / 4) * 5 + ((size % 4 == 0) ? 0 : (size % 4) + 1);
+  }
+
+  static U64 encode(const Byte *data, U64 size, char *out)
+  {
+    const char *digits = Alphabet::digits();
+    char *pos = out;
+    U64 i = 0;
+    for (; i + 4 <= size; i += 4) {
+      U32 n = ((U32)data[i] << 24) | ((U32)data[i + 1] << 16) | ((U32)data[i + 2] << 8) | data[i + 3];
+      if ((Alphabet::kZeroGroup != '\0') && (n == 0)) {
+        *pos++ = Alphabet::kZeroGroup;
+        continue;
+      }
+      encodeGroup(n, pos, digits);
+      pos += 5;
+    }
+    U64 stragglers = size - i;
+    if (stragglers != 0) {
+      U32 n = 0;
+      for (U64 j = 0; j < 4; j++) {
+        n = (n << 8) | ((j < stragglers) ? data[i + j] : 0);
+      }
+      char chars[5];
+      encodeGroup(n, chars, digits);
+      memcpy((void *)pos, (const void *)chars, stragglers + 1);
+      pos += stragglers + 1;
+    }
+    return (U64)(pos - out);
+  }
+
+  // Each zero group digit expands to 4 bytes
+  static U64 decodedSize(const Byte *data, U64 size)
+  {
+    U64 zeroGroups = 0;
+    if (Alphabet::kZeroGroup != '\0') {
+      zeroGroups = (U64)std::count(data, data + size, (Byte)Alphabet::kZeroGroup);
     }
+    U64 digits = size - zeroGroups;
+    return (digits / 5) * 4 + ((digits % 5 == 0) ? 0 : (digits % 5) - 1) + 4 * zeroGroups;
   }
-  if (i != 0) {
-    for (j = i; j < 3; j++) {
-      array3[j] = 0;
+
+  static DecodeStatus decode(const Byte *data, U64 size, Byte *out)
+  {
+    const Byte *values = Alphabet::values();
+    Byte *pos = out;
+    U64 i = 0;
+    while (i < size) {
+      // Whole groups in bulk, resuming after each zero group
+      if (size - i >= 64) {
+        U64 n = Kernels::decode_base85_bulk(&data[i], size - i, pos, values);
+        i += n;
+        pos += (n / 5) * 4;
+      }
+      if ((Alphabet::kZeroGroup != '\0') && (data[i] == (Byte)Alphabet::kZeroGroup)) {
+        memset((void *)pos, 0, 4);
+        pos += 4;
+        i++;
+        continue;
+      }
+      if (i + 5 > size) {
+        break;
+      }
+      U64 bad = decodeGroup(&data[i], pos, values);
+      if (bad < 5) {
+        return DecodeStatus::failure(i + bad);
+      }
+      pos += 4;
+      i += 5;
     }
-    array4[0] = (array3[0] & 0xfc) >> 2;
-    array4[1] = ((array3[0] & 0x03) << 4) + ((array3[1] & 0xf0) >> 4);
-    array4[2] = ((array3[1] & 0x0f) << 2) + ((array3[2] & 0xc0) >> 6);
-    array4[3] = array3[2] & 0x3f;
 
-    for (j = 0; j < i + 1; j++) {
-      output += base64[array4[j]];
+    // The final partial group: 2 to 4 digits (or nothing)
+    U64 stragglers = size - i;
+    if (stragglers == 1) {
+      return DecodeStatus::failure(i);
+    }
+    if (stragglers != 0) {
+      Byte chars[5];
+      Byte group[4];
+      memset((void *)chars, Alphabet::digits()[84], 5);
+      memcpy((void *)chars, (const void *)&data[i], stragglers);
+      U64 bad = decodeGroup(chars, group, values);
+      if (bad < 5) {
+        return DecodeStatus::failure(i + ((bad < stragglers) ? bad : 0));
+      }
+      memcpy((void *)pos, (const void *)group, stragglers - 1);
+      pos += stragglers - 1;
     }
-    //while (i++ < 3) {
-    //    output += '=';
-    //}
+    return DecodeStatus::success((U64)(pos - out));
   }
-  return outputPtr;
+
+ private:
+  static void encodeGroup(U32 n, char *out, const char *digits)
+  {
+    for (int j = 4; j >= 0; j--) {
+      out[j] = digits[n % 85];
+      n /= 85;
+    }
+  }
+
+  // Decode 5 digits into 4 bytes; returns the index of the first invalid
+  // digit, 0 if the group exceeds 32 bits, or 5 if the group is valid
+  static U64 decodeGroup(const Byte *in, Byte *out, const Byte *values)
+  {
+    U64 n = 0;
+    Byte invalid = 0;
+    for (int j = 0; j < 5; j++) {
+      Byte v = values[in[j]];
+      invalid |= v;
+      n = n * 85 + v;
+    }
+    if (invalid & 0x80) {
+      return firstInvalid(values, in, 0, 5);
+    }
+    if (n > 0xffffffffUL) {
+      return 0;
+    }
+    out[0] = (Byte)(n >> 24);
+    out[1] = (Byte)(n >> 16);
+    out[2] = (Byte)(n >> 8);
+    out[3] = (Byte)n;
+    return 5;
+  }
+};
+
+// ZeroMQ's Z85 (RFC 32/Z85), which is safe to quote in source code and XML
+typedef Base85Codec<Z85Alphabet> Z85;
+
+// Adobe / btoa Ascii85, without the "<~" "~>" delimiters or whitespace
+typedef Base85Codec<Ascii85Alphabet> Ascii85;
+
+const auto encode_z85 = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Z85>(data, size);
 };
 
-auto decode_base64 = [] (const Byte *data, U64 size)
-{
-  static const char *b64 =
-    "\x3E\xff\xff\xff\x3F\x34\x35\x36\x37\x38\x39\x3A\x3B\x3C\x3D\xff\xff\xff\xff\xff"
-    "\xff\xff\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0A\x0B\x0C\x0D\x0E\x0F\x10\x11"
-    "\x12\x13\x14\x15\x16\x17\x18\x19\xff\xff\xff\xff\xff\xff\x1A\x1B\x1C\x1D\x1E\x1F"
-    "\x20\x21\x22\x23\x24\x25\x26\x27\x28\x29\x2A\x2B\x2C\x2D\x2E\x2F\x30\x31\x32\x33";
-
-  U64 groups = size >> 2;
-  U64 stragglers = size & 0x3;
-  U64 outSize = (groups * 3) + ((stragglers >= 2) ? stragglers - 1 : 0);
-  MutableBlob outBlob(outSize);
-  Byte *out = outBlob.data();
-
-  for (U64 i = 0; i < groups; i++) {
-    Byte A = *data++ - 0x2b;
-    Byte B = *data++ - 0x2b;
-    Byte C = *data++ - 0x2b;
-    Byte D = *data++ - 0x2b;
-    A = (A < 80) ? (Byte) b64[A] : 0x00;
-    B = (B < 80) ? (Byte) b64[B] : 0x00;
-    C = (C < 80) ? (Byte) b64[C] : 0x00;
-    D = (D < 80) ? (Byte) b64[D] : 0x00;
-    *out++ = (A << 2) | (B >> 4);
-    *out++ = (B << 4) | (C >> 2);
-    *out++ = (C << 6) | D;
-  }
-  if (stragglers >= 2) {
-    Byte A = *data++ - 0x2b;
-    Byte B = *data++ - 0x2b;
-    A = (A < 80) ? (Byte) b64[A] : 0x00;
-    B = (B < 80) ? (Byte) b64[B] : 0x00;
-    *out++ = (A << 2) | (B >> 4);
-    if (stragglers > 2) {
-      Byte C = *data - 0x2b;
-      C = (C < 80) ? (Byte) b64[C] : 0x00;
-      *out = (B << 4) | (C >> 2);
-    }
-  }
-  return make_unique<Blob>(outBlob);
+const auto decode_z85 = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Z85>(data, size);
+};
+
+const auto encode_ascii85 = [] (const Byte *data, U64 size)
+{
+  return encodeWith<Ascii85>(data, size);
+};
+
+const auto decode_ascii85 = [] (const Byte *data, U64 size)
+{
+  return decodeWith<Ascii85>(data, size);
 };
 
 } // namespace Util
 
 #endif // UTIL_BYTE_ENCODERS_H
-
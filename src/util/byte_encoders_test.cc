@@ -182,3 +182,402 @@ TEST(ByteEncodersTest, Base64) {
   EXPECT_TRUE(testReversibility(encode_base64, decode_base64));
 }
 
+
+// Return true if the compile-time codec matches its run-time adapters
+template<typename Codec>
+static bool testTemplate(Blob::Encoder enc, Blob::Decoder dec)
+{
+  for (int i = 0; i < nRandTests; i++) {
+    Blob a = randomBlob();
+    unique_ptr<string> s(a.data(enc));
+    if ((a.encode<Codec>() != *s) || (a.view().encode<Codec>() != *s)) {
+      return false;
+    }
+    string sink;
+    a.encode<Codec>(sink);
+    if (sink != *s) {
+      return false;
+    }
+    if (Blob::decode<Codec>(*s) != Blob(*s, dec)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(ByteEncodersTest, Templates) {
+  EXPECT_TRUE(testTemplate<Bin>(encode_bin, decode_bin));
+  EXPECT_TRUE(testTemplate<Hex>(encode_hex, decode_hex));
+  EXPECT_TRUE(testTemplate<Base58>(encode_base58, decode_base58));
+  EXPECT_TRUE(testTemplate<Base62>(encode_base62, decode_base62));
+  EXPECT_TRUE(testTemplate<Base64>(encode_base64, decode_base64));
+  EXPECT_TRUE(testTemplate<Base32>(encode_base32, decode_base32));
+  EXPECT_TRUE(testTemplate<Z85>(encode_z85, decode_z85));
+  EXPECT_TRUE(testTemplate<Ascii85>(encode_ascii85, decode_ascii85));
+  EXPECT_EQ(s1, b1.encode<String>());
+  EXPECT_TRUE(b1 == Blob::decode<String>(s1));
+
+  // Sink output spanning several stack buffers
+  MutableBlob big(10000);
+  for (U64 i = 0; i < big.size(); i++) {
+    big[i] = (Byte)(i * 7);
+  }
+  string sink;
+  big.encode<Base64>(sink);
+  EXPECT_EQ(*Blob(big).data(encode_base64), sink);
+  EXPECT_TRUE(big == Blob::decode<Base64>(sink));
+
+  // Decoding keeps the requested scrub and compare types
+  Blob c = Blob::decode<Hex>("0A0B", Blob::ScrubType::ZEROS, Blob::CompareType::CONST);
+  EXPECT_EQ(2UL, c.size());
+  EXPECT_EQ(0x0a, c[0]);
+  EXPECT_EQ(Blob::ScrubType::ZEROS, c.scrubType());
+  EXPECT_EQ(Blob::CompareType::CONST, c.compareType());
+}
+
+TEST(ByteEncodersTest, BignumEdges) {
+  // A non-zero value whose low 64 bits are zero
+  Byte data[9] = {0x01, 0, 0, 0, 0, 0, 0, 0, 0};
+  Blob a(data, sizeof(data));
+  EXPECT_TRUE(a == Blob::decode<Base58>(a.encode<Base58>()));
+  EXPECT_TRUE(a == Blob::decode<Base62>(a.encode<Base62>()));
+
+  // Only zeros
+  Blob z(data + 1, 3);
+  EXPECT_EQ("111", z.encode<Base58>());
+  EXPECT_TRUE(z == Blob::decode<Base58>("111"));
+}
+
+// Return true if decoding fails exactly at 'offset'
+template<typename Codec>
+static bool failsAt(const string &text, U64 offset)
+{
+  Blob out;
+  DecodeStatus status = Blob::tryDecode<Codec>(text, out);
+  return !status.ok() && (status.errorOffset == offset) && (out.size() == 0);
+}
+
+// Return true if every single-character corruption of a long encoding is
+// reported at its own offset (covering both vectorized and scalar paths)
+template<typename Codec>
+static bool testValidation(char bad)
+{
+  MutableBlob data(300);
+  for (U64 i = 0; i < data.size(); i++) {
+    data[i] = (Byte)(i * 13 + 5);
+  }
+  string text = Blob(data).encode<Codec>();
+  for (U64 i = 0; i < text.size(); i++) {
+    string corrupt = text;
+    corrupt[i] = bad;
+    if (!failsAt<Codec>(corrupt, i)) {
+      return false;
+    }
+  }
+  Blob out;
+  return Blob::tryDecode<Codec>(text, out).ok() && (out == data);
+}
+
+TEST(ByteEncodersTest, Validation) {
+  EXPECT_TRUE(testValidation<Bin>('2'));
+  EXPECT_TRUE(testValidation<Hex>('G'));
+  EXPECT_TRUE(testValidation<Hex>(':'));
+  EXPECT_TRUE(testValidation<Base64>('='));
+  EXPECT_TRUE(testValidation<Base64>('\x80'));
+  EXPECT_TRUE(testValidation<Base32>('1'));
+  EXPECT_TRUE(testValidation<Base32Crockford>('U'));
+  EXPECT_TRUE(testValidation<Z85>('~'));
+  EXPECT_TRUE(testValidation<Ascii85>('v'));
+
+  // The bignum codecs are quadratic, so only check a few positions
+  EXPECT_TRUE(failsAt<Base58>("3A836b0", 6));
+  EXPECT_TRUE(failsAt<Base58>("3AI36b", 2));
+  EXPECT_TRUE(failsAt<Base62>("1Xp7K-e", 5));
+
+  // Incomplete trailing groups
+  EXPECT_TRUE(failsAt<Hex>("0A0", 2));
+  EXPECT_TRUE(failsAt<Bin>("010101011", 8));
+  EXPECT_TRUE(failsAt<Base64>("QUJD" "R", 4));
+
+  // Lower case hex
+  Blob lower = Blob::decode<Hex>("0a0b0c0d0e0f");
+  Blob upper = Blob::decode<Hex>("0A0B0C0D0E0F");
+  EXPECT_EQ(6UL, lower.size());
+  EXPECT_TRUE(lower == upper);
+
+  // The run-time decoders return an empty Blob for invalid input
+  Blob invalid("0A0X", decode_hex);
+  EXPECT_EQ(0UL, invalid.size());
+}
+
+// The multi-pass reference: standard base 64 with characters swapped,
+// padding appended and lines wrapped afterwards
+static string postProcess(const Blob &data, bool url, bool pad, U64 lineLength)
+{
+  string s = *data.data(encode_base64);
+  if (url) {
+    for (char &c : s) {
+      c = (c == '+') ? '-' : ((c == '/') ? '_' : c);
+    }
+  }
+  while (pad && (s.size() % 4 != 0)) {
+    s += '=';
+  }
+  if (lineLength == 0) {
+    return s;
+  }
+  string wrapped;
+  for (U64 i = 0; i < s.size(); i += lineLength) {
+    if (i != 0) {
+      wrapped += "\r\n";
+    }
+    wrapped += s.substr(i, lineLength);
+  }
+  return wrapped;
+}
+
+template<typename Codec>
+static bool testVariant(bool url, bool pad, U64 lineLength)
+{
+  for (int i = 0; i < nRandTests; i++) {
+    Blob a = randomBlob();
+    string s = a.encode<Codec>();
+    if ((s != postProcess(a, url, pad, lineLength)) || (s.size() != Codec::encodedSize(a.size()))) {
+      return false;
+    }
+    Blob b;
+    if (!Blob::tryDecode<Codec>(s, b).ok() || (b != a)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(ByteEncodersTest, Base64Variants) {
+  EXPECT_TRUE(testVariant<Base64Pad>(false, true, 0));
+  EXPECT_TRUE(testVariant<Base64Url>(true, false, 0));
+  EXPECT_TRUE(testVariant<Base64UrlPad>(true, true, 0));
+  EXPECT_TRUE(testVariant<Base64Mime>(false, true, 76));
+  typedef Base64Codec<Base64UrlAlphabet, false, 64> Base64UrlWrapped;
+  EXPECT_TRUE(testVariant<Base64UrlWrapped>(true, false, 64));
+
+  // RFC 4648 test vectors
+  const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+  const char *padded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+  for (int i = 0; i < 7; i++) {
+    Blob b(plain[i], strlen(plain[i]));
+    EXPECT_TRUE(testCorrectness(encode_base64_pad, decode_base64_pad, b, padded[i]));
+  }
+  Blob url("\xfb\xff\xbf", 3);
+  EXPECT_TRUE(testCorrectness(encode_base64_url, decode_base64_url, url, "-_-_"));
+
+  // Line breaks may be LF only or missing, and may split a group
+  Blob mime = Blob::decode<Base64Mime>("Zm9v\nYm\r\nFy\n");
+  EXPECT_TRUE(mime == Blob("foobar", 6));
+
+  // Padding is required exactly when the codec pads
+  EXPECT_TRUE(failsAt<Base64Pad>("Zm8", 3));
+  EXPECT_TRUE(failsAt<Base64Pad>("Zg=", 3));
+  EXPECT_TRUE(failsAt<Base64Pad>("Zm9v=", 4));
+  EXPECT_TRUE(failsAt<Base64>("Zm8=", 3));
+  EXPECT_TRUE(failsAt<Base64Url>("Zm+v", 2));
+  EXPECT_TRUE(failsAt<Base64Mime>("Zm9v\r\nY*==", 7));
+}
+
+TEST(ByteEncodersTest, Base32) {
+  // RFC 4648 test vectors
+  const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+  const char *encoded[] = {"", "MY======", "MZXQ====", "MZXW6===", "MZXW6YQ=", "MZXW6YTB",
+    "MZXW6YTBOI======"};
+  for (int i = 0; i < 7; i++) {
+    Blob b(plain[i], strlen(plain[i]));
+    EXPECT_TRUE(testCorrectness(encode_base32, decode_base32, b, encoded[i]));
+  }
+  EXPECT_TRUE(Blob::decode<Base32>("mzxw6ytboi======") == Blob("foobar", 6));
+
+  // Crockford is the RFC 4648 encoding with another alphabet and no padding
+  const string standard = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+  const string crockford = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+  for (int i = 0; i < nRandTests; i++) {
+    Blob a = randomBlob();
+    string expected = a.encode<Base32>();
+    expected.erase(expected.find_last_not_of('=') + 1);
+    for (char &c : expected) {
+      c = crockford[standard.find(c)];
+    }
+    EXPECT_EQ(expected, a.encode<Base32Crockford>());
+  }
+
+  // Crockford decoding ignores case and reads I, L as 1 and O as 0
+  EXPECT_TRUE(Blob::decode<Base32Crockford>("10") == Blob::decode<Base32Crockford>("io"));
+  EXPECT_TRUE(Blob::decode<Base32Crockford>("10") == Blob::decode<Base32Crockford>("LO"));
+
+  // Reversibility of random strings
+  EXPECT_TRUE(testReversibility(encode_base32, decode_base32));
+  EXPECT_TRUE(testReversibility(encode_base32_crockford, decode_base32_crockford));
+
+  // Only 2, 4, 5 or 7 digits can end the input, with exact padding
+  EXPECT_TRUE(failsAt<Base32>("MZXW6YTBO=======", 9));
+  EXPECT_TRUE(failsAt<Base32>("MZXW6Y==", 5));
+  EXPECT_TRUE(failsAt<Base32>("MZXW6===" "=", 8));
+  EXPECT_TRUE(failsAt<Base32>("MZXW6YQ", 7));
+  EXPECT_TRUE(failsAt<Base32Crockford>("CSQPY=", 5));
+}
+
+TEST(ByteEncodersTest, Base85) {
+  // The Z85 specification example, and Ascii85 with a zero group
+  Byte hello[] = {0x86, 0x4f, 0xd2, 0x6f, 0xb5, 0x59, 0xf7, 0x5b};
+  EXPECT_TRUE(testCorrectness(encode_z85, decode_z85, Blob(hello, 8), "HelloWorld"));
+  EXPECT_TRUE(testCorrectness(encode_ascii85, decode_ascii85, Blob("Man ", 4), "9jqo^"));
+  EXPECT_TRUE(testCorrectness(encode_ascii85, decode_ascii85,
+    Blob("\x00\x00\x00\x00Man \x00\x00\x00\x00.", 13), "z9jqo^z/c"));
+  EXPECT_TRUE(testCorrectness(encode_z85, decode_z85, Blob("\x00\x00\x00\x00", 4), "00000"));
+
+  // Partial final groups of 1 to 3 bytes
+  for (U64 size = 0; size < 9; size++) {
+    Blob b(hello, size);
+    EXPECT_EQ((size / 4) * 5 + ((size % 4) ? (size % 4) + 1 : 0), b.encode<Z85>().size());
+    EXPECT_TRUE(b == Blob::decode<Z85>(b.encode<Z85>()));
+  }
+
+  // Reversibility of random strings
+  EXPECT_TRUE(testReversibility(encode_z85, decode_z85));
+  EXPECT_TRUE(testReversibility(encode_ascii85, decode_ascii85));
+
+  // Groups may not exceed 32 bits, in the scalar or vectorized paths
+  EXPECT_EQ(Blob("\xff\xff\xff\xff", 4), Blob::decode<Z85>("%nSc0"));
+  EXPECT_TRUE(failsAt<Z85>("%nSc1", 0));
+  EXPECT_TRUE(failsAt<Ascii85>("9jqo^s8W-\"", 5));
+  string longText(200, '0');
+  longText.replace(100, 5, "%nSc1");
+  EXPECT_TRUE(failsAt<Z85>(longText, 100));
+
+  // A lone trailing digit, and a zero group inside a group
+  EXPECT_TRUE(failsAt<Z85>("HelloW", 5));
+  EXPECT_TRUE(failsAt<Ascii85>("9jzo^", 2));
+}
+
+// Return true if equalsEncoded() agrees with decoding and comparing, for
+// equal data and for each kind of difference
+template<typename Codec>
+static bool testEqualsEncoded(Blob::CompareType cmp)
+{
+  for (int i = 0; i < nRandTests / 4; i++) {
+    Blob a = randomBlob();
+    string s = a.encode<Codec>();
+    if (!a.equalsEncoded<Codec>(s, cmp)) {
+      return false;
+    }
+    MutableBlob changed(a);
+    changed[changed.size() - 1] ^= 0x01;
+    Blob shorter(a, a.size() - 1);
+    Blob longer({a, Blob("\x01", 1)});
+    if (Blob(changed).equalsEncoded<Codec>(s, cmp) || shorter.equalsEncoded<Codec>(s, cmp) ||
+        longer.equalsEncoded<Codec>(s, cmp)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(ByteEncodersTest, EqualsEncoded) {
+  const Blob::CompareType types[] = {Blob::CompareType::DEFAULT, Blob::CompareType::CONST};
+  for (Blob::CompareType cmp : types) {
+    EXPECT_TRUE(testEqualsEncoded<String>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Bin>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Hex>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Base32>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Base58>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Base64>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Base64Pad>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Base64Mime>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Z85>(cmp));
+    EXPECT_TRUE(testEqualsEncoded<Ascii85>(cmp));
+
+    // Text decoded in many pieces, differing only in the last one
+    MutableBlob big(10000);
+    for (U64 i = 0; i < big.size(); i++) {
+      big[i] = (Byte)(i * 7);
+    }
+    string hex = Blob(big).encode<Hex>();
+    EXPECT_TRUE(big.equalsEncoded(hex, Hex(), cmp));
+    hex[hex.size() - 1] = (hex[hex.size() - 1] == '0') ? '1' : '0';
+    EXPECT_FALSE(big.equalsEncoded(hex, Hex(), cmp));
+    EXPECT_FALSE(Blob(big, 100).equalsEncoded(hex, Hex(), cmp));
+
+    // Padding within the text is invalid, even where it ends a piece
+    string padded;
+    for (U32 i = 0; i < 1364; i++) {
+      padded += "QUJD";
+    }
+    padded += "QQ==QUJD";
+    string plain;
+    for (U32 i = 0; i < 1364; i++) {
+      plain += "ABC";
+    }
+    plain += "AABC";
+    Blob tokens;
+    EXPECT_FALSE(Blob::tryDecode<Base64Pad>(padded, tokens).ok());
+    EXPECT_FALSE(Blob(plain).equalsEncoded<Base64Pad>(padded, cmp));
+
+    // Text which cannot be split, larger than the stack buffer
+    MutableBlob wide(5000);
+    for (U64 i = 0; i < wide.size(); i++) {
+      wide[i] = (Byte)(i * 13 + 1);
+    }
+    string base58 = Blob(wide).encode<Base58>();
+    EXPECT_TRUE(wide.equalsEncoded(base58, Base58(), cmp));
+    EXPECT_FALSE(Blob(wide, 4999).equalsEncoded(base58, Base58(), cmp));
+
+    // Invalid text is never equal, even as a prefix of the data
+    EXPECT_FALSE(b1.equalsEncoded<Hex>("4475", cmp) || b1.equalsEncoded<Hex>("447X", cmp));
+    EXPECT_TRUE(Blob().equalsEncoded<Base64Pad>("", cmp));
+    EXPECT_FALSE(Blob().equalsEncoded<Base64Pad>("=", cmp));
+  }
+}
+
+TEST(ByteEncodersTest, CachedEncoding) {
+  Blob blob;
+  {
+    // Nothing is cached while a MutableBlob can still write the data
+    MutableBlob mutableBlob((const Byte *)s1.data(), s1.size());
+    blob = mutableBlob;
+    std::shared_ptr<const string> before = blob.cachedEncode<Hex>();
+    EXPECT_EQ(blob.encode<Hex>(), *before);
+    EXPECT_NE(before, blob.cachedEncode<Hex>());
+    mutableBlob[0] ^= 0xff;
+    EXPECT_EQ(blob.encode<Hex>(), *blob.cachedEncode<Hex>());
+    EXPECT_NE(*before, *blob.cachedEncode<Hex>());
+    mutableBlob[0] ^= 0xff;
+  }
+  std::shared_ptr<const string> hex = blob.cachedEncode<Hex>();
+  EXPECT_EQ(blob.encode<Hex>(), *hex);
+  EXPECT_EQ(hex, blob.cachedEncode<Hex>());   // shared, not encoded again
+  EXPECT_EQ(hex, Blob(blob).cachedEncode<Hex>());
+
+  // One entry per codec, and per encoder
+  std::shared_ptr<const string> base58 = blob.cachedData(encode_base58);
+  EXPECT_EQ(*blob.data(encode_base58), *base58);
+  EXPECT_EQ(base58, blob.cachedData(encode_base58));
+  EXPECT_EQ(blob.encode<Base64>(), *blob.cachedEncode<Base64>());
+  EXPECT_EQ(hex, blob.cachedEncode<Hex>());
+
+  // Slices are not cached
+  Blob slice(blob, 10, 5);
+  EXPECT_EQ(slice.encode<Hex>(), *slice.cachedEncode<Hex>());
+  EXPECT_NE(slice.cachedEncode<Hex>(), slice.cachedEncode<Hex>());
+
+  // Nor is data moved out of a MutableBlob which is still alive
+  MutableBlob writer((const Byte *)s1.data(), s1.size());
+  Blob moved(std::move(writer));
+  EXPECT_NE(moved.cachedEncode<Hex>(), moved.cachedEncode<Hex>());
+  writer = MutableBlob(0);
+  EXPECT_EQ(moved.cachedEncode<Hex>(), moved.cachedEncode<Hex>());
+
+  Blob scrubbed((const Byte *)s2.data(), s2.size(), Blob::ScrubType::ZEROS);
+  EXPECT_EQ(scrubbed.encode<Hex>(), *scrubbed.cachedEncode<Hex>());
+  EXPECT_NE(nullptr, std::get_deleter<Container::EncodingScrubber>(scrubbed.cachedEncode<Hex>()));
+  EXPECT_NE(nullptr, std::get_deleter<Container::EncodingScrubber>(
+    Blob(scrubbed, 4, 1).cachedEncode<Hex>()));
+  EXPECT_EQ(nullptr, std::get_deleter<Container::EncodingScrubber>(hex));
+}
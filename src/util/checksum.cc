@@ -0,0 +1,234 @@
+#include "util/checksum.h"
+#include "util/dispatch.h"
+#include <cstring>
+
+// The variants compiled: both, to be chosen at load time, or else the one
+// the compiler flags allow
+#if defined(UTIL_DISPATCH)
+#define UTIL_CRC_SSE42
+#define UTIL_CRC_PORTABLE
+#elif __SSE4_2__
+#define UTIL_CRC_SSE42
+#else
+#define UTIL_CRC_PORTABLE
+#endif
+
+#ifdef UTIL_CRC_SSE42
+#include <nmmintrin.h>
+#endif
+
+using namespace Util;
+
+namespace {
+
+const U32 kPolynomial = 0x82f63b78;  // reflected
+const U64 kLong = 8192;              // interleaved stream lengths
+const U64 kShort = 256;
+
+inline U64 load64(const Byte *_p)
+{
+  U64 value;
+  memcpy((void *)&value, (const void *)_p, sizeof(value));
+  return value;
+}
+
+// Multiply two polynomials modulo the CRC polynomial. Bit 31 is the x^0 term
+// (the CRC bit order).
+U32 multiplyModP(U32 _a, U32 _b)
+{
+  U32 product = 0;
+  for (U32 m = 1U << 31; m != 0; m >>= 1) {
+    if (_a & m) {
+      product ^= _b;
+    }
+    _b = (_b & 1) ? (_b >> 1) ^ kPolynomial : _b >> 1;
+  }
+  return product;
+}
+
+struct Tables
+{
+  U32 slice[8][256];      // slicing-by-8: byte k positions from the end
+  U32 powers[64];         // x^(2^n) modulo P
+  U32 shiftLong[4][256];  // multiply by x^(8 * kLong), a byte at a time
+  U32 shiftShort[4][256]; // multiply by x^(8 * kShort)
+
+  Tables();
+
+  // x^(8 * bytes) modulo P: the operator appending 'bytes' zero bytes
+  U32 zeros(U64 bytes) const;
+};
+
+Tables::Tables()
+{
+  for (U32 b = 0; b < 256; b++) {
+    U32 crc = b;
+    for (U32 k = 0; k < 8; k++) {
+      crc = (crc & 1) ? (crc >> 1) ^ kPolynomial : crc >> 1;
+    }
+    slice[0][b] = crc;
+  }
+  for (U32 b = 0; b < 256; b++) {
+    for (U32 k = 1; k < 8; k++) {
+      slice[k][b] = (slice[k - 1][b] >> 8) ^ slice[0][slice[k - 1][b] & 0xff];
+    }
+  }
+
+  powers[0] = 1U << 30;  // x^1
+  for (U32 n = 1; n < 64; n++) {
+    powers[n] = multiplyModP(powers[n - 1], powers[n - 1]);
+  }
+
+  U32 longOperator = zeros(kLong);
+  U32 shortOperator = zeros(kShort);
+  for (U32 k = 0; k < 4; k++) {
+    for (U32 b = 0; b < 256; b++) {
+      shiftLong[k][b] = multiplyModP(longOperator, b << (8 * k));
+      shiftShort[k][b] = multiplyModP(shortOperator, b << (8 * k));
+    }
+  }
+}
+
+U32 Tables::zeros(U64 _bytes) const
+{
+  U32 result = 1U << 31;  // x^0
+  for (U32 n = 3; _bytes != 0; _bytes >>= 1, n++) {
+    if (_bytes & 1) {
+      result = multiplyModP(powers[n & 63], result);
+    }
+  }
+  return result;
+}
+
+const Tables &tables()
+{
+  static const Tables instance;
+  return instance;
+}
+
+#ifdef UTIL_CRC_SSE42
+#ifdef UTIL_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#endif
+namespace Sse42 {
+
+inline U32 shift(const U32 _table[4][256], U32 _crc)
+{
+  return _table[0][_crc & 0xff] ^ _table[1][(_crc >> 8) & 0xff] ^
+    _table[2][(_crc >> 16) & 0xff] ^ _table[3][_crc >> 24];
+}
+
+// Three streams of 'length' bytes each, merged into 'crc'
+inline U64 crcStreams(U64 _crc, const Byte *_data, U64 _length, const U32 _shift[4][256])
+{
+  U64 crc1 = 0;
+  U64 crc2 = 0;
+  for (U64 i = 0; i < _length; i += 8) {
+    _crc = _mm_crc32_u64(_crc, load64(&_data[i]));
+    crc1 = _mm_crc32_u64(crc1, load64(&_data[_length + i]));
+    crc2 = _mm_crc32_u64(crc2, load64(&_data[2 * _length + i]));
+  }
+  _crc = shift(_shift, (U32)_crc) ^ crc1;
+  return shift(_shift, (U32)_crc) ^ crc2;
+}
+
+U32 update(U32 _crc, const Byte *_data, U64 _size)
+{
+  U64 crc = _crc;
+  while ((_size > 0) && (((U64)_data & 7) != 0)) {
+    crc = _mm_crc32_u8((U32)crc, *_data++);
+    _size--;
+  }
+  if (_size >= 3 * kShort) {
+    const Tables &t = tables();
+    for (; _size >= 3 * kLong; _data += 3 * kLong, _size -= 3 * kLong) {
+      crc = crcStreams(crc, _data, kLong, t.shiftLong);
+    }
+    for (; _size >= 3 * kShort; _data += 3 * kShort, _size -= 3 * kShort) {
+      crc = crcStreams(crc, _data, kShort, t.shiftShort);
+    }
+  }
+  for (; _size >= 8; _data += 8, _size -= 8) {
+    crc = _mm_crc32_u64(crc, load64(_data));
+  }
+  for (; _size > 0; _size--) {
+    crc = _mm_crc32_u8((U32)crc, *_data++);
+  }
+  return (U32)crc;
+}
+
+U32 crc32c(const Byte *_data, U64 _size, U32 _crc)
+{
+  return ~update(~_crc, _data, _size);
+}
+
+} // namespace Sse42
+#ifdef UTIL_DISPATCH
+#pragma GCC pop_options
+#endif
+#endif
+
+#ifdef UTIL_CRC_PORTABLE
+namespace Portable {
+
+U32 update(U32 _crc, const Byte *_data, U64 _size)
+{
+  const Tables &t = tables();
+  for (; _size >= 8; _data += 8, _size -= 8) {
+    U64 word = load64(_data) ^ _crc;
+    _crc = t.slice[7][word & 0xff] ^ t.slice[6][(word >> 8) & 0xff] ^
+      t.slice[5][(word >> 16) & 0xff] ^ t.slice[4][(word >> 24) & 0xff] ^
+      t.slice[3][(word >> 32) & 0xff] ^ t.slice[2][(word >> 40) & 0xff] ^
+      t.slice[1][(word >> 48) & 0xff] ^ t.slice[0][word >> 56];
+  }
+  for (; _size > 0; _size--) {
+    _crc = (_crc >> 8) ^ t.slice[0][(_crc ^ *_data++) & 0xff];
+  }
+  return _crc;
+}
+
+U32 crc32c(const Byte *_data, U64 _size, U32 _crc)
+{
+  return ~update(~_crc, _data, _size);
+}
+
+} // namespace Portable
+#endif
+
+} // anonymous namespace
+
+
+#ifdef UTIL_DISPATCH
+extern "C" {
+
+UTIL_RESOLVER
+static decltype(&Portable::crc32c) util_resolve_crc32c()
+{
+  return Cpu::hasSse42() ? &Sse42::crc32c : &Portable::crc32c;
+}
+
+} // extern "C"
+
+namespace Util {
+
+U32 crc32c(const Byte *, U64, U32) __attribute__((ifunc("util_resolve_crc32c")));
+
+} // namespace Util
+#else
+U32 Util::crc32c(const Byte *_data, U64 _size, U32 _crc)
+{
+#ifdef UTIL_CRC_SSE42
+  return Sse42::crc32c(_data, _size, _crc);
+#else
+  return Portable::crc32c(_data, _size, _crc);
+#endif
+}
+#endif
+
+// Appending B to A multiplies A's checksum by x^(8 * sizeB); the pre- and
+// post-conditioning cancel out because the CRC is linear
+U32 Util::crc32cCombine(U32 _crcA, U32 _crcB, U64 _sizeB)
+{
+  return multiplyModP(tables().zeros(_sizeB), _crcA) ^ _crcB;
+}
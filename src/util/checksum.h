@@ -0,0 +1,30 @@
+#ifndef UTIL_CHECKSUM_H
+#define UTIL_CHECKSUM_H
+
+#include "util/fixed_types.h"
+
+namespace Util {
+
+/*
+   CRC32C (the Castagnoli polynomial, as used by iSCSI, ext4 and many storage
+   formats) for verifying data integrity.
+
+   With SSE4.2 the checksum is computed with the 'crc32' instruction over
+   three interleaved streams, which hides the instruction's latency; the
+   streams are merged with precomputed shift tables. Otherwise a portable
+   slicing-by-8 table implementation is used. Both produce the same values.
+
+   Checksums are incremental: crc32c(b, n, crc32c(a, m)) is the checksum of
+   'a' followed by 'b'. crc32cCombine() merges the checksums of two adjacent
+   pieces without their data, so the checksums of slices computed separately
+   (e.g. in parallel) can be joined.
+*/
+
+U32 crc32c(const Byte *data, U64 size, U32 crc = 0);
+
+// The checksum of A followed by B, given crc32c(A), crc32c(B) and B's size
+U32 crc32cCombine(U32 crcA, U32 crcB, U64 sizeB);
+
+} // namespace Util
+
+#endif // UTIL_CHECKSUM_H
@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include "util/checksum.h"
+#include "util/blob.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+// Bit-at-a-time reference
+U32 reference(const Byte *data, U64 size)
+{
+  U32 crc = ~0U;
+  for (U64 i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (int k = 0; k < 8; k++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+std::vector<Byte> randomBytes(U64 size)
+{
+  std::default_random_engine gen(11);
+  std::uniform_int_distribution<U32> dist(0, 255);
+  std::vector<Byte> bytes(size);
+  for (U64 i = 0; i < size; i++) {
+    bytes[i] = (Byte)dist(gen);
+  }
+  return bytes;
+}
+
+} // anonymous namespace
+
+
+TEST(ChecksumTest, KnownValues) {
+  EXPECT_EQ(0U, crc32c(nullptr, 0));
+  EXPECT_EQ(0xe3069283U, crc32c((const Byte *)"123456789", 9));
+
+  // RFC 3720 (iSCSI) test vectors
+  std::vector<Byte> zeros(32, 0x00);
+  std::vector<Byte> ones(32, 0xff);
+  std::vector<Byte> ascending(32);
+  for (U32 i = 0; i < 32; i++) {
+    ascending[i] = (Byte)i;
+  }
+  EXPECT_EQ(0x8a9136aaU, crc32c(zeros.data(), 32));
+  EXPECT_EQ(0x62a8ab43U, crc32c(ones.data(), 32));
+  EXPECT_EQ(0x46dd794eU, crc32c(ascending.data(), 32));
+}
+
+TEST(ChecksumTest, Incremental) {
+  // Sizes and offsets covering unaligned heads and both stream lengths
+  std::vector<Byte> data = randomBytes(3 * 8192 + 3 * 256 + 100);
+  for (U64 offset : {0UL, 1UL, 5UL}) {
+    for (U64 size : {0UL, 7UL, 8UL, 767UL, 768UL, 1000UL, 24576UL, 25000UL}) {
+      const Byte *p = &data[offset];
+      U32 expected = reference(p, size);
+      EXPECT_EQ(expected, crc32c(p, size)) << offset << " " << size;
+      U64 half = size / 3;
+      EXPECT_EQ(expected, crc32c(&p[half], size - half, crc32c(p, half)));
+    }
+  }
+}
+
+TEST(ChecksumTest, Combine) {
+  std::vector<Byte> data = randomBytes(50000);
+  U32 whole = crc32c(data.data(), data.size());
+  for (U64 split : {0UL, 1UL, 255UL, 4096UL, 30001UL, 50000UL}) {
+    U32 a = crc32c(data.data(), split);
+    U32 b = crc32c(&data[split], data.size() - split);
+    EXPECT_EQ(whole, crc32cCombine(a, b, data.size() - split)) << split;
+  }
+}
+
+TEST(ChecksumTest, BlobCache) {
+  std::vector<Byte> data = randomBytes(1000);
+  U32 expected = crc32c(data.data(), data.size());
+
+  Blob blob;
+  {
+    // Nothing is cached while a MutableBlob can still write the data, so
+    // pointers held for writing never leave a stale checksum behind
+    MutableBlob mutableBlob(data.data(), data.size());
+    Byte *write = mutableBlob.data();
+    blob = mutableBlob;
+    EXPECT_EQ(expected, blob.crc32c());
+    write[0] ^= 0xff;
+    data[0] ^= 0xff;
+    EXPECT_EQ(crc32c(data.data(), data.size()), blob.crc32c());
+    mutableBlob[1] ^= 0xff;
+    data[1] ^= 0xff;
+    EXPECT_EQ(crc32c(data.data(), data.size()), blob.crc32c());
+    expected = crc32c(data.data(), data.size());
+  }
+  EXPECT_EQ(expected, blob.crc32c());
+  EXPECT_EQ(expected, blob.crc32c());
+  EXPECT_EQ(expected, blob.view().crc32c());
+
+  // Slices are not cached
+  Blob slice(blob, 100, 10);
+  EXPECT_EQ(crc32c(&data[10], 100), slice.crc32c());
+  EXPECT_EQ(expected, blob.crc32c());
+}
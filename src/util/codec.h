@@ -0,0 +1,68 @@
+#ifndef UTIL_CODEC_H
+#define UTIL_CODEC_H
+
+#include "util/fixed_types.h"
+
+namespace Util {
+
+/*
+   Codecs convert binary data to text and back. A codec is a class with only
+   static members, which can be used at compile time with Blob::encode<Codec>()
+   and Blob::decode<Codec>() so the kernel is inlined and the result is
+   returned by value, or with Blob::equalsEncoded<Codec>() to compare without
+   allocating:
+
+     struct Codec
+     {
+       // Input bytes per independently encoded group, or 0 when the whole
+       // input is a single group (e.g. the bignum codecs)
+       static const U64 kBlockSize;
+
+       // Characters per independently decodable group, or 0 when the text
+       // cannot be split (line breaks, variable-length groups, bignums)
+       static const U64 kTextBlockSize;
+
+       // Upper bound on the number of characters produced for 'size' bytes
+       static U64 encodedSize(U64 size);
+
+       // Encode into 'out' (encodedSize(size) chars); returns chars written
+       static U64 encode(const Byte *data, U64 size, char *out);
+
+       // Upper bound on the number of bytes produced for the given text
+       static U64 decodedSize(const Byte *data, U64 size);
+
+       // Validate and decode into 'out' (decodedSize() bytes) in one pass
+       static DecodeStatus decode(const Byte *data, U64 size, Byte *out);
+     };
+
+   The codecs are defined in byte_encoders.h.
+*/
+
+// The result of decoding: the number of bytes written, or the offset of the
+// first character which is not valid input
+struct DecodeStatus
+{
+  static const U64 kValid = ~0UL;
+
+  U64 size;
+  U64 errorOffset;
+
+  bool ok() const
+  {
+    return errorOffset == kValid;
+  }
+
+  static DecodeStatus success(U64 size)
+  {
+    return DecodeStatus{size, kValid};
+  }
+
+  static DecodeStatus failure(U64 offset)
+  {
+    return DecodeStatus{0, offset};
+  }
+};
+
+} // namespace Util
+
+#endif // UTIL_CODEC_H
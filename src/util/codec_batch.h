@@ -0,0 +1,162 @@
+#ifndef UTIL_CODEC_BATCH_H
+#define UTIL_CODEC_BATCH_H
+
+#include "util/fixed_types.h"
+#include "util/blob.h"
+#include "util/byte_encoders.h"
+#include <string>
+#include <vector>
+
+namespace Util {
+
+/*
+   Batch encoding writes the text of many Blobs into one arena. The whole
+   batch costs a single allocation instead of a std::string (and a call
+   through std::function) per Blob, and reusing an EncodedBatch reuses its
+   arena. Entry i is a TextView of the arena.
+
+   Codecs which encode each byte on its own (kBlockSize 1: Hex, Bin) encode
+   runs of inputs which are adjacent in memory, such as consecutive slices of
+   one container, in a single call so the vector kernels see long inputs.
+   The bignum codecs reuse one bignum across the batch.
+
+     Util::EncodedBatch ids;
+     ids.encode<Util::Base58>(keys.data(), keys.size());
+     Util::TextView first = ids[0];
+*/
+
+// Encoded text owned by an EncodedBatch; valid until the batch changes
+struct TextView
+{
+  const char *data;
+  U64 size;
+
+  std::string str() const
+  {
+    return std::string(data, size);
+  }
+};
+
+inline bool operator==(const TextView &_a, const std::string &_b)
+{
+  return _a.size == _b.size() && memcmp((const void *)_a.data, (const void *)_b.data(), _a.size) == 0;
+}
+
+inline bool operator!=(const TextView &_a, const std::string &_b)
+{
+  return !(_a == _b);
+}
+
+// Encodes one input at a time, keeping any state the codec can reuse
+template<typename Codec>
+struct BatchEncoder
+{
+  U64 encode(const Byte *data, U64 size, char *out)
+  {
+    return Codec::encode(data, size, out);
+  }
+};
+
+template<U32 Base, typename Alphabet>
+struct BatchEncoder<BignumCodec<Base, Alphabet>>
+{
+  U64 encode(const Byte *data, U64 size, char *out)
+  {
+    return BignumCodec<Base, Alphabet>::encode(data, size, out, scratch);
+  }
+
+  typename BignumCodec<Base, Alphabet>::Scratch scratch;
+};
+
+class EncodedBatch
+{
+ public:
+  EncodedBatch();
+
+  // Replace the contents with the encodings of 'count' Blobs (or BlobViews)
+  template<typename Codec, typename B> void encode(const B *blobs, U64 count);
+  template<typename Codec> void encode(const std::vector<Blob> &blobs);
+
+  // The number of entries
+  U64 size() const;
+  TextView operator[](U64 index) const;
+
+  // Every entry back to back; entry i is text()[offset(i), offset(i + 1))
+  const std::string &text() const;
+  U64 offset(U64 index) const;
+
+ private:
+  std::string text_;
+  std::vector<U64> offsets_;   // size() + 1 entries
+};
+
+inline EncodedBatch::EncodedBatch()
+  : offsets_(1, 0)
+{
+}
+
+template<typename Codec, typename B>
+void EncodedBatch::encode(const B *_blobs, U64 _count)
+{
+  // Size the arena for the worst case, then trim it to what was written
+  U64 bound = 0;
+  for (U64 i = 0; i < _count; i++) {
+    bound += Codec::encodedSize(_blobs[i].size());
+  }
+  text_.resize(bound);
+  offsets_.resize(_count + 1);
+  offsets_[0] = 0;
+
+  BatchEncoder<Codec> encoder;
+  char *out = &text_[0];
+  U64 end = 0;
+  for (U64 i = 0; i < _count; ) {
+    const Byte *data = _blobs[i].data();
+    U64 size = _blobs[i].size();
+    U64 next = i + 1;
+    if (Codec::kBlockSize == 1) {
+      // The encoded size is exact, so the offsets within a run are known
+      offsets_[next] = end + Codec::encodedSize(size);
+      while (size > 0 && next < _count && _blobs[next].size() > 0 &&
+             _blobs[next].data() == &data[size]) {
+        size += _blobs[next].size();
+        next++;
+        offsets_[next] = end + Codec::encodedSize(size);
+      }
+    }
+    end += encoder.encode(data, size, &out[end]);
+    offsets_[next] = end;
+    i = next;
+  }
+  text_.resize(end);
+}
+
+template<typename Codec>
+void EncodedBatch::encode(const std::vector<Blob> &_blobs)
+{
+  encode<Codec>(_blobs.data(), _blobs.size());
+}
+
+inline U64 EncodedBatch::size() const
+{
+  return offsets_.size() - 1;
+}
+
+inline TextView EncodedBatch::operator[](U64 _index) const
+{
+  return TextView{&text_.data()[offsets_[_index]], offsets_[_index + 1] - offsets_[_index]};
+}
+
+inline const std::string &EncodedBatch::text() const
+{
+  return text_;
+}
+
+inline U64 EncodedBatch::offset(U64 _index) const
+{
+  return offsets_[_index];
+}
+
+} // namespace Util
+
+#endif // UTIL_CODEC_BATCH_H
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include "util/codec_batch.h"
+#include "util/blob.h"
+#include <string>
+#include <vector>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+// Inputs of assorted sizes, with leading zeros, and consecutive slices of one
+// container (which the fixed-width codecs encode in one run)
+std::vector<Blob> inputs()
+{
+  MutableBlob whole(200);
+  for (U64 i = 0; i < whole.size(); i++) {
+    whole[i] = (Byte)(i * 37 + 11);
+  }
+  whole[40] = 0;
+  whole[41] = 0;
+  Blob shared(whole);
+  std::vector<Blob> blobs;
+  blobs.push_back(Blob(shared, 32, 0));
+  blobs.push_back(Blob(shared, 8, 32));
+  blobs.push_back(Blob(shared, 60, 40));
+  blobs.push_back(Blob());
+  blobs.push_back(Blob(shared, 100, 100));
+  blobs.push_back(Blob(shared, 1, 3));
+  blobs.push_back(Blob(string(17, '\0')));
+  return blobs;
+}
+
+template<typename Codec>
+void expectSameAsEach(const std::vector<Blob> &blobs)
+{
+  EncodedBatch batch;
+  batch.encode<Codec>(blobs);
+  ASSERT_EQ(blobs.size(), batch.size());
+  for (U64 i = 0; i < blobs.size(); i++) {
+    EXPECT_EQ(blobs[i].encode<Codec>(), batch[i].str()) << i;
+    EXPECT_EQ(batch.offset(i + 1) - batch.offset(i), batch[i].size);
+  }
+  EXPECT_EQ(batch.offset(batch.size()), batch.text().size());
+}
+
+} // anonymous namespace
+
+TEST(CodecBatchTest, Encode) {
+  std::vector<Blob> blobs = inputs();
+  expectSameAsEach<Hex>(blobs);
+  expectSameAsEach<Bin>(blobs);
+  expectSameAsEach<Base32>(blobs);
+  expectSameAsEach<Base58>(blobs);
+  expectSameAsEach<Base62>(blobs);
+  expectSameAsEach<Base64>(blobs);
+  expectSameAsEach<Base64Mime>(blobs);
+  expectSameAsEach<Z85>(blobs);
+}
+
+TEST(CodecBatchTest, Reuse) {
+  std::vector<Blob> blobs = inputs();
+  EncodedBatch batch;
+  EXPECT_EQ(0U, batch.size());
+  batch.encode<Base58>(blobs);
+  batch.encode<Hex>(blobs.data(), 2);
+  EXPECT_EQ(2U, batch.size());
+  EXPECT_EQ(blobs[1].encode<Hex>(), batch[1].str());
+  EXPECT_EQ(batch[0].size + batch[1].size, batch.text().size());
+
+  // Views work as well as Blobs
+  std::vector<BlobView> views;
+  for (const Blob &blob : blobs) {
+    views.push_back(blob.view());
+  }
+  batch.encode<Base58>(views.data(), views.size());
+  EXPECT_TRUE(batch[2] == blobs[2].encode<Base58>());
+  EXPECT_TRUE(batch[3] == string());
+
+  batch.encode<Hex>(views.data(), 0);
+  EXPECT_EQ(0U, batch.size());
+  EXPECT_EQ(0U, batch.text().size());
+}
@@ -0,0 +1,910 @@
+#include "util/codec_kernels.h"
+#include "util/dispatch.h"
+
+// The variants compiled: all of them to be chosen at load time, or else the
+// best the compiler flags allow
+#if defined(UTIL_DISPATCH)
+#define UTIL_KERNELS_AVX2
+#define UTIL_KERNELS_SSSE3
+#define UTIL_KERNELS_PORTABLE
+#elif defined(__AVX2__)
+#define UTIL_KERNELS_AVX2
+#elif defined(__SSSE3__)
+#define UTIL_KERNELS_SSSE3
+#else
+#define UTIL_KERNELS_PORTABLE
+#endif
+
+#if defined(UTIL_KERNELS_AVX2) || defined(UTIL_KERNELS_SSSE3)
+#include <immintrin.h>
+#endif
+
+using namespace Util;
+
+// Hex digits (either case)
+const Byte Kernels::kHexValues[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 58 digits
+const Byte Kernels::kBase58Values[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0xff, 0x11, 0x12, 0x13, 0x14, 0x15, 0xff,
+  0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0xff, 0x2c, 0x2d, 0x2e,
+  0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 62 digits
+const Byte Kernels::kBase62Values[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+  0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32,
+  0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 64 digits (standard alphabet)
+const Byte Kernels::kBase64Values[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+  0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 64 digits (URL and filename safe alphabet)
+const Byte Kernels::kBase64UrlValues[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+  0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0x3f,
+  0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 32 digits (RFC 4648, either case)
+const Byte Kernels::kBase32Values[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+  0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+  0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 32 digits (Crockford, either case; I and L read as 1, O as 0)
+const Byte Kernels::kBase32CrockfordValues[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x01, 0x12, 0x13, 0x01, 0x14, 0x15, 0x00,
+  0x16, 0x17, 0x18, 0x19, 0x1a, 0xff, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x01, 0x12, 0x13, 0x01, 0x14, 0x15, 0x00,
+  0x16, 0x17, 0x18, 0x19, 0x1a, 0xff, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 85 digits (Z85)
+const Byte Kernels::kZ85Values[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x44, 0xff, 0x54, 0x53, 0x52, 0x48, 0xff, 0x4b, 0x4c, 0x46, 0x41, 0xff, 0x3f, 0x3e, 0x45,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x40, 0xff, 0x49, 0x42, 0x4a, 0x47,
+  0x51, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32,
+  0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x4d, 0xff, 0x4e, 0x43, 0xff,
+  0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+  0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x4f, 0xff, 0x50, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Base 85 digits (Ascii85; 'z' is not a digit)
+const Byte Kernels::kAscii85Values[256] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+  0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e,
+  0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e,
+  0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e,
+  0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e,
+  0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Vector tables for the base 64 alphabets. A character is valid when
+// lutLo[low nibble] & lutHi[high nibble] is zero. Its value is the character
+// plus lutRoll[high nibble], where the 'special' character instead uses
+// lutRoll[high nibble | 8] (see Mula & Lemire, "Faster Base64 Encoding and
+// Decoding Using AVX2 Instructions").
+const Kernels::Base64Tables Kernels::kBase64Standard = {
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+  Kernels::kBase64Values,
+  {0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a},
+  {0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10},
+  {0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 16, 0, 0, 0, 0, 0},
+  '/'
+};
+
+const Kernels::Base64Tables Kernels::kBase64Url = {
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_",
+  Kernels::kBase64UrlValues,
+  {0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x3b, 0x3b, 0x3a, 0x3b, 0x33},
+  {0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x20, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10},
+  {0, 0, 17, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, -32, 0, 0},
+  '_'
+};
+
+// The variants of each kernel, in namespaces named after their target
+namespace Util {
+namespace Kernels {
+namespace {
+
+#if defined(UTIL_KERNELS_AVX2)
+#ifdef UTIL_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+namespace Avx2 {
+
+U64 decode_hex_bulk(const Byte *_data, U64 _size, Byte *_out)
+{
+  const __m256i zero = _mm256_set1_epi8('0');
+  const __m256i lowerA = _mm256_set1_epi8('a');
+  const __m256i lowerCase = _mm256_set1_epi8(0x20);
+  const __m256i nine = _mm256_set1_epi8(9);
+  const __m256i five = _mm256_set1_epi8(5);
+  const __m256i ten = _mm256_set1_epi8(10);
+  const __m256i weights = _mm256_set1_epi16(0x0110);  // high nibble * 16 + low
+
+  U64 i = 0;
+  for (; i + 32 <= _size; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&_data[i]);
+
+    // Range checks: v - '0' <= 9 or (v | 0x20) - 'a' <= 5 (unsigned)
+    __m256i digit = _mm256_sub_epi8(v, zero);
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, nine), digit);
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(v, lowerCase), lowerA);
+    __m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, five), alpha);
+    if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) != -1) {
+      break;
+    }
+    __m256i nibbles = _mm256_blendv_epi8(digit, _mm256_add_epi8(alpha, ten), isAlpha);
+
+    // Combine nibble pairs into 16-bit lanes, then pack to bytes
+    __m256i bytes = _mm256_maddubs_epi16(nibbles, weights);
+    bytes = _mm256_packus_epi16(bytes, bytes);
+    bytes = _mm256_permute4x64_epi64(bytes, 0x08);
+    _mm_storeu_si128((__m128i *)&_out[i / 2], _mm256_castsi256_si128(bytes));
+  }
+  return i;
+}
+
+U64 encode_hex_bulk(const Byte *_data, U64 _size, char *_out)
+{
+  const __m256i digits = _mm256_setr_epi8(
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+  U64 i = 0;
+  for (; i + 32 <= _size; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&_data[i]);
+    __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, nibble));
+    // Interleaving works within 128-bit lanes: bytes 0-7 and 16-23, then 8-15 and 24-31
+    __m256i first = _mm256_unpacklo_epi8(hi, lo);
+    __m256i second = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i *)&_out[2 * i], _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256((__m256i *)&_out[2 * i + 32],
+      _mm256_permute2x128_si256(first, second, 0x31));
+  }
+  return i;
+}
+
+U64 decode_base64_bulk(const Byte *_data, U64 _size, Byte *_out,
+  const Base64Tables &_tables)
+{
+  const __m256i lutLo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)_tables.lutLo));
+  const __m256i lutHi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)_tables.lutHi));
+  const __m256i lutRoll = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)_tables.lutRoll));
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  const __m256i eight = _mm256_set1_epi8(0x08);
+  const __m256i special = _mm256_set1_epi8((char)_tables.special);
+  const __m256i pack = _mm256_setr_epi8(
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+  // Each store writes 32 bytes of which 24 are output, so stop while at
+  // least 64 characters (48 output bytes) remain
+  U64 i = 0;
+  for (; i + 64 <= _size; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&_data[i]);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi32(v, 4), nibble);
+    __m256i lo = _mm256_and_si256(v, nibble);
+    __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(lutLo, lo), _mm256_shuffle_epi8(lutHi, hi));
+    if (!_mm256_testz_si256(invalid, invalid)) {
+      break;
+    }
+    __m256i index = _mm256_or_si256(hi, _mm256_and_si256(_mm256_cmpeq_epi8(v, special), eight));
+    __m256i values = _mm256_add_epi8(v, _mm256_shuffle_epi8(lutRoll, index));
+
+    // Merge 4 x 6 bits into 24 bits per 32-bit lane, then drop the gaps
+    __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(merged, pack);
+    merged = _mm256_permutevar8x32_epi32(merged, gather);
+    _mm256_storeu_si256((__m256i *)&_out[(i / 4) * 3], merged);
+  }
+  return i;
+}
+
+// Split each 3 bytes of a 12-byte lane into four 6-bit indices (one per byte)
+static inline __m256i base64Indices(__m256i in)
+{
+  in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(
+    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+  __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+  __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+  __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+  return _mm256_or_si256(t1, t3);
+}
+
+U64 encode_base64_bulk(const Byte *_data, U64 _size, char *_out,
+  const Base64Tables &_tables)
+{
+  // Offsets from an index to its character, selected by index range
+  const __m256i shift = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, (char)(_tables.digits[62] - 62), (char)(_tables.digits[63] - 63),
+    'A', 0, 0));
+
+  // Two 12-byte groups per iteration, each read with a 16-byte load
+  U64 i = 0;
+  for (; i + 28 <= _size; i += 24) {
+    __m256i in = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&_data[i])),
+      _mm_loadu_si128((const __m128i *)&_data[i + 12]), 1);
+    __m256i indices = base64Indices(in);
+    __m256i select = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    select = _mm256_or_si256(select, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+    __m256i chars = _mm256_add_epi8(indices, _mm256_shuffle_epi8(shift, select));
+    _mm256_storeu_si256((__m256i *)&_out[(i / 3) * 4], chars);
+  }
+  return i;
+}
+
+// Translate characters to digit values with the part of a decode table for
+// 0x20-0x7f, one 16-entry shuffle per high nibble. Other characters become
+// 0xff (invalid).
+static inline __m256i digitValues(__m256i v, const __m256i *luts)
+{
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+  __m256i values = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v);
+  for (int g = 0; g < 6; g++) {
+    __m256i inRange = _mm256_cmpeq_epi8(hi, _mm256_set1_epi8((char)(g + 2)));
+    values = _mm256_or_si256(values, _mm256_and_si256(inRange, _mm256_shuffle_epi8(luts[g], v)));
+  }
+  return values;
+}
+
+static inline void loadDigitLuts(const Byte *values, __m256i *luts)
+{
+  for (int g = 0; g < 6; g++) {
+    luts[g] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&values[0x20 + 16 * g]));
+  }
+}
+
+U64 decode_base32_bulk(const Byte *_data, U64 _size, Byte *_out, const Byte *_values)
+{
+  __m256i luts[6];
+  loadDigitLuts(_values, luts);
+  const __m256i pack = _mm256_setr_epi8(
+    4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1,
+    4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1);
+  const __m256i low40 = _mm256_set1_epi64x(0xffffffffffL);
+
+  // Each lane is stored with 16 bytes of which 10 are output, so stop while
+  // at least 48 characters remain
+  U64 i = 0;
+  for (; i + 48 <= _size; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&_data[i]);
+    __m256i values = digitValues(v, luts);
+    if (_mm256_movemask_epi8(values) != 0) {
+      break;
+    }
+
+    // Merge 8 x 5 bits into 40 bits per 64-bit lane, then drop the gaps
+    __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0120));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00010400));
+    merged = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi64(merged, 20), low40),
+      _mm256_srli_epi64(merged, 32));
+    merged = _mm256_shuffle_epi8(merged, pack);
+    _mm_storeu_si128((__m128i *)&_out[(i / 8) * 5], _mm256_castsi256_si128(merged));
+    _mm_storeu_si128((__m128i *)&_out[(i / 8) * 5 + 10], _mm256_extracti128_si256(merged, 1));
+  }
+  return i;
+}
+
+U64 encode_base32_bulk(const Byte *_data, U64 _size, char *_out, const char *_digits)
+{
+  // Each 16-bit lane holds the two bytes containing one 5-bit index, which
+  // a multiply-high by a power of two shifts down into place
+  const __m256i spreadFirst = _mm256_setr_epi8(
+    1, 0, 1, 0, 2, 1, 2, 1, 3, 2, 4, 3, 4, 3, 5, 4,
+    1, 0, 1, 0, 2, 1, 2, 1, 3, 2, 4, 3, 4, 3, 5, 4);
+  const __m256i spreadSecond = _mm256_setr_epi8(
+    6, 5, 6, 5, 7, 6, 7, 6, 8, 7, 9, 8, 9, 8, 10, 9,
+    6, 5, 6, 5, 7, 6, 7, 6, 8, 7, 9, 8, 9, 8, 10, 9);
+  const __m256i shifts = _mm256_setr_epi16(
+    1 << 5, 1 << 10, 1 << 7, 1 << 12, 1 << 9, 1 << 6, 1 << 11, 1 << 8,
+    1 << 5, 1 << 10, 1 << 7, 1 << 12, 1 << 9, 1 << 6, 1 << 11, 1 << 8);
+  const __m256i mask = _mm256_set1_epi16(0x1f);
+  const __m256i lutLo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&_digits[0]));
+  const __m256i lutHi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&_digits[16]));
+  const __m256i fifteen = _mm256_set1_epi8(15);
+
+  // Two 10-byte groups per iteration, each read with a 16-byte load
+  U64 i = 0;
+  for (; i + 26 <= _size; i += 20) {
+    __m256i in = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&_data[i])),
+      _mm_loadu_si128((const __m128i *)&_data[i + 10]), 1);
+    __m256i first = _mm256_and_si256(_mm256_mulhi_epu16(_mm256_shuffle_epi8(in, spreadFirst), shifts), mask);
+    __m256i second = _mm256_and_si256(_mm256_mulhi_epu16(_mm256_shuffle_epi8(in, spreadSecond), shifts), mask);
+    __m256i indices = _mm256_packus_epi16(first, second);
+    __m256i chars = _mm256_blendv_epi8(_mm256_shuffle_epi8(lutLo, indices),
+      _mm256_shuffle_epi8(lutHi, indices), _mm256_cmpgt_epi8(indices, fifteen));
+    _mm256_storeu_si256((__m256i *)&_out[(i / 5) * 8], chars);
+  }
+  return i;
+}
+
+U64 decode_base85_bulk(const Byte *_data, U64 _size, Byte *_out, const Byte *_values)
+{
+  __m256i luts[6];
+  loadDigitLuts(_values, luts);
+  const __m256i leading = _mm256_setr_epi8(
+    0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, -1, -1, -1, -1,
+    0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, -1, -1, -1, -1);
+  const __m256i trailing = _mm256_setr_epi8(
+    4, -1, -1, -1, 9, -1, -1, -1, 14, -1, -1, -1, -1, -1, -1, -1,
+    4, -1, -1, -1, 9, -1, -1, -1, 14, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i pack = _mm256_setr_epi8(
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, -1, -1, -1, -1,
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, -1, -1, -1, -1);
+  const __m256i limit = _mm256_set1_epi32(0x03030303);  // (2^32 - 1) / 85
+  const __m256i zero = _mm256_setzero_si256();
+
+  // Three 5-digit groups per lane, each lane read with a 16-byte load and
+  // stored with 16 bytes of which 12 are output
+  U64 i = 0;
+  for (; i + 48 <= _size; i += 30) {
+    __m256i v = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&_data[i])),
+      _mm_loadu_si128((const __m128i *)&_data[i + 15]), 1);
+    __m256i values = digitValues(v, luts);
+    if (_mm256_movemask_epi8(values) != 0) {
+      break;
+    }
+
+    // The first four digits of each group in a 32-bit lane, then the value
+    // high * 85 + low, which must not exceed 2^32 - 1
+    __m256i high = _mm256_maddubs_epi16(_mm256_shuffle_epi8(values, leading), _mm256_set1_epi16(0x0155));
+    high = _mm256_madd_epi16(high, _mm256_set1_epi32(0x00011c39));
+    __m256i low = _mm256_shuffle_epi8(values, trailing);
+    __m256i overflow = _mm256_or_si256(_mm256_cmpgt_epi32(high, limit),
+      _mm256_and_si256(_mm256_cmpeq_epi32(high, limit), _mm256_cmpgt_epi32(low, zero)));
+    if (!_mm256_testz_si256(overflow, overflow)) {
+      break;
+    }
+    __m256i words = _mm256_add_epi32(_mm256_mullo_epi32(high, _mm256_set1_epi32(85)), low);
+    words = _mm256_shuffle_epi8(words, pack);
+    _mm_storeu_si128((__m128i *)&_out[(i / 5) * 4], _mm256_castsi256_si128(words));
+    _mm_storeu_si128((__m128i *)&_out[(i / 5) * 4 + 12], _mm256_extracti128_si256(words, 1));
+  }
+  return i;
+}
+
+} // namespace Avx2
+#ifdef UTIL_DISPATCH
+#pragma GCC pop_options
+#endif
+#endif
+
+#if defined(UTIL_KERNELS_SSSE3)
+#ifdef UTIL_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#endif
+namespace Ssse3 {
+
+U64 decode_hex_bulk(const Byte *_data, U64 _size, Byte *_out)
+{
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i lowerA = _mm_set1_epi8('a');
+  const __m128i lowerCase = _mm_set1_epi8(0x20);
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i five = _mm_set1_epi8(5);
+  const __m128i ten = _mm_set1_epi8(10);
+  const __m128i weights = _mm_set1_epi16(0x0110);
+
+  U64 i = 0;
+  for (; i + 16 <= _size; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)&_data[i]);
+    __m128i digit = _mm_sub_epi8(v, zero);
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+    __m128i alpha = _mm_sub_epi8(_mm_or_si128(v, lowerCase), lowerA);
+    __m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, five), alpha);
+    if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xffff) {
+      break;
+    }
+    __m128i nibbles = _mm_or_si128(_mm_andnot_si128(isAlpha, digit),
+      _mm_and_si128(isAlpha, _mm_add_epi8(alpha, ten)));
+    __m128i bytes = _mm_maddubs_epi16(nibbles, weights);
+    _mm_storel_epi64((__m128i *)&_out[i / 2], _mm_packus_epi16(bytes, bytes));
+  }
+  return i;
+}
+
+U64 encode_hex_bulk(const Byte *_data, U64 _size, char *_out)
+{
+  const __m128i digits = _mm_setr_epi8(
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+
+  U64 i = 0;
+  for (; i + 16 <= _size; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)&_data[i]);
+    __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+    __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, nibble));
+    _mm_storeu_si128((__m128i *)&_out[2 * i], _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *)&_out[2 * i + 16], _mm_unpackhi_epi8(hi, lo));
+  }
+  return i;
+}
+
+U64 decode_base64_bulk(const Byte *_data, U64 _size, Byte *_out,
+  const Base64Tables &_tables)
+{
+  const __m128i lutLo = _mm_loadu_si128((const __m128i *)_tables.lutLo);
+  const __m128i lutHi = _mm_loadu_si128((const __m128i *)_tables.lutHi);
+  const __m128i lutRoll = _mm_loadu_si128((const __m128i *)_tables.lutRoll);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i eight = _mm_set1_epi8(0x08);
+  const __m128i special = _mm_set1_epi8((char)_tables.special);
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  // Each store writes 16 bytes of which 12 are output
+  U64 i = 0;
+  for (; i + 32 <= _size; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)&_data[i]);
+    __m128i hi = _mm_and_si128(_mm_srli_epi32(v, 4), nibble);
+    __m128i lo = _mm_and_si128(v, nibble);
+    __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lutLo, lo), _mm_shuffle_epi8(lutHi, hi));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xffff) {
+      break;
+    }
+    __m128i index = _mm_or_si128(hi, _mm_and_si128(_mm_cmpeq_epi8(v, special), eight));
+    __m128i values = _mm_add_epi8(v, _mm_shuffle_epi8(lutRoll, index));
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128((__m128i *)&_out[(i / 4) * 3], _mm_shuffle_epi8(merged, pack));
+  }
+  return i;
+}
+
+U64 encode_base64_bulk(const Byte *_data, U64 _size, char *_out,
+  const Base64Tables &_tables)
+{
+  const __m128i shift = _mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, (char)(_tables.digits[62] - 62), (char)(_tables.digits[63] - 63),
+    'A', 0, 0);
+
+  U64 i = 0;
+  for (; i + 16 <= _size; i += 12) {
+    __m128i in = _mm_loadu_si128((const __m128i *)&_data[i]);
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+    __m128i select = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    select = _mm_or_si128(select, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    __m128i chars = _mm_add_epi8(indices, _mm_shuffle_epi8(shift, select));
+    _mm_storeu_si128((__m128i *)&_out[(i / 3) * 4], chars);
+  }
+  return i;
+}
+
+// Translate characters to digit values with the part of a decode table for
+// 0x20-0x7f, one 16-entry shuffle per high nibble. Other characters become
+// 0xff (invalid).
+static inline __m128i digitValues(__m128i v, const __m128i *luts)
+{
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+  __m128i values = _mm_cmpgt_epi8(_mm_set1_epi8(0x20), v);
+  for (int g = 0; g < 6; g++) {
+    __m128i inRange = _mm_cmpeq_epi8(hi, _mm_set1_epi8((char)(g + 2)));
+    values = _mm_or_si128(values, _mm_and_si128(inRange, _mm_shuffle_epi8(luts[g], v)));
+  }
+  return values;
+}
+
+static inline void loadDigitLuts(const Byte *values, __m128i *luts)
+{
+  for (int g = 0; g < 6; g++) {
+    luts[g] = _mm_loadu_si128((const __m128i *)&values[0x20 + 16 * g]);
+  }
+}
+
+U64 decode_base32_bulk(const Byte *_data, U64 _size, Byte *_out, const Byte *_values)
+{
+  __m128i luts[6];
+  loadDigitLuts(_values, luts);
+  const __m128i pack = _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1);
+  const __m128i low40 = _mm_set1_epi64x(0xffffffffffL);
+
+  // Each store writes 16 bytes of which 10 are output
+  U64 i = 0;
+  for (; i + 32 <= _size; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)&_data[i]);
+    __m128i values = digitValues(v, luts);
+    if (_mm_movemask_epi8(values) != 0) {
+      break;
+    }
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi16(0x0120));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00010400));
+    merged = _mm_or_si128(_mm_and_si128(_mm_slli_epi64(merged, 20), low40),
+      _mm_srli_epi64(merged, 32));
+    _mm_storeu_si128((__m128i *)&_out[(i / 8) * 5], _mm_shuffle_epi8(merged, pack));
+  }
+  return i;
+}
+
+U64 encode_base32_bulk(const Byte *_data, U64 _size, char *_out, const char *_digits)
+{
+  const __m128i spreadFirst = _mm_setr_epi8(1, 0, 1, 0, 2, 1, 2, 1, 3, 2, 4, 3, 4, 3, 5, 4);
+  const __m128i spreadSecond = _mm_setr_epi8(6, 5, 6, 5, 7, 6, 7, 6, 8, 7, 9, 8, 9, 8, 10, 9);
+  const __m128i shifts = _mm_setr_epi16(
+    1 << 5, 1 << 10, 1 << 7, 1 << 12, 1 << 9, 1 << 6, 1 << 11, 1 << 8);
+  const __m128i mask = _mm_set1_epi16(0x1f);
+  const __m128i lutLo = _mm_loadu_si128((const __m128i *)&_digits[0]);
+  const __m128i lutHi = _mm_loadu_si128((const __m128i *)&_digits[16]);
+  const __m128i fifteen = _mm_set1_epi8(15);
+
+  U64 i = 0;
+  for (; i + 16 <= _size; i += 10) {
+    __m128i in = _mm_loadu_si128((const __m128i *)&_data[i]);
+    __m128i first = _mm_and_si128(_mm_mulhi_epu16(_mm_shuffle_epi8(in, spreadFirst), shifts), mask);
+    __m128i second = _mm_and_si128(_mm_mulhi_epu16(_mm_shuffle_epi8(in, spreadSecond), shifts), mask);
+    __m128i indices = _mm_packus_epi16(first, second);
+    __m128i upper = _mm_cmpgt_epi8(indices, fifteen);
+    __m128i chars = _mm_or_si128(_mm_andnot_si128(upper, _mm_shuffle_epi8(lutLo, indices)),
+      _mm_and_si128(upper, _mm_shuffle_epi8(lutHi, indices)));
+    _mm_storeu_si128((__m128i *)&_out[(i / 5) * 8], chars);
+  }
+  return i;
+}
+
+U64 decode_base85_bulk(const Byte *_data, U64 _size, Byte *_out, const Byte *_values)
+{
+  __m128i luts[6];
+  loadDigitLuts(_values, luts);
+  const __m128i leading = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, -1, -1, -1, -1);
+  const __m128i trailing = _mm_setr_epi8(4, -1, -1, -1, 9, -1, -1, -1, 14, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i pack = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, -1, -1, -1, -1);
+  const __m128i limit = _mm_set1_epi32(0x03030303);
+  const __m128i zero = _mm_setzero_si128();
+
+  // Three 5-digit groups per iteration; each store writes 16 bytes of which
+  // 12 are output
+  U64 i = 0;
+  for (; i + 32 <= _size; i += 15) {
+    __m128i v = _mm_loadu_si128((const __m128i *)&_data[i]);
+    __m128i values = digitValues(v, luts);
+    if (_mm_movemask_epi8(values) != 0) {
+      break;
+    }
+    __m128i high = _mm_maddubs_epi16(_mm_shuffle_epi8(values, leading), _mm_set1_epi16(0x0155));
+    high = _mm_madd_epi16(high, _mm_set1_epi32(0x00011c39));
+    __m128i low = _mm_shuffle_epi8(values, trailing);
+    __m128i overflow = _mm_or_si128(_mm_cmpgt_epi32(high, limit),
+      _mm_and_si128(_mm_cmpeq_epi32(high, limit), _mm_cmpgt_epi32(low, zero)));
+    if (_mm_movemask_epi8(overflow) != 0) {
+      break;
+    }
+
+    // high * 85 = high * 64 + high * 16 + high * 4 + high (no 32-bit multiply)
+    __m128i words = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(high, 6), _mm_slli_epi32(high, 4)),
+      _mm_add_epi32(_mm_slli_epi32(high, 2), high));
+    words = _mm_add_epi32(words, low);
+    _mm_storeu_si128((__m128i *)&_out[(i / 5) * 4], _mm_shuffle_epi8(words, pack));
+  }
+  return i;
+}
+
+} // namespace Ssse3
+#ifdef UTIL_DISPATCH
+#pragma GCC pop_options
+#endif
+#endif
+
+#if defined(UTIL_KERNELS_PORTABLE)
+namespace Portable {
+
+U64 decode_hex_bulk(const Byte *, U64, Byte *)
+{
+  return 0;
+}
+
+U64 encode_hex_bulk(const Byte *, U64, char *)
+{
+  return 0;
+}
+
+U64 decode_base64_bulk(const Byte *, U64, Byte *, const Base64Tables &)
+{
+  return 0;
+}
+
+U64 encode_base64_bulk(const Byte *, U64, char *, const Base64Tables &)
+{
+  return 0;
+}
+
+U64 decode_base32_bulk(const Byte *, U64, Byte *, const Byte *)
+{
+  return 0;
+}
+
+U64 encode_base32_bulk(const Byte *, U64, char *, const char *)
+{
+  return 0;
+}
+
+U64 decode_base85_bulk(const Byte *, U64, Byte *, const Byte *)
+{
+  return 0;
+}
+
+} // namespace Portable
+#endif
+
+} // anonymous namespace
+} // namespace Kernels
+} // namespace Util
+
+// Bind the kernels to the variants
+
+#ifdef UTIL_DISPATCH
+
+namespace {
+
+template<typename F>
+UTIL_RESOLVER
+F select(F _avx2, F _ssse3, F _portable)
+{
+  return Cpu::hasAvx2() ? _avx2 : (Cpu::hasSsse3() ? _ssse3 : _portable);
+}
+
+} // anonymous namespace
+
+extern "C" {
+
+UTIL_RESOLVER
+static decltype(&Kernels::Portable::decode_hex_bulk) util_resolve_decode_hex_bulk()
+{
+  return select(&Kernels::Avx2::decode_hex_bulk, &Kernels::Ssse3::decode_hex_bulk,
+    &Kernels::Portable::decode_hex_bulk);
+}
+
+UTIL_RESOLVER
+static decltype(&Kernels::Portable::encode_hex_bulk) util_resolve_encode_hex_bulk()
+{
+  return select(&Kernels::Avx2::encode_hex_bulk, &Kernels::Ssse3::encode_hex_bulk,
+    &Kernels::Portable::encode_hex_bulk);
+}
+
+UTIL_RESOLVER
+static decltype(&Kernels::Portable::decode_base64_bulk) util_resolve_decode_base64_bulk()
+{
+  return select(&Kernels::Avx2::decode_base64_bulk, &Kernels::Ssse3::decode_base64_bulk,
+    &Kernels::Portable::decode_base64_bulk);
+}
+
+UTIL_RESOLVER
+static decltype(&Kernels::Portable::encode_base64_bulk) util_resolve_encode_base64_bulk()
+{
+  return select(&Kernels::Avx2::encode_base64_bulk, &Kernels::Ssse3::encode_base64_bulk,
+    &Kernels::Portable::encode_base64_bulk);
+}
+
+UTIL_RESOLVER
+static decltype(&Kernels::Portable::decode_base32_bulk) util_resolve_decode_base32_bulk()
+{
+  return select(&Kernels::Avx2::decode_base32_bulk, &Kernels::Ssse3::decode_base32_bulk,
+    &Kernels::Portable::decode_base32_bulk);
+}
+
+UTIL_RESOLVER
+static decltype(&Kernels::Portable::encode_base32_bulk) util_resolve_encode_base32_bulk()
+{
+  return select(&Kernels::Avx2::encode_base32_bulk, &Kernels::Ssse3::encode_base32_bulk,
+    &Kernels::Portable::encode_base32_bulk);
+}
+
+UTIL_RESOLVER
+static decltype(&Kernels::Portable::decode_base85_bulk) util_resolve_decode_base85_bulk()
+{
+  return select(&Kernels::Avx2::decode_base85_bulk, &Kernels::Ssse3::decode_base85_bulk,
+    &Kernels::Portable::decode_base85_bulk);
+}
+
+} // extern "C"
+
+namespace Util {
+namespace Kernels {
+
+U64 decode_hex_bulk(const Byte *, U64, Byte *)
+  __attribute__((ifunc("util_resolve_decode_hex_bulk")));
+U64 encode_hex_bulk(const Byte *, U64, char *)
+  __attribute__((ifunc("util_resolve_encode_hex_bulk")));
+U64 decode_base64_bulk(const Byte *, U64, Byte *, const Base64Tables &)
+  __attribute__((ifunc("util_resolve_decode_base64_bulk")));
+U64 encode_base64_bulk(const Byte *, U64, char *, const Base64Tables &)
+  __attribute__((ifunc("util_resolve_encode_base64_bulk")));
+U64 decode_base32_bulk(const Byte *, U64, Byte *, const Byte *)
+  __attribute__((ifunc("util_resolve_decode_base32_bulk")));
+U64 encode_base32_bulk(const Byte *, U64, char *, const char *)
+  __attribute__((ifunc("util_resolve_encode_base32_bulk")));
+U64 decode_base85_bulk(const Byte *, U64, Byte *, const Byte *)
+  __attribute__((ifunc("util_resolve_decode_base85_bulk")));
+
+} // namespace Kernels
+} // namespace Util
+
+#else
+
+#if defined(UTIL_KERNELS_AVX2)
+namespace Selected = Kernels::Avx2;
+#elif defined(UTIL_KERNELS_SSSE3)
+namespace Selected = Kernels::Ssse3;
+#else
+namespace Selected = Kernels::Portable;
+#endif
+
+U64 Kernels::decode_hex_bulk(const Byte *_data, U64 _size, Byte *_out)
+{
+  return Selected::decode_hex_bulk(_data, _size, _out);
+}
+
+U64 Kernels::encode_hex_bulk(const Byte *_data, U64 _size, char *_out)
+{
+  return Selected::encode_hex_bulk(_data, _size, _out);
+}
+
+U64 Kernels::decode_base64_bulk(const Byte *_data, U64 _size, Byte *_out,
+  const Base64Tables &_tables)
+{
+  return Selected::decode_base64_bulk(_data, _size, _out, _tables);
+}
+
+U64 Kernels::encode_base64_bulk(const Byte *_data, U64 _size, char *_out,
+  const Base64Tables &_tables)
+{
+  return Selected::encode_base64_bulk(_data, _size, _out, _tables);
+}
+
+U64 Kernels::decode_base32_bulk(const Byte *_data, U64 _size, Byte *_out, const Byte *_values)
+{
+  return Selected::decode_base32_bulk(_data, _size, _out, _values);
+}
+
+U64 Kernels::encode_base32_bulk(const Byte *_data, U64 _size, char *_out, const char *_digits)
+{
+  return Selected::encode_base32_bulk(_data, _size, _out, _digits);
+}
+
+U64 Kernels::decode_base85_bulk(const Byte *_data, U64 _size, Byte *_out, const Byte *_values)
+{
+  return Selected::decode_base85_bulk(_data, _size, _out, _values);
+}
+
+#endif // UTIL_DISPATCH
@@ -0,0 +1,84 @@
+#ifndef UTIL_CODEC_KERNELS_H
+#define UTIL_CODEC_KERNELS_H
+
+#include "util/fixed_types.h"
+
+namespace Util {
+namespace Kernels {
+
+/*
+   Lookup tables and vectorized kernels shared by the codecs in
+   byte_encoders.h. The decode tables map a character to its digit value, or
+   to 0xff when the character is not a digit of the encoding (so validity can
+   be tested with a single '& 0x80' over several digits).
+
+   The bulk kernels decode whole vectors at a time and validate with SIMD
+   range checks. They stop before the first vector containing an invalid
+   character and return the number of input characters consumed, leaving the
+   remainder (and the exact error position) to the scalar codec. Without SIMD
+   support they consume nothing.
+*/
+
+extern const Byte kHexValues[256];
+extern const Byte kBase58Values[256];
+extern const Byte kBase62Values[256];
+extern const Byte kBase64Values[256];
+extern const Byte kBase64UrlValues[256];
+extern const Byte kBase32Values[256];
+extern const Byte kBase32CrockfordValues[256];
+extern const Byte kZ85Values[256];
+extern const Byte kAscii85Values[256];
+
+// Scalar and vector tables for one base 64 alphabet
+struct Base64Tables
+{
+  const char *digits;   // the 64 digits in value order
+  const Byte *values;   // decode table
+  Byte lutLo[16];       // vector validation by low nibble
+  Byte lutHi[16];       // vector validation by high nibble
+  S8 lutRoll[16];       // vector digit offsets by high nibble
+  Byte special;         // the digit using lutRoll[high nibble | 8]
+};
+
+extern const Base64Tables kBase64Standard;  // RFC 4648 section 4 ('+', '/')
+extern const Base64Tables kBase64Url;       // RFC 4648 section 5 ('-', '_')
+
+// Hex digits of either case; consumes a multiple of 32 (or 16) characters
+// and writes half as many bytes
+U64 decode_hex_bulk(const Byte *data, U64 size, Byte *out);
+
+// Encodes a multiple of 32 (or 16) bytes into twice as many upper case hex
+// digits
+U64 encode_hex_bulk(const Byte *data, U64 size, char *out);
+
+// Base 64 digits of the given alphabet (no padding or line breaks); consumes
+// a multiple of 32 (or 16) characters and writes three quarters as many
+// bytes. 'out' must have room for the decoded size of all 'size' characters.
+U64 decode_base64_bulk(const Byte *data, U64 size, Byte *out, const Base64Tables &tables);
+
+// Encodes a multiple of 24 (or 12) bytes into four thirds as many digits
+// of the given alphabet. May read up to 4 bytes past the consumed input,
+// but never beyond 'size'.
+U64 encode_base64_bulk(const Byte *data, U64 size, char *out, const Base64Tables &tables);
+
+// Base 32 digits with the given decode table, whose digits must all lie in
+// 0x20-0x7f; consumes a multiple of 32 (or 16) characters and writes five
+// eighths as many bytes. 'out' must have room for the decoded size of all
+// 'size' characters.
+U64 decode_base32_bulk(const Byte *data, U64 size, Byte *out, const Byte *values);
+
+// Encodes a multiple of 20 (or 10) bytes into eight fifths as many of the
+// given 32 digits. May read up to 6 bytes past the consumed input, but never
+// beyond 'size'.
+U64 encode_base32_bulk(const Byte *data, U64 size, char *out, const char *digits);
+
+// Base 85 digits with the given decode table, whose digits must all lie in
+// 0x20-0x7f; consumes a multiple of 30 (or 15) characters and writes four
+// fifths as many bytes. Groups whose value exceeds 32 bits are invalid. 'out'
+// must have room for the decoded size of all 'size' characters.
+U64 decode_base85_bulk(const Byte *data, U64 size, Byte *out, const Byte *values);
+
+} // namespace Kernels
+} // namespace Util
+
+#endif // UTIL_CODEC_KERNELS_H
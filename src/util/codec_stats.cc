@@ -0,0 +1,230 @@
+#include "util/codec_stats.h"
+#include <cstring>
+#ifdef UTIL_CODEC_STATS
+#include <algorithm>
+#include <atomic>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <utility>
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define UTIL_CODEC_PROBES
+#endif
+#endif
+#endif
+
+using namespace Util;
+
+#ifdef UTIL_CODEC_STATS
+namespace {
+
+// Codecs tracked per thread; calls to any further codecs are counted
+// together, as CodecStats::kOther
+const U32 kSlots = 32;
+
+// Counters for one codec, written only by the owning thread. A slot is
+// claimed by publishing 'callable' after 'decoder' is set.
+struct Slot
+{
+  std::atomic<const std::type_info *> callable;
+  bool decoder;
+  std::atomic<U64> calls;
+  std::atomic<U64> bytesIn;
+  std::atomic<U64> bytesOut;
+  std::atomic<U64> nanoseconds;
+  std::atomic<U64> latency[CodecStats::kBuckets];
+};
+
+struct ThreadCodecStats
+{
+  Slot slots[kSlots];
+  Slot others[2];  // encoders and decoders beyond the first kSlots codecs
+  std::atomic<U32> used;
+
+  ThreadCodecStats();
+  ~ThreadCodecStats();
+  Slot &slot(const std::type_info &callable, bool decoder);
+};
+
+// Entries are merged by name and direction
+typedef std::map<std::pair<std::string, bool>, CodecStats::Entry> Merged;
+
+struct GlobalCodecStats
+{
+  std::mutex mutex;
+  std::vector<ThreadCodecStats *> threads;
+  Merged retired;  // totals of exited threads
+};
+
+GlobalCodecStats &globalCodecStats()
+{
+  // Never destroyed so threads exiting after main() can still retire
+  static GlobalCodecStats *global = new GlobalCodecStats();
+  return *global;
+}
+
+template<typename T>
+inline void bump(std::atomic<T> &counter, T delta)
+{
+  counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+// "Util::encode_hex" for a lambda defined as Util::encode_hex
+std::string codecName(const std::type_info &_callable)
+{
+  const char *mangled = _callable.name();
+  if (mangled[0] == '*') {
+    mangled++;  // internal linkage
+  }
+  int status;
+  char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+  std::string name = (status == 0) ? demangled : mangled;
+  free((void *)demangled);
+  std::string::size_type lambda = name.find("::{lambda");
+  if (lambda != std::string::npos) {
+    name.resize(lambda);
+  }
+  return name;
+}
+
+void add(CodecStats::Entry &_entry, const Slot &_slot)
+{
+  _entry.calls += _slot.calls.load(std::memory_order_relaxed);
+  _entry.bytesIn += _slot.bytesIn.load(std::memory_order_relaxed);
+  _entry.bytesOut += _slot.bytesOut.load(std::memory_order_relaxed);
+  _entry.nanoseconds += _slot.nanoseconds.load(std::memory_order_relaxed);
+  for (U32 b = 0; b < CodecStats::kBuckets; b++) {
+    _entry.latency[b] += _slot.latency[b].load(std::memory_order_relaxed);
+  }
+}
+
+void accumulate(Merged &total, const ThreadCodecStats &t)
+{
+  U32 used = t.used.load(std::memory_order_acquire);
+  for (U32 i = 0; i < used; i++) {
+    const Slot &slot = t.slots[i];
+    const std::type_info *callable = slot.callable.load(std::memory_order_acquire);
+    add(total[std::make_pair(codecName(*callable), slot.decoder)], slot);
+  }
+  for (const Slot &slot : t.others) {
+    if (slot.calls.load(std::memory_order_relaxed) > 0) {
+      add(total[std::make_pair(std::string(CodecStats::kOther), slot.decoder)], slot);
+    }
+  }
+}
+
+void clear(Slot &_slot, bool _decoder)
+{
+  _slot.callable.store(nullptr, std::memory_order_relaxed);
+  _slot.decoder = _decoder;
+  _slot.calls.store(0, std::memory_order_relaxed);
+  _slot.bytesIn.store(0, std::memory_order_relaxed);
+  _slot.bytesOut.store(0, std::memory_order_relaxed);
+  _slot.nanoseconds.store(0, std::memory_order_relaxed);
+  for (std::atomic<U64> &bucket : _slot.latency) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+ThreadCodecStats::ThreadCodecStats()
+  : used(0)
+{
+  for (Slot &slot : slots) {
+    clear(slot, false);
+  }
+  clear(others[0], false);
+  clear(others[1], true);
+  GlobalCodecStats &global = globalCodecStats();
+  std::lock_guard<std::mutex> lock(global.mutex);
+  global.threads.push_back(this);
+}
+
+ThreadCodecStats::~ThreadCodecStats()
+{
+  GlobalCodecStats &global = globalCodecStats();
+  std::lock_guard<std::mutex> lock(global.mutex);
+  accumulate(global.retired, *this);
+  global.threads.erase(std::find(global.threads.begin(), global.threads.end(), this));
+}
+
+Slot &ThreadCodecStats::slot(const std::type_info &_callable, bool _decoder)
+{
+  U32 count = used.load(std::memory_order_relaxed);
+  for (U32 i = 0; i < count; i++) {
+    if (slots[i].callable.load(std::memory_order_relaxed) == &_callable) {
+      return slots[i];
+    }
+  }
+  if (count == kSlots) {
+    return others[_decoder ? 1 : 0];
+  }
+  Slot &slot = slots[count];
+  slot.decoder = _decoder;
+  slot.callable.store(&_callable, std::memory_order_release);
+  used.store(count + 1, std::memory_order_release);
+  return slot;
+}
+
+ThreadCodecStats &threadCodecStats()
+{
+  static thread_local ThreadCodecStats stats;
+  return stats;
+}
+
+} // anonymous namespace
+
+void CodecCall::finish(U64 _bytesOut)
+{
+  U64 ns = (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start_).count();
+  Slot &slot = threadCodecStats().slot(callable_, decoder_);
+  bump(slot.calls, (U64)1);
+  bump(slot.bytesIn, bytesIn_);
+  bump(slot.bytesOut, _bytesOut);
+  bump(slot.nanoseconds, ns);
+  bump(slot.latency[CodecStats::bucketForNanoseconds(ns)], (U64)1);
+#ifdef UTIL_CODEC_PROBES
+  if (decoder_) {
+    DTRACE_PROBE4(util_blob, decode, callable_.name(), bytesIn_, _bytesOut, ns);
+  }
+  else {
+    DTRACE_PROBE4(util_blob, encode, callable_.name(), bytesIn_, _bytesOut, ns);
+  }
+#endif
+}
+#endif // UTIL_CODEC_STATS
+
+const char *const CodecStats::kOther = "(other)";
+
+CodecStats CodecStats::snapshot()
+{
+  CodecStats total;
+  total.enabled = false;
+#ifdef UTIL_CODEC_STATS
+  Merged merged;
+  {
+    GlobalCodecStats &global = globalCodecStats();
+    std::lock_guard<std::mutex> lock(global.mutex);
+    merged = global.retired;
+    for (const ThreadCodecStats *t : global.threads) {
+      accumulate(merged, *t);
+    }
+  }
+  total.enabled = true;
+  for (auto &codec : merged) {
+    codec.second.name = codec.first.first;
+    codec.second.decoder = codec.first.second;
+    total.codecs.push_back(codec.second);
+  }
+#endif
+  return total;
+}
+
+U32 CodecStats::bucketForNanoseconds(U64 _nanoseconds)
+{
+  U32 bucket = (_nanoseconds == 0) ? 0 : (U32)(64 - __builtin_clzll(_nanoseconds));
+  return (bucket < kBuckets) ? bucket : kBuckets - 1;
+}
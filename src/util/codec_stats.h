@@ -0,0 +1,86 @@
+#ifndef UTIL_CODEC_STATS_H
+#define UTIL_CODEC_STATS_H
+
+#include "util/fixed_types.h"
+#include <string>
+#include <vector>
+#ifdef UTIL_CODEC_STATS
+#include <chrono>
+#include <typeinfo>
+#endif
+
+namespace Util {
+
+/*
+   Process-wide call statistics for the run-time codecs, i.e. the Encoders
+   passed to Blob::data() and BlobView::data() and the Decoders passed to the
+   decoding constructors.
+
+   Statistics are only collected when compiled with UTIL_CODEC_STATS defined;
+   otherwise the calls are not wrapped at all and every snapshot is empty
+   with 'enabled' set to false. As with ContainerStats, counters are kept per
+   thread and merged when a snapshot is taken.
+
+   Each codec is identified by the type of the callable, so the lambdas in
+   byte_encoders.h appear as e.g. "Util::encode_hex". Plain functions of the
+   Encoder or Decoder signature share one entry. Each thread tracks up to 32
+   codecs; calls to any further codecs are counted under kOther.
+
+   Where <sys/sdt.h> is available every call also fires a static tracepoint,
+   'util_blob:encode' or 'util_blob:decode', for perf or bpftrace to attach
+   to. Its arguments are the codec's mangled type name, bytes in, bytes out
+   and nanoseconds.
+*/
+struct CodecStats
+{
+  // Latencies are counted in log2 nanosecond buckets: bucket 0 holds calls
+  // under 1 ns and bucket i holds [2^(i-1), 2^i) ns; the last is unbounded.
+  static const U32 kBuckets = 40;
+
+  // The name of the entries counting codecs beyond those tracked per thread
+  static const char *const kOther;
+
+  struct Entry
+  {
+    std::string name;
+    bool decoder;
+    U64 calls;
+    U64 bytesIn;
+    U64 bytesOut;
+    U64 nanoseconds;
+    U64 latency[kBuckets];
+  };
+
+  bool enabled;
+  std::vector<Entry> codecs;  // ordered by name
+
+  // A snapshot of the statistics of all codec calls in the process
+  static CodecStats snapshot();
+  static U32 bucketForNanoseconds(U64 nanoseconds);
+};
+
+#ifdef UTIL_CODEC_STATS
+// Times one codec call and records it when finished
+class CodecCall
+{
+ public:
+  CodecCall(const std::type_info &callable, bool decoder, U64 bytesIn);
+  void finish(U64 bytesOut);
+
+ private:
+  const std::type_info &callable_;
+  bool decoder_;
+  U64 bytesIn_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+inline CodecCall::CodecCall(const std::type_info &_callable, bool _decoder, U64 _bytesIn)
+  : callable_(_callable), decoder_(_decoder), bytesIn_(_bytesIn),
+  start_(std::chrono::steady_clock::now())
+{
+}
+#endif
+
+} // namespace Util
+
+#endif // UTIL_CODEC_STATS_H
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "util/codec_stats.h"
+#include "util/byte_encoders.h"
+#include "util/blob.h"
+#include <string>
+#include <thread>
+
+using namespace Util;
+using std::string;
+
+TEST(CodecStatsTest, Buckets) {
+  EXPECT_EQ(0U, CodecStats::bucketForNanoseconds(0));
+  EXPECT_EQ(1U, CodecStats::bucketForNanoseconds(1));
+  EXPECT_EQ(2U, CodecStats::bucketForNanoseconds(3));
+  EXPECT_EQ(11U, CodecStats::bucketForNanoseconds(1024));
+  EXPECT_EQ(CodecStats::kBuckets - 1, CodecStats::bucketForNanoseconds(~0UL));
+}
+
+#ifdef UTIL_CODEC_STATS
+namespace {
+
+CodecStats::Entry find(const CodecStats &stats, const string &name)
+{
+  for (const CodecStats::Entry &entry : stats.codecs) {
+    if (entry.name == name) {
+      return entry;
+    }
+  }
+  CodecStats::Entry none = CodecStats::Entry();
+  none.name = name;
+  return none;
+}
+
+// Codecs of distinct types, each called once, from Numbered<N> down
+template<U32 N> struct Numbered
+{
+  static void call()
+  {
+    CodecCall call(typeid(Numbered<N>), false, 1);
+    call.finish(2);
+    Numbered<N - 1>::call();
+  }
+};
+
+template<> struct Numbered<0>
+{
+  static void call() {}
+};
+
+} // anonymous namespace
+
+TEST(CodecStatsTest, Calls) {
+  CodecStats before = CodecStats::snapshot();
+  EXPECT_TRUE(before.enabled);
+  Blob blob(string(100, 'x'));
+  string hex = *blob.data(encode_hex);
+  Blob decoded(hex, decode_hex);
+  hex = *blob.view().data(encode_hex);
+
+  // Calls on other threads are merged, including after the thread exits
+  std::thread t([&blob] { blob.data(encode_hex); });
+  t.join();
+
+  CodecStats after = CodecStats::snapshot();
+  CodecStats::Entry encodes = find(after, "Util::encode_hex");
+  CodecStats::Entry encodesBefore = find(before, "Util::encode_hex");
+  EXPECT_FALSE(encodes.decoder);
+  EXPECT_EQ(encodesBefore.calls + 3, encodes.calls);
+  EXPECT_EQ(encodesBefore.bytesIn + 300, encodes.bytesIn);
+  EXPECT_EQ(encodesBefore.bytesOut + 600, encodes.bytesOut);
+  U64 counted = 0;
+  for (U64 calls : encodes.latency) {
+    counted += calls;
+  }
+  EXPECT_EQ(encodes.calls, counted);
+
+  CodecStats::Entry decodes = find(after, "Util::decode_hex");
+  EXPECT_TRUE(decodes.decoder);
+  EXPECT_EQ(find(before, "Util::decode_hex").calls + 1, decodes.calls);
+  EXPECT_EQ(find(before, "Util::decode_hex").bytesOut + 100, decodes.bytesOut);
+}
+
+TEST(CodecStatsTest, Other) {
+  // A new thread tracks 32 codecs; the rest are counted together
+  CodecStats before = CodecStats::snapshot();
+  std::thread t([] { Numbered<40>::call(); });
+  t.join();
+  CodecStats after = CodecStats::snapshot();
+  CodecStats::Entry other = find(after, CodecStats::kOther);
+  EXPECT_FALSE(other.decoder);
+  EXPECT_EQ(find(before, CodecStats::kOther).calls + 8, other.calls);
+  EXPECT_EQ(find(before, CodecStats::kOther).bytesOut + 16, other.bytesOut);
+  U32 named = 0;
+  for (const CodecStats::Entry &entry : after.codecs) {
+    if (entry.name.find("Numbered<") != string::npos) {
+      EXPECT_EQ(1UL, entry.calls);
+      named++;
+    }
+  }
+  EXPECT_EQ(32U, named);
+}
+#else
+TEST(CodecStatsTest, Disabled) {
+  Blob(string("abc")).data(encode_hex);
+  CodecStats stats = CodecStats::snapshot();
+  EXPECT_FALSE(stats.enabled);
+  EXPECT_TRUE(stats.codecs.empty());
+}
+#endif
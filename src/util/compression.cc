@@ -0,0 +1,296 @@
+#include "util/compression.h"
+#include <cstring>
+
+using namespace Util;
+
+namespace {
+
+const U64 kHeaderSize = 8;      // the decompressed size
+const U64 kMinMatch = 4;        // matches are encoded as their length less this
+const U64 kLastLiterals = 5;    // the last bytes of the input are always literals
+const U64 kMatchLimit = 12;     // no match starts within this many bytes of the end
+const U64 kMaxOffset = 65535;
+const U32 kHashLog = 12;        // 4096 entries, which stay in the L1 cache
+const U32 kSkipTrigger = 6;     // search faster after 2^6 misses in a row
+
+inline U32 load32(const Byte *_p)
+{
+  U32 value;
+  memcpy((void *)&value, (const void *)_p, sizeof(value));
+  return value;
+}
+
+inline U64 load64(const Byte *_p)
+{
+  U64 value;
+  memcpy((void *)&value, (const void *)_p, sizeof(value));
+  return value;
+}
+
+// A hash of the five bytes at 'p', so that candidates usually match beyond
+// the minimum length
+inline U32 hash(const Byte *_p)
+{
+  return (U32)(((load64(_p) << 24) * 889523592379UL) >> (64 - kHashLog));
+}
+
+// The number of equal bytes at 'a' and 'b', stopping at 'limit' (in 'a').
+// Whole words are compared first; the first differing byte of a little-endian
+// word is its lowest set bit.
+inline U64 commonLength(const Byte *_a, const Byte *_b, const Byte *_limit)
+{
+  const Byte *start = _a;
+  while (_a + 8 <= _limit) {
+    U64 difference = load64(_a) ^ load64(_b);
+    if (difference != 0) {
+      return (U64)(_a - start) + (U64)(__builtin_ctzll(difference) >> 3);
+    }
+    _a += 8;
+    _b += 8;
+  }
+  while ((_a < _limit) && (*_a == *_b)) {
+    _a++;
+    _b++;
+  }
+  return (U64)(_a - start);
+}
+
+// Lengths of 15 or more continue in bytes of 255 and a final byte below it
+Byte *writeLength(Byte *_out, U64 _length)
+{
+  for (; _length >= 255; _length -= 255) {
+    *_out++ = 255;
+  }
+  *_out++ = (Byte)_length;
+  return _out;
+}
+
+inline bool readLength(const Byte *&_in, const Byte *_end, U64 &_length)
+{
+  Byte b;
+  do {
+    if (_in >= _end) {
+      return false;
+    }
+    b = *_in++;
+    _length += b;
+  } while (b == 255);
+  return true;
+}
+
+// A token (literal and match length nibbles), the literals, and the match
+// offset and length. The final sequence has literals only (no match).
+Byte *writeSequence(Byte *_out, const Byte *_literals, U64 _literalLength, U64 _offset,
+  U64 _matchLength)
+{
+  Byte *token = _out++;
+  Byte value;
+  if (_literalLength >= 15) {
+    value = 0xf0;
+    _out = writeLength(_out, _literalLength - 15);
+  }
+  else {
+    value = (Byte)(_literalLength << 4);
+  }
+  memcpy((void *)_out, (const void *)_literals, _literalLength);
+  _out += _literalLength;
+  if (_matchLength != 0) {
+    *_out++ = (Byte)(_offset & 0xff);
+    *_out++ = (Byte)(_offset >> 8);
+    U64 length = _matchLength - kMinMatch;
+    if (length >= 15) {
+      value |= 0x0f;
+      _out = writeLength(_out, length - 15);
+    }
+    else {
+      value |= (Byte)length;
+    }
+  }
+  *token = value;
+  return _out;
+}
+
+// Copy a match which may overlap its destination. There is room for the copy
+// to be rounded up to whole words; bytes past 'length' are overwritten later.
+inline void copyMatch(Byte *_out, U64 _offset, U64 _length, U64 _room)
+{
+  const Byte *match = _out - _offset;
+  if ((_offset >= 16) && (_room >= ((_length + 15) & ~15UL))) {
+    for (U64 i = 0; i < _length; i += 16) {
+      memcpy((void *)&_out[i], (const void *)&match[i], 16);
+    }
+  }
+  else if (_room >= ((_length + 7) & ~7UL)) {
+    U64 i = 0;
+    U64 distance = _offset;
+    if (_offset < 8) {
+      // Repeat the pattern bytewise for one word, after which a multiple of
+      // its period is at least a word behind
+      for (; i < 8; i++) {
+        _out[i] = match[i];
+      }
+      distance = _offset * ((7 + _offset) / _offset);
+    }
+    for (; i < _length; i += 8) {
+      memcpy((void *)&_out[i], (const void *)&_out[i - distance], 8);
+    }
+  }
+  else {
+    for (U64 i = 0; i < _length; i++) {
+      _out[i] = match[i];
+    }
+  }
+}
+
+} // anonymous namespace
+
+
+// Lz
+
+U64 Lz::compressedSize(U64 _size)
+{
+  return kHeaderSize + _size + (_size / 255) + 16;
+}
+
+// Greedy parsing with one hash table probe per position, skipping ahead
+// faster through data which does not compress
+U64 Lz::compress(const Byte *_data, U64 _size, Byte *_out)
+{
+  for (U32 i = 0; i < kHeaderSize; i++) {
+    _out[i] = (Byte)(_size >> (8 * i));
+  }
+  Byte *op = &_out[kHeaderSize];
+  const Byte *anchor = _data;
+  const Byte *end = _data + _size;
+
+  if (_size > kMatchLimit) {
+    U64 table[1U << kHashLog] = {};  // positions, which start out as 0
+    const Byte *matchEnd = end - kLastLiterals;
+    const Byte *searchEnd = end - kMatchLimit;
+    const Byte *ip = _data + 1;
+    while (ip < searchEnd) {
+      const Byte *match;
+      U64 misses = 1U << kSkipTrigger;
+      for (;;) {
+        U32 h = hash(ip);
+        match = &_data[table[h]];
+        table[h] = (U64)(ip - _data);
+        if (((U64)(ip - match) <= kMaxOffset) && (load32(match) == load32(ip))) {
+          break;
+        }
+        ip += misses++ >> kSkipTrigger;
+        if (ip >= searchEnd) {
+          break;
+        }
+      }
+      if (ip >= searchEnd) {
+        break;
+      }
+
+      // Extend the match backwards over pending literals, then forwards
+      while ((ip > anchor) && (match > _data) && (ip[-1] == match[-1])) {
+        ip--;
+        match--;
+      }
+      U64 length = kMinMatch + commonLength(ip + kMinMatch, match + kMinMatch, matchEnd);
+      op = writeSequence(op, anchor, (U64)(ip - anchor), (U64)(ip - match), length);
+      ip += length;
+      anchor = ip;
+      if (ip < searchEnd) {
+        table[hash(ip - 2)] = (U64)(ip - 2 - _data);
+      }
+    }
+  }
+  op = writeSequence(op, anchor, (U64)(end - anchor), 0, 0);
+  return (U64)(op - _out);
+}
+
+// Each compressed byte expands to at most 255 bytes (a length byte of a
+// match), so larger sizes are not valid and are never allocated
+U64 Lz::decompressedSize(const Byte *_data, U64 _size)
+{
+  if (_size <= kHeaderSize) {
+    return 0;
+  }
+  U64 size = 0;
+  for (U32 i = 0; i < kHeaderSize; i++) {
+    size |= (U64)_data[i] << (8 * i);
+  }
+  return (size / 255 <= _size) ? size : 0;
+}
+
+DecodeStatus Lz::decompress(const Byte *_data, U64 _size, Byte *_out)
+{
+  U64 size = decompressedSize(_data, _size);
+  if ((size == 0) && ((_size <= kHeaderSize) || (load64(_data) != 0))) {
+    return DecodeStatus::failure(0);
+  }
+  const Byte *ip = &_data[kHeaderSize];
+  const Byte *end = _data + _size;
+  Byte *op = _out;
+  Byte *outEnd = _out + size;
+
+  for (;;) {
+    // Streams end with literals, never right after a match
+    if (ip >= end) {
+      return DecodeStatus::failure(_size);
+    }
+    const Byte *sequence = ip;
+    U64 token = *ip++;
+    U64 length = token >> 4;
+
+    // The common case of a short literal run and a short match, far from
+    // the ends: copy the literals as one vector and the match as three words
+    if ((length < 15) && ((token & 0x0f) < 15) && (end - ip >= 32) && (outEnd - op >= 48)) {
+      memcpy((void *)op, (const void *)ip, 16);
+      op += length;
+      ip += length;
+      U64 offset = (U64)ip[0] | ((U64)ip[1] << 8);
+      if ((offset >= 8) && (offset <= (U64)(op - _out))) {
+        const Byte *match = op - offset;
+        memcpy((void *)op, (const void *)match, 8);
+        memcpy((void *)&op[8], (const void *)&match[8], 8);
+        memcpy((void *)&op[16], (const void *)&match[16], 8);
+        op += (token & 0x0f) + kMinMatch;
+        ip += 2;
+        continue;
+      }
+    }
+    else {
+      // Literals
+      if ((length == 15) && !readLength(ip, end, length)) {
+        return DecodeStatus::failure((U64)(sequence - _data));
+      }
+      if ((length > (U64)(end - ip)) || (length > (U64)(outEnd - op))) {
+        return DecodeStatus::failure((U64)(sequence - _data));
+      }
+      memcpy((void *)op, (const void *)ip, length);
+      op += length;
+      ip += length;
+      if (ip == end) {
+        break;
+      }
+    }
+
+    // Match
+    if (end - ip < 2) {
+      return DecodeStatus::failure((U64)(sequence - _data));
+    }
+    U64 offset = (U64)ip[0] | ((U64)ip[1] << 8);
+    ip += 2;
+    length = token & 0x0f;
+    if ((length == 15) && !readLength(ip, end, length)) {
+      return DecodeStatus::failure((U64)(sequence - _data));
+    }
+    length += kMinMatch;
+    if ((offset == 0) || (offset > (U64)(op - _out)) || (length > (U64)(outEnd - op))) {
+      return DecodeStatus::failure((U64)(sequence - _data));
+    }
+    copyMatch(op, offset, length, (U64)(outEnd - op));
+    op += length;
+  }
+  if (op != outEnd) {
+    return DecodeStatus::failure(_size);
+  }
+  return DecodeStatus::success(size);
+}
@@ -0,0 +1,106 @@
+#ifndef UTIL_COMPRESSION_H
+#define UTIL_COMPRESSION_H
+
+#include "util/blob.h"
+#include "util/codec.h"
+#include "util/fixed_types.h"
+#include "util/make_unique.h"
+#include <memory>
+#include <string>
+
+namespace Util {
+
+/*
+   Compressors shrink binary data and restore it. Like the codecs in
+   byte_encoders.h, a compressor is a class with only static members:
+
+     struct Compressor
+     {
+       // Upper bound on the compressed size of 'size' bytes
+       static U64 compressedSize(U64 size);
+
+       // Compress into 'out' (compressedSize(size) bytes); returns bytes written
+       static U64 compress(const Byte *data, U64 size, Byte *out);
+
+       // The exact decompressed size, read from the compressed data (0 when
+       // the data is not valid)
+       static U64 decompressedSize(const Byte *data, U64 size);
+
+       // Validate and decompress into 'out' (decompressedSize() bytes)
+       static DecodeStatus decompress(const Byte *data, U64 size, Byte *out);
+     };
+
+   compress<C>() and decompress<C>() apply a compressor to a Blob, and the
+   lambdas 'compress_*' and 'decompress_*' adapt each one to the run-time
+   Blob::Decoder interface (so 'Blob(data, size, compress_lz)' compresses).
+   Decompression writes directly into a MutableBlob of the exact size. The
+   result inherits the scrub and compare types of its input.
+*/
+
+/*
+   Lz is a byte-oriented LZ77 compressor using the LZ4 block format, tuned for
+   decompression speed rather than ratio: there is no entropy coding, and each
+   sequence is a literal run and a match copy whose lengths fit in one token
+   byte in the common case.
+
+   The compressed data is the decompressed size (64-bit little-endian)
+   followed by an LZ4 block. Decompression checks every length and offset
+   against the input and output bounds, so corrupt data is reported rather
+   than read or written out of bounds.
+*/
+struct Lz
+{
+  static U64 compressedSize(U64 size);
+  static U64 compress(const Byte *data, U64 size, Byte *out);
+  static U64 decompressedSize(const Byte *data, U64 size);
+  static DecodeStatus decompress(const Byte *data, U64 size, Byte *out);
+};
+
+
+template<typename Compressor>
+Blob compress(const BlobView &_blob)
+{
+  MutableBlob output(Compressor::compressedSize(_blob.size()), _blob.scrubType(),
+    _blob.compareType());
+  return Blob(output, Compressor::compress(_blob.data(), _blob.size(), output.data()));
+}
+
+// On success 'out' holds the decompressed data; otherwise it is empty and
+// the status holds the offset of the sequence which is not valid
+template<typename Compressor>
+DecodeStatus tryDecompress(const BlobView &_blob, Blob &_out)
+{
+  MutableBlob output(Compressor::decompressedSize(_blob.data(), _blob.size()), _blob.scrubType(),
+    _blob.compareType());
+  DecodeStatus status = Compressor::decompress(_blob.data(), _blob.size(), output.data());
+  if (status.ok()) {
+    _out = std::move(output);
+  }
+  else {
+    _out = Blob(0, _blob.scrubType(), _blob.compareType());
+  }
+  return status;
+}
+
+// Data which is not valid results in an empty Blob
+template<typename Compressor>
+Blob decompress(const BlobView &_blob)
+{
+  Blob output;
+  tryDecompress<Compressor>(_blob, output);
+  return output;
+}
+
+const auto compress_lz = [] (const Byte *data, U64 size)
+{
+  return Util::make_unique<Blob>(compress<Lz>(BlobView(data, size)));
+};
+
+const auto decompress_lz = [] (const Byte *data, U64 size)
+{
+  return Util::make_unique<Blob>(decompress<Lz>(BlobView(data, size)));
+};
+
+} // namespace Util
+
+#endif // UTIL_COMPRESSION_H
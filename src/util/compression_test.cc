@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+#include "util/compression.h"
+#include "util/blob.h"
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+// Text with the repetition typical of logs and markup
+string repetitiveText(U64 size)
+{
+  static const char *words[] = {"blob", "container", "scrub", "view", "<tag>", "</tag>",
+    "\"key\": ", "12345", ", ", "\n"};
+  std::default_random_engine gen(42);
+  std::uniform_int_distribution<U32> dist(0, 9);
+  string text;
+  while (text.size() < size) {
+    text += words[dist(gen)];
+  }
+  text.resize(size);
+  return text;
+}
+
+string randomBytes(U64 size)
+{
+  std::default_random_engine gen(7);
+  std::uniform_int_distribution<U32> dist(0, 255);
+  string bytes(size, '\0');
+  for (U64 i = 0; i < size; i++) {
+    bytes[i] = (char)dist(gen);
+  }
+  return bytes;
+}
+
+void expectRoundTrip(const string &data)
+{
+  Blob original(data);
+  Blob compressed = compress<Lz>(original);
+  EXPECT_LE(compressed.size(), Lz::compressedSize(data.size()));
+  EXPECT_EQ(data.size(), Lz::decompressedSize(compressed.data(), compressed.size()));
+  Blob restored;
+  ASSERT_TRUE(tryDecompress<Lz>(compressed, restored).ok()) << "size " << data.size();
+  EXPECT_EQ(original, restored) << "size " << data.size();
+}
+
+} // anonymous namespace
+
+
+TEST(CompressionTest, RoundTrip) {
+  expectRoundTrip("");
+  expectRoundTrip("a");
+  expectRoundTrip("abcdefghijkl");
+  expectRoundTrip("abcdefghijklm");
+  for (U64 size : {13UL, 100UL, 4096UL, 65536UL, 70000UL, 1000000UL}) {
+    expectRoundTrip(repetitiveText(size));
+    expectRoundTrip(randomBytes(size));
+  }
+
+  // Runs of every short period exercise overlapping match copies
+  for (U64 period = 1; period <= 20; period++) {
+    string run;
+    for (U64 i = 0; i < 1000; i++) {
+      run += (char)('a' + (i % period));
+    }
+    expectRoundTrip(run);
+    expectRoundTrip("prefix" + run + "suffix");
+  }
+
+  // Matches and literals longer than the 255-byte length steps
+  expectRoundTrip(string(100000, 'x'));
+  expectRoundTrip(randomBytes(600) + string(600, 'y') + randomBytes(600));
+}
+
+TEST(CompressionTest, Ratio) {
+  string text = repetitiveText(1 << 20);
+  Blob compressed = compress<Lz>(Blob(text));
+  EXPECT_LT(compressed.size(), text.size() / 2);
+
+  Blob zeros = compress<Lz>(Blob(string(1 << 20, '\0')));
+  EXPECT_LT(zeros.size(), 8192U);
+}
+
+TEST(CompressionTest, Transforms) {
+  string text = repetitiveText(10000);
+  Blob compressed((const Byte *)text.data(), text.size(), compress_lz);
+  Blob restored(compressed.data(), compressed.size(), decompress_lz);
+  EXPECT_EQ(Blob(text), restored);
+
+  // Scrub and compare types carry through
+  Blob secret((const Byte *)text.data(), text.size(), Blob::ScrubType::ZEROS,
+    Blob::CompareType::CONST);
+  Blob packed = compress<Lz>(secret);
+  EXPECT_EQ(Blob::ScrubType::ZEROS, packed.scrubType());
+  Blob unpacked = decompress<Lz>(packed);
+  EXPECT_EQ(Blob::ScrubType::ZEROS, unpacked.scrubType());
+  EXPECT_EQ(Blob::CompareType::CONST, unpacked.compareType());
+  EXPECT_EQ(secret, unpacked);
+}
+
+TEST(CompressionTest, Invalid) {
+  string text = repetitiveText(5000);
+  Blob compressed = compress<Lz>(Blob(text));
+  Blob out;
+
+  // Too short for the header
+  EXPECT_FALSE(tryDecompress<Lz>(Blob(compressed, 8), out).ok());
+  EXPECT_EQ(0U, out.size());
+
+  // An implausible size is rejected before allocating
+  MutableBlob huge(compressed);
+  huge[7] = 0x7f;
+  EXPECT_EQ(0U, Lz::decompressedSize(huge.data(), huge.size()));
+  EXPECT_FALSE(tryDecompress<Lz>(huge, out).ok());
+
+  // Truncation at every point fails cleanly
+  for (U64 size = 9; size < compressed.size(); size += 7) {
+    EXPECT_FALSE(tryDecompress<Lz>(Blob(compressed, size), out).ok()) << size;
+  }
+
+  // Corruption never reads or writes out of bounds (run under a sanitizer to
+  // check), and is usually detected
+  std::default_random_engine gen(3);
+  std::uniform_int_distribution<U64> position(8, compressed.size() - 1);
+  std::uniform_int_distribution<U32> value(0, 255);
+  for (int i = 0; i < 1000; i++) {
+    MutableBlob corrupt(compressed);
+    corrupt[position(gen)] = (Byte)value(gen);
+    tryDecompress<Lz>(corrupt, out);
+  }
+
+  // A match before the start of the output
+  const Byte bad[] = {1, 0, 0, 0, 0, 0, 0, 0, 0x00, 0x01, 0x00};
+  DecodeStatus status = tryDecompress<Lz>(BlobView(bad, sizeof(bad)), out);
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(8U, status.errorOffset);
+
+  // A stream ending right after a match, with or without output left to
+  // fill, where the next token would be read past the end of the input
+  for (Byte size : {8, 24}) {
+    const Byte cut[] = {size, 0, 0, 0, 0, 0, 0, 0, 0x40, 'a', 'b', 'c', 'd', 4, 0};
+    std::unique_ptr<Byte[]> data(new Byte[sizeof(cut)]);   // exactly, for sanitizers
+    memcpy((void *)data.get(), (const void *)cut, sizeof(cut));
+    std::vector<Byte> unpacked(size);
+    status = Lz::decompress(data.get(), sizeof(cut), unpacked.data());
+    EXPECT_FALSE(status.ok());
+    EXPECT_EQ(sizeof(cut), status.errorOffset);
+  }
+}
@@ -1,27 +1,428 @@
 #include "util/container.h"
+#include <cstring>
+#if defined(UTIL_CONTAINER_STATS) || defined(UTIL_CONTAINER_PINNING)
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#endif
 
 using namespace Util;
 
+namespace {
+
+const U64 kChecksumKnown = 1UL << 32;
+
+} // anonymous namespace
+
+#ifdef UTIL_CONTAINER_PINNING
+const bool Container::kPinning = true;
+#else
+const bool Container::kPinning = false;
+#endif
+
+struct Container::CachedEncoding
+{
+  const std::type_info *codec;
+  Encoding text;
+  CachedEncoding *next;
+};
+
+#ifdef UTIL_CONTAINER_STATS
+namespace {
+
+// Counters owned by one thread. Only the owner writes them, so updates are a
+// relaxed load and store (no locked read-modify-write); snapshots read them
+// from other threads.
+struct ThreadStats
+{
+  std::atomic<S64> liveContainers;
+  std::atomic<S64> liveBytes;
+  std::atomic<U64> allocations[ContainerStats::kBuckets];
+  std::atomic<U64> scrubCalls;
+  std::atomic<U64> scrubbedBytes;
+  std::atomic<U64> scrubNanoseconds;
+  S64 unflushedBytes;  // owner only
+
+  ThreadStats();
+  ~ThreadStats();
+};
+
+// Aggregation state shared by all threads
+struct GlobalStats
+{
+  std::mutex mutex;
+  std::vector<ThreadStats *> threads;
+  ContainerStats retired;            // totals of exited threads
+  std::atomic<S64> flushedBytes{0};  // sum of all flushed per-thread deltas
+  std::atomic<S64> peakBytes{0};
+};
+
+GlobalStats &globalStats()
+{
+  // Never destroyed so threads exiting after main() can still retire
+  static GlobalStats *global = new GlobalStats();
+  return *global;
+}
+
+template<typename T>
+inline void bump(std::atomic<T> &counter, T delta)
+{
+  counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void accumulate(ContainerStats &total, const ThreadStats &t)
+{
+  total.liveContainers += t.liveContainers.load(std::memory_order_relaxed);
+  total.liveBytes += t.liveBytes.load(std::memory_order_relaxed);
+  for (U32 i = 0; i < ContainerStats::kBuckets; i++) {
+    total.allocations[i] += t.allocations[i].load(std::memory_order_relaxed);
+  }
+  total.scrubCalls += t.scrubCalls.load(std::memory_order_relaxed);
+  total.scrubbedBytes += t.scrubbedBytes.load(std::memory_order_relaxed);
+  total.scrubNanoseconds += t.scrubNanoseconds.load(std::memory_order_relaxed);
+}
+
+ThreadStats::ThreadStats()
+  : liveContainers(0), liveBytes(0), scrubCalls(0), scrubbedBytes(0),
+  scrubNanoseconds(0), unflushedBytes(0)
+{
+  for (U32 i = 0; i < ContainerStats::kBuckets; i++) {
+    allocations[i].store(0, std::memory_order_relaxed);
+  }
+  GlobalStats &global = globalStats();
+  std::lock_guard<std::mutex> lock(global.mutex);
+  global.threads.push_back(this);
+}
+
+ThreadStats::~ThreadStats()
+{
+  GlobalStats &global = globalStats();
+  global.flushedBytes.fetch_add(unflushedBytes, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(global.mutex);
+  accumulate(global.retired, *this);
+  global.threads.erase(std::find(global.threads.begin(), global.threads.end(), this));
+}
+
+ThreadStats &threadStats()
+{
+  static thread_local ThreadStats stats;
+  return stats;
+}
+
+// Add a (possibly negative) change in live bytes for the calling thread and
+// update the process-wide peak once enough change has accumulated
+inline void addLiveBytes(ThreadStats &t, S64 delta)
+{
+  bump(t.liveBytes, delta);
+  t.unflushedBytes += delta;
+  if ((t.unflushedBytes >= ContainerStats::kPeakBatch) ||
+      (t.unflushedBytes <= -ContainerStats::kPeakBatch)) {
+    GlobalStats &global = globalStats();
+    S64 total = global.flushedBytes.fetch_add(t.unflushedBytes, std::memory_order_relaxed) +
+      t.unflushedBytes;
+    t.unflushedBytes = 0;
+    S64 peak = global.peakBytes.load(std::memory_order_relaxed);
+    while ((total > peak) &&
+      !global.peakBytes.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+      // 'peak' was reloaded; retry
+    }
+  }
+}
+
+} // anonymous namespace
+#endif // UTIL_CONTAINER_STATS
+
+#ifdef UTIL_CONTAINER_PINNING
+namespace {
+
+// Live containers for pinning(), in lists striped by address so that
+// threads rarely share a lock
+struct RegistryShard
+{
+  std::mutex mutex;
+  Container *head;
+  char padding[64];
+
+  RegistryShard() : head(nullptr) {}
+};
+
+const U32 kRegistryShards = 64;
+
+RegistryShard *registryShards()
+{
+  // Never destroyed, like the global statistics
+  static RegistryShard *shards = new RegistryShard[kRegistryShards];
+  return shards;
+}
+
+RegistryShard &registryShard(const Container *container)
+{
+  return registryShards()[((U64)container >> 6) % kRegistryShards];
+}
+
+} // anonymous namespace
+#endif // UTIL_CONTAINER_PINNING
+
 Container::Container(U64 _size, ScrubType _scrubber)
-  : data_(new Byte[_size]), size_(_size), scrubber_(_scrubber)
+  : data_(new Byte[_size]), size_(_size), scrubber_(_scrubber), writable_(false), checksum_(0),
+  encodings_(nullptr), referencedBytes_(0), blobs_(0), prev_(nullptr), next_(nullptr)
 {
-  // empty
+  enroll();
+#ifdef UTIL_CONTAINER_STATS
+  ThreadStats &t = threadStats();
+  bump(t.liveContainers, (S64)1);
+  bump(t.allocations[ContainerStats::bucketForSize(size_)], (U64)1);
+  addLiveBytes(t, (S64)size_);
+#endif
+}
+
+// Adopt memory allocated elsewhere, which 'releaser' frees
+Container::Container(Byte *_data, U64 _size, ScrubType _scrubber, ReleaseType _releaser)
+  : data_(_data), size_(_size), scrubber_(_scrubber), releaser_(_releaser), writable_(false),
+  checksum_(0), encodings_(nullptr), referencedBytes_(0), blobs_(0), prev_(nullptr),
+  next_(nullptr)
+{
+  enroll();
+#ifdef UTIL_CONTAINER_STATS
+  ThreadStats &t = threadStats();
+  bump(t.liveContainers, (S64)1);
+  bump(t.allocations[ContainerStats::bucketForSize(size_)], (U64)1);
+  addLiveBytes(t, (S64)size_);
+#endif
 }
 
 Container::~Container()
 {
+  freeEncodings();
+  unenroll();
+
   // Run the scrubber, whatever it is
-  scrubber_(data_, size_);
-  delete[] data_;
+#ifdef UTIL_CONTAINER_STATS
+  ThreadStats &t = threadStats();
+  if (scrubber_) {
+    auto start = std::chrono::steady_clock::now();
+    scrubber_(data_, size_);
+    auto stop = std::chrono::steady_clock::now();
+    bump(t.scrubCalls, (U64)1);
+    bump(t.scrubbedBytes, size_);
+    bump(t.scrubNanoseconds,
+      (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+  }
+  bump(t.liveContainers, (S64)-1);
+  addLiveBytes(t, -(S64)size_);
+#else
+  if (scrubber_) {
+    scrubber_(data_, size_);
+  }
+#endif
+  if (releaser_) {
+    releaser_(data_, size_);
+  }
+  else {
+    delete[] data_;
+  }
 }
 
-Byte *Container::data() const
+bool Container::checksum(U32 *_crc) const
 {
-  return data_;
+  U64 value = checksum_.load(std::memory_order_relaxed);
+  *_crc = (U32)value;
+  return (value & kChecksumKnown) != 0;
 }
 
-U64 Container::size() const
+void Container::checksumIs(U32 _crc)
 {
-  return size_;
+  checksum_.store(kChecksumKnown | _crc, std::memory_order_relaxed);
 }
 
+Container::Encoding Container::encoding(const std::type_info &_codec) const
+{
+  for (const CachedEncoding *e = encodings_.load(std::memory_order_acquire); e != nullptr;
+       e = e->next) {
+    if (*e->codec == _codec) {
+      return e->text;
+    }
+  }
+  return Encoding();
+}
+
+Container::Encoding Container::encodingOf(std::string &&_text, bool _scrub)
+{
+  std::string *owned = new std::string(std::move(_text));
+  if (!_scrub) {
+    return Encoding(owned);
+  }
+  return Encoding(owned, EncodingScrubber());
+}
+
+void Container::EncodingScrubber::operator()(const std::string *_text) const
+{
+  std::string *text = const_cast<std::string *>(_text);
+  scrub_zeros((Byte *)&(*text)[0], text->size());
+  delete text;
+}
+
+Container::Encoding Container::encodingIs(const std::type_info &_codec, std::string &&_text,
+  bool _scrub)
+{
+  Encoding text = encodingOf(std::move(_text), _scrub);
+  CachedEncoding *entry = new CachedEncoding{&_codec, text, nullptr};
+  CachedEncoding *head = encodings_.load(std::memory_order_acquire);
+  // Entries are only pushed, so once scanned the tail needs no second look
+  const CachedEncoding *checked = nullptr;
+  for (;;) {
+    for (const CachedEncoding *e = head; e != checked; e = e->next) {
+      if (*e->codec == _codec) {
+        delete entry;
+        return e->text;
+      }
+    }
+    checked = head;
+    entry->next = head;
+    if (encodings_.compare_exchange_weak(head, entry, std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+      return text;
+    }
+  }
+}
+
+// Only from the destructor, once no reader can be walking the list
+void Container::freeEncodings()
+{
+  CachedEncoding *e = encodings_.load(std::memory_order_acquire);
+  while (e != nullptr) {
+    CachedEncoding *next = e->next;
+    delete e;
+    e = next;
+  }
+}
+
+ContainerStats Container::stats()
+{
+  ContainerStats total;
+  memset((void *)&total, 0, sizeof(total));
+#ifdef UTIL_CONTAINER_STATS
+  GlobalStats &global = globalStats();
+  std::lock_guard<std::mutex> lock(global.mutex);
+  total = global.retired;
+  for (const ThreadStats *t : global.threads) {
+    accumulate(total, *t);
+  }
+  total.enabled = true;
+  total.peakBytes = std::max(global.peakBytes.load(std::memory_order_relaxed), total.liveBytes);
+#endif
+  return total;
+}
+
+PinningReport Container::pinning(U32 _maxWorst)
+{
+  PinningReport report;
+  report.enabled = false;
+  report.containers = 0;
+  report.pinnedBytes = 0;
+  report.referencedBytes = 0;
+#ifdef UTIL_CONTAINER_PINNING
+  report.enabled = true;
+
+  // Keep the worst entries in a min-heap on unreferenced bytes
+  auto moreWasteful = [] (const PinningReport::Entry &_a, const PinningReport::Entry &_b) {
+    return (_a.size - _a.referencedBytes) > (_b.size - _b.referencedBytes);
+  };
+  for (U32 i = 0; i < kRegistryShards; i++) {
+    RegistryShard &shard = registryShards()[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const Container *c = shard.head; c != nullptr; c = c->next_) {
+      PinningReport::Entry entry;
+      entry.size = c->size_;
+      entry.referencedBytes = std::min(c->referencedBytes_.load(std::memory_order_relaxed), c->size_);
+      entry.blobs = c->blobs_.load(std::memory_order_relaxed);
+      report.containers++;
+      report.pinnedBytes += entry.size;
+      report.referencedBytes += entry.referencedBytes;
+      if (_maxWorst == 0) {
+        continue;
+      }
+      if (report.worst.size() < _maxWorst) {
+        report.worst.push_back(entry);
+        std::push_heap(report.worst.begin(), report.worst.end(), moreWasteful);
+      }
+      else if (moreWasteful(entry, report.worst.front())) {
+        std::pop_heap(report.worst.begin(), report.worst.end(), moreWasteful);
+        report.worst.back() = entry;
+        std::push_heap(report.worst.begin(), report.worst.end(), moreWasteful);
+      }
+    }
+  }
+  std::sort_heap(report.worst.begin(), report.worst.end(), moreWasteful);
+#else
+  (void)_maxWorst;
+#endif
+  return report;
+}
+
+#ifdef UTIL_CONTAINER_PINNING
+void Container::attach(U64 _bytes)
+{
+  referencedBytes_.fetch_add(_bytes, std::memory_order_relaxed);
+  blobs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Container::detach(U64 _bytes)
+{
+  referencedBytes_.fetch_sub(_bytes, std::memory_order_relaxed);
+  blobs_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Container::enroll()
+{
+  RegistryShard &shard = registryShard(this);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  next_ = shard.head;
+  if (next_ != nullptr) {
+    next_->prev_ = this;
+  }
+  shard.head = this;
+}
+
+void Container::unenroll()
+{
+  RegistryShard &shard = registryShard(this);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (prev_ != nullptr) {
+    prev_->next_ = next_;
+  }
+  else {
+    shard.head = next_;
+  }
+  if (next_ != nullptr) {
+    next_->prev_ = prev_;
+  }
+}
+#else
+void Container::attach(U64)
+{
+  // empty
+}
+
+void Container::detach(U64)
+{
+  // empty
+}
+
+void Container::enroll()
+{
+  // empty
+}
+
+void Container::unenroll()
+{
+  // empty
+}
+#endif
+
+U32 ContainerStats::bucketForSize(U64 _size)
+{
+  return (_size == 0) ? 0 : (U32)(64 - __builtin_clzll(_size));
+}
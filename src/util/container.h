@@ -2,51 +2,208 @@
 #define UTIL_CONTAINER_H
 
 #include "util/fixed_types.h"
+#include <atomic>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
 
 namespace Util {
 
+/*
+   Process-wide allocation and lifetime statistics for Containers.
+
+   Statistics are only collected when compiled with UTIL_CONTAINER_STATS
+   defined; otherwise they cost nothing and every snapshot is zero with
+   'enabled' set to false. Counters are kept per thread and aggregated when a
+   snapshot is taken, so the hot path never touches a shared cache line. The
+   one exception is the peak, which is tracked by flushing each thread's net
+   byte count to a shared total in batches of 'kPeakBatch' bytes, so
+   'peakBytes' may under-report the true peak by up to that much per thread.
+
+   Containers may be freed by a different thread than the one that created
+   them, so per-thread live counts can be negative; only the sum is meaningful.
+*/
+struct ContainerStats
+{
+  // Allocations are counted in log2 size buckets: bucket 0 holds empty
+  // containers and bucket i holds sizes in [2^(i-1), 2^i).
+  static const U32 kBuckets = 65;
+  static const S64 kPeakBatch = 256 * 1024;
+
+  bool enabled;
+  S64 liveContainers;
+  S64 liveBytes;
+  S64 peakBytes;
+  U64 allocations[kBuckets];
+  U64 scrubCalls;
+  U64 scrubbedBytes;
+  U64 scrubNanoseconds;
+
+  static U32 bucketForSize(U64 size);
+};
+
+/*
+   Which live Containers are pinned by Blobs using little of their data, e.g.
+   a short slice keeping a large buffer alive (see Blob::compact()).
+
+   Blobs report the bytes of their container which they refer to, and every
+   Container is listed in a registry, so this is only collected when compiled
+   with UTIL_CONTAINER_PINNING defined; otherwise the report is empty with
+   'enabled' set to false. It is a debugging aid apart from the statistics
+   above: each Container takes a lock when created and destroyed, and each
+   Blob copy updates counters shared with other threads. The bytes
+   referenced by a container's Blobs are summed without regard to overlap
+   and capped at its size.
+
+   Neither define changes the layout of Containers or Blobs, so code built
+   with and without them can be linked together.
+*/
+struct PinningReport
+{
+  struct Entry
+  {
+    U64 size;             // pinned bytes
+    U64 referencedBytes;
+    U64 blobs;
+  };
+
+  bool enabled;
+  U64 containers;
+  U64 pinnedBytes;        // total size of the live containers
+  U64 referencedBytes;    // of those bytes, the ones referenced by Blobs
+  std::vector<Entry> worst;  // most unreferenced bytes first
+};
+
 class Container
 {
  public:
-  // Custom functions run prior to deallocation (e.g. to securely wipe)
+  // Custom functions run prior to deallocation (e.g. to securely wipe).
+  // An empty function means no scrubbing.
   typedef std::function<void(Byte *, U64)> ScrubType;
 
+  // Custom functions which free adopted data (e.g. to unmap a file). They
+  // run after the scrubber.
+  typedef std::function<void(Byte *, U64)> ReleaseType;
+
   // Container methods
   Container(U64 size = 0, ScrubType scrubber = ScrubType());
+  Container(Byte *data, U64 size, ScrubType scrubber, ReleaseType releaser);
   Container(const Container &) = delete;
-  Container(Container &&) = default;
+  Container(Container &&) = delete;
   Container &operator=(const Container &) = delete;
-  Container &operator=(Container &&) = default;
+  Container &operator=(Container &&) = delete;
   Byte *data() const;
   U64 size() const;
   ~Container();
 
+  // Whether a MutableBlob may still write the data. The caches below are
+  // only used once none can, so writers never have to clear them.
+  bool writable() const;
+  void writableIs(bool writable);
+
+  // A checksum of all of the data, cached by the first reader to compute it
+  bool checksum(U32 *crc) const;
+  void checksumIs(U32 crc);
+
+  // Text encodings of all of the data, one per codec, cached like the
+  // checksum by the first reader to compute each. The cache is a lock-free
+  // list: encodingIs() publishes 'text' unless another thread cached the
+  // codec first, and returns whichever encoding is cached. Readers walk the
+  // list without taking references to its entries, so entries are never
+  // removed: the list is only freed with the Container (the encodings with
+  // their last holder).
+  //
+  // The text of scrubbed data is as sensitive as the data, so with 'scrub'
+  // set it is zeroed when freed. The Container's own scrubber is not used:
+  // it may skip data it cannot write (see shared_blob.h), or be none at all
+  // for data scrubbed by its owner.
+  typedef std::shared_ptr<const std::string> Encoding;
+  struct EncodingScrubber
+  {
+    void operator()(const std::string *text) const;
+  };
+  Encoding encoding(const std::type_info &codec) const;
+  Encoding encodingIs(const std::type_info &codec, std::string &&text, bool scrub);
+
+  // An encoding which is not cached, scrubbed like a cached one
+  static Encoding encodingOf(std::string &&text, bool scrub);
+
+  // A snapshot of the statistics of all Containers in the process
+  static ContainerStats stats();
+
+  // Scan all live Containers, listing up to 'maxWorst' of the most wasteful
+  static PinningReport pinning(U32 maxWorst = 16);
+
+  // Whether the library was built with UTIL_CONTAINER_PINNING. Blobs test
+  // this rather than the define, so that code built either way agrees.
+  static const bool kPinning;
+
+  // Blobs report the bytes they refer to (see Blob::attach()); only
+  // counted with UTIL_CONTAINER_PINNING
+  void attach(U64 bytes);
+  void detach(U64 bytes);
+
  private:
   Byte *data_;
   U64 size_;
   ScrubType scrubber_;
+  ReleaseType releaser_;  // empty for data allocated by the Container
+  std::atomic<bool> writable_;
+  std::atomic<U64> checksum_;  // kChecksumKnown | crc, or 0
+  struct CachedEncoding;
+  std::atomic<CachedEncoding *> encodings_;  // most recently cached first
+
+  void freeEncodings();
+
+  // Used with UTIL_CONTAINER_PINNING only
+  std::atomic<U64> referencedBytes_;
+  std::atomic<U64> blobs_;
+  Container *prev_;  // in the registry scanned by pinning()
+  Container *next_;
+
+  void enroll();
+  void unenroll();
 };
 
+// Inline for the Blob accessors built on them
+
+inline Byte *Container::data() const
+{
+  return data_;
+}
+
+inline U64 Container::size() const
+{
+  return size_;
+}
+
+inline bool Container::writable() const
+{
+  return writable_.load(std::memory_order_acquire);
+}
+
+// Releases the writes made through the MutableBlob to the readers which
+// find the data no longer writable
+inline void Container::writableIs(bool _writable)
+{
+  writable_.store(_writable, std::memory_order_release);
+}
+
 
 // The default "scrubber" does nothing to the data
-auto scrub_null = [] (Byte *, U64) {};
-
-// A scrubber which overwrites all data with zeros
-auto scrub_zeros = [] (Byte *data, U64 size)
-{
-  U64 words = size / 8;
-  U64 bytes = size - (8 * words);
-  U64 i;
-
-  volatile U64 *vword = (U64 *)data;
-  for (i = 0; i < words; i++) {
-    vword[i] = 0L;
-  }
-  volatile Byte *vbyte = &data[size - bytes];
-  for (i = 0; i < bytes; i++) {
-    vbyte[i] = 0;
-  }
+const auto scrub_null = [] (Byte *, U64) {};
+
+// A scrubber which overwrites all data with zeros. memset() is the C
+// library's, selected for the CPU when it is loaded; the empty asm statement
+// which may read the memory keeps the compiler from removing the stores to
+// data about to be freed.
+const auto scrub_zeros = [] (Byte *data, U64 size)
+{
+  memset((void *)data, 0, size);
+  asm volatile("" : : "r"(data) : "memory");
 };
 
 } // namespace Util
@@ -1,7 +1,11 @@
 #include "gtest/gtest.h"
 #include "util/container.h"
+#include <atomic>
 #include <cstring>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace Util;
 using std::unique_ptr;
@@ -32,3 +36,117 @@ TEST(ContainerTest, ScrubZero) {
   EXPECT_EQ(buf[1023], 0xff);
 }
 
+
+TEST(ContainerTest, EncodingCache) {
+  Container c(16);
+  EXPECT_FALSE(c.encoding(typeid(int)));
+  Container::Encoding text = c.encodingIs(typeid(int), std::string("int"), false);
+  EXPECT_EQ(text, c.encoding(typeid(int)));
+  EXPECT_EQ(text, c.encodingIs(typeid(int), std::string("other"), false));   // first one wins
+  EXPECT_EQ("int", *text);
+  EXPECT_FALSE(c.encoding(typeid(long)));
+  EXPECT_EQ(nullptr, std::get_deleter<Container::EncodingScrubber>(text));
+
+  // Text to scrub is zeroed when freed, whatever the Container's scrubber
+  Container::Encoding secret = c.encodingIs(typeid(short), std::string("secret"), true);
+  EXPECT_NE(nullptr, std::get_deleter<Container::EncodingScrubber>(secret));
+  EXPECT_NE(nullptr, std::get_deleter<Container::EncodingScrubber>(
+    Container::encodingOf(std::string("secret"), true)));
+
+  // Racing threads all get the one encoding published
+  std::vector<Container::Encoding> seen(8);
+  std::vector<std::thread> threads;
+  for (U32 i = 0; i < seen.size(); i++) {
+    threads.emplace_back([&c, &seen, i] {
+      seen[i] = c.encodingIs(typeid(long), std::to_string(i), false);
+    });
+  }
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  for (const Container::Encoding &e : seen) {
+    EXPECT_EQ(c.encoding(typeid(long)), e);
+  }
+}
+
+TEST(ContainerTest, EncodingCacheWhileReading) {
+  // Readers walk the list while other threads push to it; entries stay put,
+  // and encodings outlive the Container while held
+  Container::Encoding kept;
+  {
+    Container c(16);
+    std::atomic<bool> done(false);
+    std::thread reader([&c, &done] {
+      while (!done) {
+        Container::Encoding e = c.encoding(typeid(int));
+        if (e) {
+          EXPECT_EQ("int", *e);
+        }
+      }
+    });
+    const std::type_info *codecs[] = {&typeid(char), &typeid(short), &typeid(long),
+      &typeid(float), &typeid(double), &typeid(int)};
+    for (const std::type_info *codec : codecs) {
+      std::string text = (*codec == typeid(int)) ? "int" : "x";
+      c.encodingIs(*codec, std::move(text), false);
+    }
+    kept = c.encoding(typeid(int));
+    done = true;
+    reader.join();
+    EXPECT_EQ(kept, c.encoding(typeid(int)));
+  }
+  EXPECT_EQ("int", *kept);
+}
+
+TEST(ContainerTest, StatsBuckets) {
+  EXPECT_EQ(0U, ContainerStats::bucketForSize(0));
+  EXPECT_EQ(1U, ContainerStats::bucketForSize(1));
+  EXPECT_EQ(2U, ContainerStats::bucketForSize(2));
+  EXPECT_EQ(2U, ContainerStats::bucketForSize(3));
+  EXPECT_EQ(11U, ContainerStats::bucketForSize(1024));
+  EXPECT_EQ(64U, ContainerStats::bucketForSize(~0UL));
+}
+
+#ifdef UTIL_CONTAINER_STATS
+TEST(ContainerTest, Stats) {
+  ContainerStats before = Container::stats();
+  EXPECT_TRUE(before.enabled);
+  {
+    Container c1(1000, scrub_zeros);
+    Container c2(0);
+    ContainerStats during = Container::stats();
+    EXPECT_EQ(before.liveContainers + 2, during.liveContainers);
+    EXPECT_EQ(before.liveBytes + 1000, during.liveBytes);
+    EXPECT_EQ(before.allocations[10] + 1, during.allocations[10]);
+    EXPECT_EQ(before.allocations[0] + 1, during.allocations[0]);
+    EXPECT_GE(during.peakBytes, during.liveBytes);
+  }
+  ContainerStats after = Container::stats();
+  EXPECT_EQ(before.liveContainers, after.liveContainers);
+  EXPECT_EQ(before.liveBytes, after.liveBytes);
+  EXPECT_EQ(before.scrubCalls + 1, after.scrubCalls);
+  EXPECT_EQ(before.scrubbedBytes + 1000, after.scrubbedBytes);
+}
+
+TEST(ContainerTest, StatsAcrossThreads) {
+  ContainerStats before = Container::stats();
+  unique_ptr<Container> c;
+  std::thread t([&c] { c.reset(new Container(4096)); });
+  t.join();
+  ContainerStats during = Container::stats();
+  EXPECT_EQ(before.liveContainers + 1, during.liveContainers);
+  EXPECT_EQ(before.liveBytes + 4096, during.liveBytes);
+  c.reset();
+  ContainerStats after = Container::stats();
+  EXPECT_EQ(before.liveContainers, after.liveContainers);
+  EXPECT_EQ(before.liveBytes, after.liveBytes);
+}
+#else
+TEST(ContainerTest, StatsDisabled) {
+  Container c(1000);
+  ContainerStats stats = Container::stats();
+  EXPECT_FALSE(stats.enabled);
+  EXPECT_EQ(0, stats.liveContainers);
+  EXPECT_EQ(0, stats.liveBytes);
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef UTIL_DISPATCH_H
+#define UTIL_DISPATCH_H
+
+/*
+   Run-time selection of instruction set variants. The library is compiled
+   for the baseline ISA (see CXX_OPT in the Makefile), so it runs on any
+   x86-64 host. Kernels which benefit from newer instructions are compiled
+   again for them, with '#pragma GCC target' or UTIL_TARGET_CLONES. Each
+   kernel is bound to the best variant once, when the library is loaded,
+   through a GNU indirect function (ifunc) whose resolver queries the CPU.
+
+   UTIL_DISPATCH is defined where this is supported: GCC targeting x86-64
+   ELF. Elsewhere, or when UTIL_NO_DISPATCH is defined, each kernel is
+   compiled once for the instructions the compiler flags allow (e.g.
+   -march=native), which is also how the non-AVX2 variants can be tested on
+   an AVX2 host.
+
+   Resolvers run before constructors, while relocations are processed, so
+   they may only use the CPU queries below. They are declared UTIL_RESOLVER,
+   which also keeps sanitizers from instrumenting them: AddressSanitizer's
+   checks would read its shadow memory before it is set up.
+*/
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__ELF__) && \
+    !defined(UTIL_NO_DISPATCH)
+#define UTIL_DISPATCH
+
+// Compile a plain C++ function once per listed target and bind it at load time
+#define UTIL_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+
+// For resolvers and everything they call
+#define UTIL_RESOLVER __attribute__((no_sanitize_address))
+
+namespace Util {
+namespace Cpu {
+
+UTIL_RESOLVER inline bool hasAvx2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+UTIL_RESOLVER inline bool hasSsse3()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+}
+
+UTIL_RESOLVER inline bool hasSse42()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2");
+}
+
+} // namespace Cpu
+} // namespace Util
+
+#else
+#define UTIL_TARGET_CLONES
+#endif
+
+#endif // UTIL_DISPATCH_H
@@ -0,0 +1,179 @@
+#include "util/parallel_copy.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Util;
+
+namespace {
+
+const U32 kMaxDefaultThreads = 8;
+
+// Shares start on cache-line boundaries so no line is written by two threads
+const U64 kShareAlignment = 64;
+
+/*
+   Worker threads wait for a job (a copy or other work over a range of
+   bytes), take shares of it until none are left, and the last one to finish
+   wakes the caller. Only one job runs at a time; 'busy_' turns other callers
+   away.
+*/
+class Pool
+{
+ public:
+  Pool();
+  bool run(U64 size, const ParallelCopy::Work &work, U32 threads);
+  U32 threads();
+  void threadsIs(U32 threads);
+
+ private:
+  void work();
+  void runShares();
+
+  std::mutex mutex_;
+  std::condition_variable work_;
+  std::condition_variable done_;
+  std::vector<std::thread> workers_;
+  bool busy_;
+  U32 threads_;
+
+  // The job in progress, split into 'shares_' pieces of 'share_' bytes
+  const ParallelCopy::Work *job_;
+  U64 size_;
+  U64 share_;
+  U32 shares_;
+  U32 nextShare_;
+  U32 remaining_;
+  U64 generation_;
+};
+
+Pool::Pool()
+  : busy_(false), job_(nullptr), size_(0), share_(0), shares_(0),
+  nextShare_(0), remaining_(0), generation_(0)
+{
+  U32 hardware = std::thread::hardware_concurrency();
+  threads_ = hardware == 0 ? 1 : (hardware < kMaxDefaultThreads ? hardware : kMaxDefaultThreads);
+}
+
+// Returns false when another job is in progress
+bool Pool::run(U64 _size, const ParallelCopy::Work &_work, U32 _threads)
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (busy_ || _threads < 2 || _size == 0) {
+      return false;
+    }
+    busy_ = true;
+    // Workers are started on demand and never stopped; a smaller thread
+    // count splits the job into fewer shares than there are workers
+    while (workers_.size() < _threads - 1) {
+      workers_.emplace_back(&Pool::work, this);
+    }
+    U64 share = (_size + _threads - 1) / _threads;
+    share_ = (share + kShareAlignment - 1) & ~(kShareAlignment - 1);
+    job_ = &_work;
+    size_ = _size;
+    shares_ = (U32)((_size + share_ - 1) / share_);
+    nextShare_ = 0;
+    remaining_ = shares_;
+    generation_++;
+  }
+  work_.notify_all();
+  runShares();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (remaining_ > 0) {
+    done_.wait(lock);
+  }
+  busy_ = false;
+  return true;
+}
+
+void Pool::work()
+{
+  U64 seen = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    while (generation_ == seen) {
+      work_.wait(lock);
+    }
+    seen = generation_;
+    lock.unlock();
+    runShares();
+    lock.lock();
+  }
+}
+
+// Run shares of the current job until none are left
+void Pool::runShares()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (nextShare_ < shares_) {
+    U64 offset = nextShare_++ * share_;
+    U64 size = size_ - offset < share_ ? size_ - offset : share_;
+    lock.unlock();
+    (*job_)(offset, size);
+    lock.lock();
+    if (--remaining_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+U32 Pool::threads()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threads_;
+}
+
+void Pool::threadsIs(U32 _threads)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  threads_ = _threads == 0 ? 1 : _threads;
+}
+
+// Never destroyed: idle workers are left blocked at exit
+Pool &pool()
+{
+  static Pool *pool = new Pool();
+  return *pool;
+}
+
+} // anonymous namespace
+
+std::atomic<U64> ParallelCopy::threshold_(ParallelCopy::kDefaultThreshold);
+
+void ParallelCopy::copyInParallel(Byte *_dst, const Byte *_src, U64 _size)
+{
+  runInParallel(_size, [_dst, _src] (U64 _offset, U64 _share) {
+    memcpy((void *)&_dst[_offset], (const void *)&_src[_offset], _share);
+  });
+}
+
+void ParallelCopy::runInParallel(U64 _size, const Work &_work)
+{
+  if (!pool().run(_size, _work, pool().threads())) {
+    _work(0, _size);
+  }
+}
+
+U32 ParallelCopy::threads()
+{
+  return pool().threads();
+}
+
+void ParallelCopy::threadsIs(U32 _threads)
+{
+  pool().threadsIs(_threads);
+}
+
+U64 ParallelCopy::threshold()
+{
+  return threshold_.load(std::memory_order_relaxed);
+}
+
+void ParallelCopy::thresholdIs(U64 _bytes)
+{
+  threshold_.store(_bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,80 @@
+#ifndef UTIL_PARALLEL_COPY_H
+#define UTIL_PARALLEL_COPY_H
+
+#include "util/fixed_types.h"
+#include <atomic>
+#include <cstring>
+#include <functional>
+
+namespace Util {
+
+/*
+   Copies of at least threshold() bytes are split across a pool of threads.
+   One core cannot saturate the memory bandwidth of a large machine, and the
+   first write to a freshly allocated page places it on the NUMA node of the
+   writing thread, so copying a new container in parallel also spreads its
+   pages across the nodes the pool runs on.
+
+   Blobs copy through ParallelCopy when they are constructed from a pointer,
+   reassigned with dataIs(), copied into a MutableBlob, or concatenated.
+   Smaller copies are a plain memcpy() after one comparison.
+
+   The pool's threads are started on first use. The calling thread copies a
+   share too, so 'threads' counts it; 1 disables parallel copying. When the
+   pool is busy with another caller's copy the caller copies on its own
+   rather than waiting.
+
+   forShares() runs other work which streams through memory the way a copy
+   does, such as the transforms in transform.h, on the same pool and with
+   the same threshold.
+*/
+class ParallelCopy
+{
+ public:
+  static const U64 kDefaultThreshold = 8UL << 20;
+
+  // Work on the bytes [offset, offset + size) of a larger range
+  typedef std::function<void(U64 offset, U64 size)> Work;
+
+  static void copy(Byte *dst, const Byte *src, U64 size);
+
+  // Run 'work' over [0, size), in shares which start on cache lines when
+  // 'size' is at least threshold(), or else in one direct call
+  template<typename F> static void forShares(U64 size, const F &work);
+
+  // Defaults to the number of hardware threads, up to 8
+  static U32 threads();
+  static void threadsIs(U32 threads);
+  static U64 threshold();
+  static void thresholdIs(U64 bytes);
+
+ private:
+  static void copyInParallel(Byte *dst, const Byte *src, U64 size);
+  static void runInParallel(U64 size, const Work &work);
+  static std::atomic<U64> threshold_;
+};
+
+inline void ParallelCopy::copy(Byte *_dst, const Byte *_src, U64 _size)
+{
+  if (_size < threshold_.load(std::memory_order_relaxed)) {
+    memcpy((void *)_dst, (const void *)_src, _size);
+  }
+  else {
+    copyInParallel(_dst, _src, _size);
+  }
+}
+
+template<typename F>
+void ParallelCopy::forShares(U64 _size, const F &_work)
+{
+  if (_size < threshold_.load(std::memory_order_relaxed)) {
+    _work(0UL, _size);
+  }
+  else {
+    runInParallel(_size, Work(_work));
+  }
+}
+
+} // namespace Util
+
+#endif // UTIL_PARALLEL_COPY_H
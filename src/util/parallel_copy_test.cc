@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "util/parallel_copy.h"
+#include "util/blob.h"
+#include <thread>
+#include <vector>
+
+using namespace Util;
+
+namespace {
+
+// Runs a test with the given configuration and restores the defaults after
+struct Configuration
+{
+  Configuration(U32 threads, U64 threshold)
+    : threads_(ParallelCopy::threads()), threshold_(ParallelCopy::threshold())
+  {
+    ParallelCopy::threadsIs(threads);
+    ParallelCopy::thresholdIs(threshold);
+  }
+
+  ~Configuration()
+  {
+    ParallelCopy::threadsIs(threads_);
+    ParallelCopy::thresholdIs(threshold_);
+  }
+
+  U32 threads_;
+  U64 threshold_;
+};
+
+std::vector<Byte> pattern(U64 size)
+{
+  std::vector<Byte> data(size);
+  for (U64 i = 0; i < size; i++) {
+    data[i] = (Byte)(i * 7 + i / 251);
+  }
+  return data;
+}
+
+} // anonymous namespace
+
+TEST(ParallelCopyTest, Copy) {
+  std::vector<Byte> src = pattern(100003);
+  for (U32 threads : {1U, 2U, 3U, 8U}) {
+    Configuration configuration(threads, 0);
+    EXPECT_EQ(threads, ParallelCopy::threads());
+    for (U64 size : {0UL, 1UL, 63UL, 64UL, 65UL, 1000UL, 100003UL}) {
+      std::vector<Byte> dst(size + 1, 0xee);
+      ParallelCopy::copy(dst.data(), src.data(), size);
+      EXPECT_EQ(0, memcmp((const void *)dst.data(), (const void *)src.data(), size));
+      EXPECT_EQ(0xee, dst[size]);   // nothing past the end
+    }
+  }
+}
+
+TEST(ParallelCopyTest, Concurrent) {
+  // Callers that find the pool busy copy on their own
+  Configuration configuration(4, 1024);
+  std::vector<Byte> src = pattern(1 << 20);
+  std::vector<std::thread> callers;
+  std::vector<U32> ok(4, 0);   // not vector<bool>, which shares words
+  for (U32 t = 0; t < 4; t++) {
+    callers.emplace_back([&src, &ok, t] {
+      bool same = true;
+      for (U32 i = 0; i < 20; i++) {
+        std::vector<Byte> dst(src.size());
+        ParallelCopy::copy(dst.data(), src.data(), src.size());
+        same = same && dst == src;
+      }
+      ok[t] = same ? 1 : 0;
+    });
+  }
+  for (auto &caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(std::vector<U32>(4, 1), ok);
+}
+
+TEST(ParallelCopyTest, Blobs) {
+  Configuration configuration(3, 4096);
+  std::vector<Byte> src = pattern(50000);
+  Blob blob(src.data(), src.size());
+  EXPECT_EQ(0, memcmp((const void *)blob.data(), (const void *)src.data(), src.size()));
+
+  Blob reassigned;
+  reassigned.dataIs(src.data(), src.size());
+  EXPECT_EQ(blob, reassigned);
+  EXPECT_EQ(blob, MutableBlob(blob));
+
+  Blob joined({ blob, Blob(blob, 10), blob });
+  EXPECT_EQ(2 * src.size() + 10, joined.size());
+  EXPECT_EQ(blob, Blob(joined, src.size()));
+  EXPECT_EQ(blob, Blob(joined, src.size(), src.size() + 10));
+}
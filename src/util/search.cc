@@ -0,0 +1,286 @@
+#include "util/search.h"
+#include "util/dispatch.h"
+#include <cstring>
+
+// The variants compiled: AVX2 and SSE2 (the x86-64 baseline), to be chosen
+// at load time, or else the one the compiler flags allow
+#if defined(UTIL_DISPATCH)
+#define UTIL_SEARCH_AVX2
+#define UTIL_SEARCH_SSE2
+#elif __AVX2__
+#define UTIL_SEARCH_AVX2
+#elif __SSE2__
+#define UTIL_SEARCH_SSE2
+#else
+#define UTIL_SEARCH_PORTABLE
+#endif
+
+#if defined(UTIL_SEARCH_AVX2) || defined(UTIL_SEARCH_SSE2)
+#include <immintrin.h>
+#endif
+
+using namespace Util;
+
+namespace {
+
+const U64 kNotFound = ~0UL;
+
+// Needles the vector loops don't handle: empty, single bytes and needles
+// longer than the haystack
+inline U64 findShort(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize == 0) {
+    return 0;
+  }
+  if (_needleSize > _size) {
+    return kNotFound;
+  }
+  const void *hit = memchr((const void *)_haystack, _needle[0], _size);
+  return hit == nullptr ? kNotFound : (U64)((const Byte *)hit - _haystack);
+}
+
+inline U64 rfindShort(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize == 0) {
+    return _size;
+  }
+  if (_needleSize > _size) {
+    return kNotFound;
+  }
+  const void *hit = memrchr((const void *)_haystack, _needle[0], _size);
+  return hit == nullptr ? kNotFound : (U64)((const Byte *)hit - _haystack);
+}
+
+// Whether the needle, whose first and last bytes are known to match, is at 'position'
+inline bool matchesAt(const Byte *_haystack, U64 _position, const Byte *_needle, U64 _needleSize)
+{
+  return memcmp((const void *)&_haystack[_position + 1], (const void *)&_needle[1],
+    _needleSize - 2) == 0;
+}
+
+// Candidate positions from 'from' on, a memchr() of the first byte at a time
+U64 findScalar(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize, U64 _from)
+{
+  U64 end = _size - _needleSize + 1;
+  while (_from < end) {
+    const void *hit = memchr((const void *)&_haystack[_from], _needle[0], end - _from);
+    if (hit == nullptr) {
+      return kNotFound;
+    }
+    U64 position = (U64)((const Byte *)hit - _haystack);
+    if (memcmp((const void *)&_haystack[position + 1], (const void *)&_needle[1],
+          _needleSize - 1) == 0) {
+      return position;
+    }
+    _from = position + 1;
+  }
+  return kNotFound;
+}
+
+// Candidate positions before 'end', from the last down
+U64 rfindScalar(const Byte *_haystack, const Byte *_needle, U64 _needleSize, U64 _end)
+{
+  while (_end > 0) {
+    const void *hit = memrchr((const void *)_haystack, _needle[0], _end);
+    if (hit == nullptr) {
+      return kNotFound;
+    }
+    U64 position = (U64)((const Byte *)hit - _haystack);
+    if (memcmp((const void *)&_haystack[position + 1], (const void *)&_needle[1],
+          _needleSize - 1) == 0) {
+      return position;
+    }
+    _end = position;
+  }
+  return kNotFound;
+}
+
+#ifdef UTIL_SEARCH_AVX2
+#ifdef UTIL_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+namespace Avx2 {
+
+// Bit k is set where the first and last bytes match at position i + k
+inline U32 candidates(const Byte *_haystack, U64 _i, U64 _needleSize, __m256i _first,
+  __m256i _last)
+{
+  __m256i head = _mm256_loadu_si256((const __m256i *)&_haystack[_i]);
+  __m256i tail = _mm256_loadu_si256((const __m256i *)&_haystack[_i + _needleSize - 1]);
+  return (U32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, _first),
+    _mm256_cmpeq_epi8(tail, _last)));
+}
+
+U64 findBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize <= 1 || _needleSize > _size) {
+    return findShort(_haystack, _size, _needle, _needleSize);
+  }
+  const __m256i first = _mm256_set1_epi8((char)_needle[0]);
+  const __m256i last = _mm256_set1_epi8((char)_needle[_needleSize - 1]);
+  U64 end = _size - _needleSize + 1;
+  U64 i = 0;
+  for (; i + 32 <= end; i += 32) {
+    for (U32 mask = candidates(_haystack, i, _needleSize, first, last); mask != 0;
+         mask &= mask - 1) {
+      U64 position = i + (U64)__builtin_ctz(mask);
+      if (matchesAt(_haystack, position, _needle, _needleSize)) {
+        return position;
+      }
+    }
+  }
+  return findScalar(_haystack, _size, _needle, _needleSize, i);
+}
+
+U64 rfindBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize <= 1 || _needleSize > _size) {
+    return rfindShort(_haystack, _size, _needle, _needleSize);
+  }
+  const __m256i first = _mm256_set1_epi8((char)_needle[0]);
+  const __m256i last = _mm256_set1_epi8((char)_needle[_needleSize - 1]);
+  U64 end = _size - _needleSize + 1;
+  for (; end >= 32; end -= 32) {
+    U64 i = end - 32;
+    for (U32 mask = candidates(_haystack, i, _needleSize, first, last); mask != 0; ) {
+      U32 k = 31 - (U32)__builtin_clz(mask);
+      if (matchesAt(_haystack, i + k, _needle, _needleSize)) {
+        return i + k;
+      }
+      mask &= ~(1U << k);
+    }
+  }
+  return rfindScalar(_haystack, _needle, _needleSize, end);
+}
+
+} // namespace Avx2
+#ifdef UTIL_DISPATCH
+#pragma GCC pop_options
+#endif
+#endif
+
+#ifdef UTIL_SEARCH_SSE2
+namespace Sse2 {
+
+inline U32 candidates(const Byte *_haystack, U64 _i, U64 _needleSize, __m128i _first,
+  __m128i _last)
+{
+  __m128i head = _mm_loadu_si128((const __m128i *)&_haystack[_i]);
+  __m128i tail = _mm_loadu_si128((const __m128i *)&_haystack[_i + _needleSize - 1]);
+  return (U32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, _first),
+    _mm_cmpeq_epi8(tail, _last)));
+}
+
+U64 findBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize <= 1 || _needleSize > _size) {
+    return findShort(_haystack, _size, _needle, _needleSize);
+  }
+  const __m128i first = _mm_set1_epi8((char)_needle[0]);
+  const __m128i last = _mm_set1_epi8((char)_needle[_needleSize - 1]);
+  U64 end = _size - _needleSize + 1;
+  U64 i = 0;
+  for (; i + 16 <= end; i += 16) {
+    for (U32 mask = candidates(_haystack, i, _needleSize, first, last); mask != 0;
+         mask &= mask - 1) {
+      U64 position = i + (U64)__builtin_ctz(mask);
+      if (matchesAt(_haystack, position, _needle, _needleSize)) {
+        return position;
+      }
+    }
+  }
+  return findScalar(_haystack, _size, _needle, _needleSize, i);
+}
+
+U64 rfindBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize <= 1 || _needleSize > _size) {
+    return rfindShort(_haystack, _size, _needle, _needleSize);
+  }
+  const __m128i first = _mm_set1_epi8((char)_needle[0]);
+  const __m128i last = _mm_set1_epi8((char)_needle[_needleSize - 1]);
+  U64 end = _size - _needleSize + 1;
+  for (; end >= 16; end -= 16) {
+    U64 i = end - 16;
+    for (U32 mask = candidates(_haystack, i, _needleSize, first, last); mask != 0; ) {
+      U32 k = 31 - (U32)__builtin_clz(mask);
+      if (matchesAt(_haystack, i + k, _needle, _needleSize)) {
+        return i + k;
+      }
+      mask &= ~(1U << k);
+    }
+  }
+  return rfindScalar(_haystack, _needle, _needleSize, end);
+}
+
+} // namespace Sse2
+#endif
+
+#ifdef UTIL_SEARCH_PORTABLE
+namespace Portable {
+
+U64 findBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize <= 1 || _needleSize > _size) {
+    return findShort(_haystack, _size, _needle, _needleSize);
+  }
+  return findScalar(_haystack, _size, _needle, _needleSize, 0);
+}
+
+U64 rfindBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  if (_needleSize <= 1 || _needleSize > _size) {
+    return rfindShort(_haystack, _size, _needle, _needleSize);
+  }
+  return rfindScalar(_haystack, _needle, _needleSize, _size - _needleSize + 1);
+}
+
+} // namespace Portable
+#endif
+
+} // anonymous namespace
+
+
+#ifdef UTIL_DISPATCH
+extern "C" {
+
+UTIL_RESOLVER
+static decltype(&Sse2::findBytes) util_resolve_findBytes()
+{
+  return Cpu::hasAvx2() ? &Avx2::findBytes : &Sse2::findBytes;
+}
+
+UTIL_RESOLVER
+static decltype(&Sse2::rfindBytes) util_resolve_rfindBytes()
+{
+  return Cpu::hasAvx2() ? &Avx2::rfindBytes : &Sse2::rfindBytes;
+}
+
+} // extern "C"
+
+namespace Util {
+
+U64 findBytes(const Byte *, U64, const Byte *, U64) __attribute__((ifunc("util_resolve_findBytes")));
+U64 rfindBytes(const Byte *, U64, const Byte *, U64) __attribute__((ifunc("util_resolve_rfindBytes")));
+
+} // namespace Util
+#else
+#if defined(UTIL_SEARCH_AVX2)
+namespace Selected = Avx2;
+#elif defined(UTIL_SEARCH_SSE2)
+namespace Selected = Sse2;
+#else
+namespace Selected = Portable;
+#endif
+
+U64 Util::findBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  return Selected::findBytes(_haystack, _size, _needle, _needleSize);
+}
+
+U64 Util::rfindBytes(const Byte *_haystack, U64 _size, const Byte *_needle, U64 _needleSize)
+{
+  return Selected::rfindBytes(_haystack, _size, _needle, _needleSize);
+}
+#endif
@@ -0,0 +1,29 @@
+#ifndef UTIL_SEARCH_H
+#define UTIL_SEARCH_H
+
+#include "util/fixed_types.h"
+
+namespace Util {
+
+/*
+   Substring search over raw bytes, behind Blob::find() and Blob::rfind().
+
+   A needle of two or more bytes is found by comparing its first and last
+   bytes against a vector of candidate positions at a time (32 with AVX2, 16
+   with SSE2) and comparing the rest of it only where both match, so the
+   inner loop rarely leaves the vector registers. A single byte is handed to
+   memchr() or memrchr(), which the C library already tunes per CPU.
+
+   Both return the offset of the match in 'haystack', or ~0 if there is none.
+   An empty needle matches at the start (findBytes) or at the end (rfindBytes).
+*/
+
+// The first occurrence of 'needle' in 'haystack'
+U64 findBytes(const Byte *haystack, U64 size, const Byte *needle, U64 needleSize);
+
+// The last occurrence of 'needle' in 'haystack'
+U64 rfindBytes(const Byte *haystack, U64 size, const Byte *needle, U64 needleSize);
+
+} // namespace Util
+
+#endif // UTIL_SEARCH_H
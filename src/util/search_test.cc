@@ -0,0 +1,131 @@
+#include "gtest/gtest.h"
+#include "util/search.h"
+#include "util/blob.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+BlobView viewOf(const string &s)
+{
+  return BlobView((const Byte *)s.data(), s.size());
+}
+
+// Text over a small alphabet, so that partial matches are common
+string randomText(std::default_random_engine &gen, U64 size)
+{
+  std::uniform_int_distribution<U32> dist(0, 2);
+  string text(size, 'a');
+  for (U64 i = 0; i < size; i++) {
+    text[i] = (char)('a' + dist(gen));
+  }
+  return text;
+}
+
+U64 expected(string::size_type position)
+{
+  return position == string::npos ? Blob::kNotFound : position;
+}
+
+template<typename T>
+std::vector<string> fields(const Split<T> &split)
+{
+  std::vector<string> out;
+  for (const T &field : split) {
+    out.push_back(string((const char *)field.data(), field.size()));
+  }
+  return out;
+}
+
+} // anonymous namespace
+
+
+TEST(SearchTest, MatchesStdString) {
+  std::default_random_engine gen(5);
+  for (U64 size : {0UL, 1UL, 2UL, 15UL, 16UL, 17UL, 31UL, 32UL, 33UL, 64UL, 100UL, 257UL}) {
+    string haystack = randomText(gen, size);
+    for (U64 needleSize = 0; needleSize <= 40; needleSize++) {
+      // Needles taken from the haystack are found; random ones mostly not
+      for (int trial = 0; trial < 4; trial++) {
+        string needle = randomText(gen, needleSize);
+        if (trial % 2 == 0 && needleSize <= size) {
+          std::uniform_int_distribution<U64> at(0, size - needleSize);
+          needle = haystack.substr(at(gen), needleSize);
+        }
+        const Byte *h = (const Byte *)haystack.data();
+        const Byte *n = (const Byte *)needle.data();
+        EXPECT_EQ(expected(haystack.find(needle)), findBytes(h, size, n, needleSize))
+          << haystack << " / " << needle;
+        EXPECT_EQ(expected(haystack.rfind(needle)), rfindBytes(h, size, n, needleSize))
+          << haystack << " / " << needle;
+      }
+    }
+  }
+}
+
+TEST(SearchTest, BlobFind) {
+  string text = "one two one two one";
+  Blob blob(text);
+  BlobView view = blob.view();
+
+  EXPECT_EQ(0UL, blob.find(viewOf("one")));
+  EXPECT_EQ(8UL, blob.find(viewOf("one"), 1));
+  EXPECT_EQ(16UL, blob.find(viewOf("one"), 16));
+  EXPECT_EQ(Blob::kNotFound, blob.find(viewOf("one"), 17));
+  EXPECT_EQ(Blob::kNotFound, blob.find(viewOf("three")));
+  EXPECT_EQ(Blob::kNotFound, blob.find(viewOf("one"), 100));
+  EXPECT_EQ(5UL, blob.find(BlobView(), 5));
+  EXPECT_EQ(text.size(), blob.find(BlobView(), text.size()));
+
+  EXPECT_EQ(16UL, view.rfind(viewOf("one")));
+  EXPECT_EQ(16UL, view.rfind(viewOf("one"), 16));
+  EXPECT_EQ(8UL, view.rfind(viewOf("one"), 15));
+  EXPECT_EQ(0UL, view.rfind(viewOf("one"), 0));
+  EXPECT_EQ(Blob::kNotFound, view.rfind(viewOf("two"), 3));
+  EXPECT_EQ(text.size(), view.rfind(BlobView()));
+  EXPECT_EQ(3UL, view.rfind(BlobView(), 3));
+
+  EXPECT_EQ(3UL, blob.findByte(' '));
+  EXPECT_EQ(7UL, blob.findByte(' ', 4));
+  EXPECT_EQ(Blob::kNotFound, blob.findByte('x'));
+  EXPECT_EQ(Blob::kNotFound, blob.findByte(' ', text.size()));
+
+  // Offsets are relative to a slice
+  Blob slice(blob, 11, 4);
+  EXPECT_EQ(4UL, slice.find(viewOf("one")));
+  EXPECT_EQ(Blob::kNotFound, slice.find(viewOf("one two one")));
+}
+
+TEST(SearchTest, Split) {
+  Blob records(string("a,bb,,ccc,"));
+  std::vector<string> all = {"a", "bb", "", "ccc", ""};
+  EXPECT_EQ(all, fields(records.view().split(',')));
+  EXPECT_EQ(all, fields(records.split(',')));
+  EXPECT_EQ(std::vector<string>({"a,bb,,ccc,"}), fields(records.split(';')));
+  EXPECT_EQ(std::vector<string>({""}), fields(Blob().split(',')));
+
+  Blob lines(string("GET / HTTP/1.1\r\nHost: x\r\n\r\n"));
+  string crlf = "\r\n";
+  EXPECT_EQ(std::vector<string>({"GET / HTTP/1.1", "Host: x", "", ""}),
+    fields(lines.split(viewOf(crlf))));
+  EXPECT_EQ(std::vector<string>({"GET / HTTP/1.1\r\nHost: x\r\n\r\n"}),
+    fields(lines.split(BlobView())));
+
+  // Blob fields share the source's data
+  for (const Blob &field : records.split(',')) {
+    EXPECT_TRUE(field.size() == 0 || (field.data() >= records.data() &&
+      field.data() < &records.data()[records.size()]));
+  }
+
+  Split<BlobView> split = records.view().split(',');
+  Split<BlobView>::Iterator it = split.begin();
+  EXPECT_EQ(1UL, it->size());
+  EXPECT_EQ(2UL, (++it)->size());
+  it++;
+  EXPECT_EQ(0UL, (*it).size());
+  EXPECT_EQ(2, std::distance(++it, split.end()));
+}
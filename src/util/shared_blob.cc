@@ -0,0 +1,189 @@
+#include "util/shared_blob.h"
+#include "util/container.h"
+#include <cerrno>
+#include <memory>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Util;
+
+namespace {
+
+// Sealed files can neither be written nor resized, nor have the seals lifted
+const int kSeals = F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+// Close the descriptor without losing the errno of the failure
+void closeAfterError(int _fd)
+{
+  int error = errno;
+  ::close(_fd);
+  errno = error;
+}
+
+// Map all of the file into a Container, which unmaps it and closes the
+// descriptor on release. Returns null on failure, with the descriptor closed.
+std::shared_ptr<Container> mapFile(int _fd, U64 _size, int _prot, Container::ScrubType _scrubber)
+{
+  void *map = nullptr;
+  if (_size > 0) {
+    map = ::mmap(nullptr, _size, _prot, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED) {
+      closeAfterError(_fd);
+      return nullptr;
+    }
+  }
+  return std::make_shared<Container>((Byte *)map, _size, _scrubber, [_fd] (Byte *_data, U64 _n) {
+    if (_n > 0) {
+      ::munmap((void *)_data, _n);
+    }
+    ::close(_fd);
+  });
+}
+
+// The scrubber only runs while the data is writable; sealed pages may be
+// mapped by other processes
+Container::ScrubType unlessSealed(int _fd, Container::ScrubType _scrubber)
+{
+  if (!_scrubber) {
+    return _scrubber;
+  }
+  return [_fd, _scrubber] (Byte *_data, U64 _n) {
+    int seals = ::fcntl(_fd, F_GET_SEALS);
+    if ((seals >= 0) && ((seals & F_SEAL_WRITE) == 0)) {
+      _scrubber(_data, _n);
+    }
+  };
+}
+
+} // anonymous namespace
+
+
+// SharedBlob
+
+SharedBlob::SharedBlob()
+  : fd_(-1)
+{
+  // empty
+}
+
+// Only files sealed against writes and shrinking are safe to map: the
+// sender could otherwise change the data, or truncate it so that reading
+// the mapping faults
+SharedBlob::SharedBlob(int _fd, ScrubType _scrubType, CompareType _compareType)
+  : Blob(0, _scrubType, _compareType), fd_(-1)
+{
+  int seals = ::fcntl(_fd, F_GET_SEALS);
+  if (seals < 0) {
+    return;
+  }
+  if ((seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) != (F_SEAL_WRITE | F_SEAL_SHRINK)) {
+    errno = EPERM;
+    return;
+  }
+  struct stat st;
+  if (::fstat(_fd, &st) != 0) {
+    return;
+  }
+  int file = ::fcntl(_fd, F_DUPFD_CLOEXEC, 0);
+  if (file < 0) {
+    return;
+  }
+  std::shared_ptr<Container> mapping = mapFile(file, (U64)st.st_size, PROT_READ,
+    Container::ScrubType());
+  if (!mapping) {
+    return;
+  }
+  Blob::operator=(Blob(mapping, _scrubType, _compareType));
+  fd_ = file;
+}
+
+// The descriptor goes with the data, so the moved-from blob has neither
+SharedBlob::SharedBlob(SharedBlob &&_other)
+  : Blob(std::move(_other)), fd_(_other.fd_)
+{
+  _other.fd_ = -1;
+}
+
+SharedBlob &SharedBlob::operator=(SharedBlob &&_other)
+{
+  if (this != &_other) {
+    Blob::operator=(std::move(_other));
+    fd_ = _other.fd_;
+    _other.fd_ = -1;
+  }
+  return *this;
+}
+
+
+// SharedMutableBlob
+
+SharedMutableBlob::SharedMutableBlob(U64 _size, ScrubType _scrubType, CompareType _compareType)
+  : MutableBlob(0, _scrubType, _compareType), fd_(-1)
+{
+  int file = ::memfd_create("util_blob", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (file < 0) {
+    return;
+  }
+  if (::ftruncate(file, (off_t)_size) != 0) {
+    closeAfterError(file);
+    return;
+  }
+  std::shared_ptr<Container> mapping = mapFile(file, _size, PROT_READ | PROT_WRITE,
+    unlessSealed(file, scrubberForType(_scrubType)));
+  if (!mapping) {
+    return;
+  }
+  containerIs(mapping);
+  fd_ = file;
+}
+
+SharedMutableBlob::SharedMutableBlob(SharedMutableBlob &&_other)
+  : MutableBlob(std::move(_other)), fd_(_other.fd_)
+{
+  _other.fd_ = -1;
+}
+
+SharedMutableBlob &SharedMutableBlob::operator=(SharedMutableBlob &&_other)
+{
+  if (this != &_other) {
+    MutableBlob::operator=(std::move(_other));
+    fd_ = _other.fd_;
+    _other.fd_ = -1;
+  }
+  return *this;
+}
+
+// A file with a shared mapping which may be written (even one mapped
+// read-only through a writable descriptor) cannot be sealed against writes.
+// The mapping is first replaced by a private read-only one at the same
+// address, which keeps every Blob of the data valid; as it is never written
+// it still maps the file's own pages.
+SharedBlob SharedMutableBlob::seal()
+{
+  SharedBlob sealed;
+  if (fd_ < 0) {
+    errno = EBADF;
+    return sealed;
+  }
+  void *data = (void *)container_->data();
+  U64 size = container_->size();
+  if ((size > 0) &&
+      (::mmap(data, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd_, 0) == MAP_FAILED)) {
+    return sealed;
+  }
+  if (::fcntl(fd_, F_ADD_SEALS, kSeals) != 0) {
+    int error = errno;
+    if (size > 0) {
+      ::mmap(data, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd_, 0);
+    }
+    errno = error;
+    return sealed;
+  }
+  sealed.Blob::operator=(Blob(*this));
+  sealed.fd_ = fd_;
+  dataIsNull();
+  fd_ = -1;
+  return sealed;
+}
@@ -0,0 +1,95 @@
+#ifndef UTIL_SHARED_BLOB_H
+#define UTIL_SHARED_BLOB_H
+
+#include "util/blob.h"
+#include "util/fixed_types.h"
+
+namespace Util {
+
+/*
+   Shared-memory Blobs hand data to another process without copying it. A
+   SharedMutableBlob is a MutableBlob whose data lives in an anonymous
+   memory file (memfd_create()). Once filled, seal() makes the data
+   read-only for good and returns it as a SharedBlob. Its descriptor is
+   passed to the other process, e.g. over a Unix socket (SCM_RIGHTS), where
+   a SharedBlob maps the same pages:
+
+     Util::SharedMutableBlob out(size);
+     fill(out.data(), out.size());
+     Util::SharedBlob sealed = out.seal();
+     sendDescriptor(socket, sealed.fd());
+
+     Util::SharedBlob in(receiveDescriptor(socket));   // in the worker
+
+   The file is sealed against writes and resizing, so the receiver can rely
+   on the data never changing (or being truncated) under its mapping; a
+   SharedBlob only maps files sealed that way.
+
+   Both are Blobs in every other respect: they slice and share their data
+   as usual, and the mapping and descriptor are released with the last Blob
+   of the data. Data scrubbed on release is zeroed while it is writable;
+   sealed pages cannot be written, and once no process maps them they are
+   freed by the kernel, which clears pages before reusing them. Text cached
+   by cachedEncode() is in process memory, and is zeroed either way.
+
+   Failures leave the blob empty, with fd() at -1 and errno set. A blob
+   moved from is left empty the same way.
+*/
+
+class SharedBlob : public Blob
+{
+ public:
+  SharedBlob();
+
+  // Map a sealed memory file read-only. The descriptor is duplicated, so
+  // the caller keeps (and closes) its own.
+  explicit SharedBlob(int fd, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  SharedBlob(const SharedBlob &) = default;
+  SharedBlob(SharedBlob &&other);
+  SharedBlob &operator=(const SharedBlob &) = default;
+  SharedBlob &operator=(SharedBlob &&other);
+
+  // The memory file, to pass to another process; it stays open as long as
+  // any Blob of the data
+  int fd() const;
+
+ private:
+  friend class SharedMutableBlob;
+
+  int fd_;
+};
+
+class SharedMutableBlob : public MutableBlob
+{
+ public:
+  // A zero-filled memory file of 'size' bytes, mapped writable
+  explicit SharedMutableBlob(U64 size, ScrubType scrubType = ScrubType::NONE,
+    CompareType compareType = CompareType::DEFAULT);
+  SharedMutableBlob(SharedMutableBlob &&other);
+  SharedMutableBlob &operator=(SharedMutableBlob &&other);
+
+  int fd() const;
+
+  // End writing: remap the data read-only in place and seal the file. The
+  // data moves to the returned SharedBlob (Blobs already taken from this one
+  // stay valid) and this blob is left empty.
+  SharedBlob seal();
+
+ private:
+  int fd_;
+};
+
+inline int SharedBlob::fd() const
+{
+  return fd_;
+}
+
+inline int SharedMutableBlob::fd() const
+{
+  return fd_;
+}
+
+} // namespace Util
+
+#endif // UTIL_SHARED_BLOB_H
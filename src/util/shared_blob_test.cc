@@ -0,0 +1,179 @@
+#include "gtest/gtest.h"
+#include "util/shared_blob.h"
+#include "util/byte_encoders.h"
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+// Hand a descriptor to "another process" the way processes do: through a
+// Unix socket, which installs a new descriptor for the same file
+int passDescriptor(int _fd)
+{
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+    return -1;
+  }
+  char byte = 0;
+  char control[CMSG_SPACE(sizeof(int))] = {};
+  struct iovec iov = {&byte, 1};
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy((void *)CMSG_DATA(cmsg), (const void *)&_fd, sizeof(int));
+  int received = -1;
+  if ((sendmsg(sockets[0], &msg, 0) == 1) && (recvmsg(sockets[1], &msg, 0) == 1)) {
+    memcpy((void *)&received, (const void *)CMSG_DATA(CMSG_FIRSTHDR(&msg)), sizeof(int));
+  }
+  close(sockets[0]);
+  close(sockets[1]);
+  return received;
+}
+
+string readFile(int _fd, U64 _size)
+{
+  string data(_size, '\0');
+  EXPECT_EQ((ssize_t)_size, pread(_fd, &data[0], _size, 0));
+  return data;
+}
+
+} // anonymous namespace
+
+
+TEST(SharedBlobTest, SealAndMap) {
+  const string text = "Handed over without copying";
+  SharedMutableBlob out(text.size());
+  ASSERT_LE(0, out.fd());
+  EXPECT_EQ(text.size(), out.size());
+  EXPECT_EQ(0, out[0]);   // zero-filled
+  memcpy((void *)out.data(), (const void *)text.data(), text.size());
+  Blob early(out, 7, 0);
+  const Byte *data = out.data();
+
+  SharedBlob sealed = out.seal();
+  ASSERT_LE(0, sealed.fd());
+  EXPECT_EQ(0UL, out.size());
+  EXPECT_EQ(-1, out.fd());
+  EXPECT_EQ(data, sealed.data());   // remapped in place
+  EXPECT_EQ(Blob(text), sealed);
+  EXPECT_EQ(Blob(string("Handed ")), early);
+
+  // The file can no longer be changed
+  EXPECT_EQ(-1, pwrite(sealed.fd(), "x", 1, 0));
+  EXPECT_EQ(-1, ftruncate(sealed.fd(), 1));
+
+  int received = passDescriptor(sealed.fd());
+  ASSERT_LE(0, received);
+  SharedBlob in(received);
+  close(received);
+  ASSERT_LE(0, in.fd());
+  EXPECT_NE(sealed.data(), in.data());   // a mapping of its own
+  EXPECT_EQ(sealed, in);
+  Blob slice(in, 7, 12);
+  sealed = SharedBlob();
+  in = SharedBlob();
+  EXPECT_EQ(Blob(string("without")), slice);
+}
+
+TEST(SharedBlobTest, Invalid) {
+  // Files which are not sealed, or not memory files, are not mapped
+  SharedMutableBlob writable(64);
+  errno = 0;
+  SharedBlob unsealed(writable.fd());
+  EXPECT_EQ(EPERM, errno);
+  EXPECT_EQ(-1, unsealed.fd());
+  EXPECT_EQ(0UL, unsealed.size());
+
+  int pipes[2];
+  ASSERT_EQ(0, pipe(pipes));
+  SharedBlob notMemory(pipes[0]);
+  EXPECT_EQ(-1, notMemory.fd());
+  close(pipes[0]);
+  close(pipes[1]);
+
+  SharedBlob none(-1);
+  EXPECT_EQ(EBADF, errno);
+
+  // Empty data seals and maps too
+  SharedMutableBlob empty(0);
+  SharedBlob sealed = empty.seal();
+  ASSERT_LE(0, sealed.fd());
+  EXPECT_EQ(0UL, SharedBlob(sealed.fd()).size());
+  EXPECT_EQ(-1, empty.seal().fd());
+}
+
+TEST(SharedBlobTest, Scrub) {
+  // Writable data is scrubbed on release; sealed data is left for others
+  SharedMutableBlob secret(32, Blob::ScrubType::ZEROS);
+  memset((void *)secret.data(), 0x5a, secret.size());
+  int copy = dup(secret.fd());
+  ASSERT_LE(0, copy);
+  secret = SharedMutableBlob(0);
+  EXPECT_EQ(string(32, '\0'), readFile(copy, 32));
+  close(copy);
+
+  SharedMutableBlob shared(32, Blob::ScrubType::ZEROS);
+  memset((void *)shared.data(), 0x5a, shared.size());
+  SharedBlob sealed = shared.seal();
+  EXPECT_EQ(Blob::ScrubType::ZEROS, sealed.scrubType());
+  copy = dup(sealed.fd());
+  ASSERT_LE(0, copy);
+  sealed = SharedBlob();
+  EXPECT_EQ(string(32, '\x5a'), readFile(copy, 32));
+
+  // Cached text is scrubbed even though the sealed data cannot be, both in
+  // the sender and in the receiver
+  SharedBlob received(copy, Blob::ScrubType::ZEROS);
+  close(copy);
+  SharedMutableBlob more(32, Blob::ScrubType::ZEROS);
+  SharedBlob sent = more.seal();
+  for (const Blob *blob : {(const Blob *)&sent, (const Blob *)&received}) {
+    std::shared_ptr<const string> hex = blob->cachedEncode<Hex>();
+    EXPECT_EQ(hex, blob->cachedEncode<Hex>());
+    EXPECT_NE(nullptr, std::get_deleter<Container::EncodingScrubber>(hex));
+  }
+}
+
+TEST(SharedBlobTest, Move) {
+  // The descriptor moves with the data; the blob moved from has none
+  SharedMutableBlob first(16);
+  const int fd = first.fd();
+  ASSERT_LE(0, fd);
+  SharedMutableBlob second(std::move(first));
+  EXPECT_EQ(-1, first.fd());
+  EXPECT_EQ(fd, second.fd());
+  errno = 0;
+  EXPECT_EQ(-1, first.seal().fd());
+  EXPECT_EQ(EBADF, errno);
+
+  SharedMutableBlob third(0);
+  third = std::move(second);
+  EXPECT_EQ(-1, second.fd());
+  EXPECT_EQ(fd, third.fd());
+  EXPECT_EQ(-1, second.seal().fd());
+
+  SharedBlob sealed = third.seal();
+  ASSERT_EQ(fd, sealed.fd());
+  SharedBlob moved(std::move(sealed));
+  EXPECT_EQ(-1, sealed.fd());
+  EXPECT_EQ(fd, moved.fd());
+  SharedBlob assigned;
+  assigned = std::move(moved);
+  EXPECT_EQ(-1, moved.fd());
+  EXPECT_EQ(fd, assigned.fd());
+  EXPECT_EQ(16UL, SharedBlob(assigned.fd()).size());
+}
@@ -0,0 +1,525 @@
+#include "util/transform.h"
+#include "util/dispatch.h"
+#include "util/parallel_copy.h"
+#include <cstdint>
+#include <cstring>
+
+// The variants compiled: all of them, to be chosen at load time, or else the
+// one the compiler flags allow. The portable kernels are always compiled, as
+// the vector kernels use them for heads and tails.
+#if defined(UTIL_DISPATCH)
+#define UTIL_TRANSFORM_AVX2
+#define UTIL_TRANSFORM_SSSE3
+#elif __AVX2__
+#define UTIL_TRANSFORM_AVX2
+#elif __SSSE3__
+#define UTIL_TRANSFORM_SSSE3
+#endif
+
+#if defined(UTIL_TRANSFORM_AVX2) || defined(UTIL_TRANSFORM_SSSE3)
+#include <immintrin.h>
+#endif
+
+using namespace Util;
+
+namespace {
+
+// A repeating key shorter than this is expanded to apply it this many bytes
+// at a time
+const U64 kKeyBlock = 1024;
+
+namespace Portable {
+
+void bitwise(Byte *_dst, const Byte *_src, const Byte *_operand, U64 _size, BitOp _op)
+{
+  switch (_op) {
+    case BitOp::AND:
+      for (U64 i = 0; i < _size; i++) {
+        _dst[i] = _src[i] & _operand[i];
+      }
+      break;
+    case BitOp::OR:
+      for (U64 i = 0; i < _size; i++) {
+        _dst[i] = _src[i] | _operand[i];
+      }
+      break;
+    case BitOp::XOR:
+      for (U64 i = 0; i < _size; i++) {
+        _dst[i] = _src[i] ^ _operand[i];
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void invert(Byte *_dst, const Byte *_src, U64 _size)
+{
+  for (U64 i = 0; i < _size; i++) {
+    _dst[i] = (Byte)~_src[i];
+  }
+}
+
+void byteSwap(Byte *_dst, const Byte *_src, U64 _size, U32 _width)
+{
+  U64 i = 0;
+  switch (_width) {
+    case 2:
+      for (; i + 2 <= _size; i += 2) {
+        U16 value;
+        memcpy((void *)&value, (const void *)&_src[i], sizeof(value));
+        value = __builtin_bswap16(value);
+        memcpy((void *)&_dst[i], (const void *)&value, sizeof(value));
+      }
+      break;
+    case 4:
+      for (; i + 4 <= _size; i += 4) {
+        U32 value;
+        memcpy((void *)&value, (const void *)&_src[i], sizeof(value));
+        value = __builtin_bswap32(value);
+        memcpy((void *)&_dst[i], (const void *)&value, sizeof(value));
+      }
+      break;
+    case 8:
+      for (; i + 8 <= _size; i += 8) {
+        U64 value;
+        memcpy((void *)&value, (const void *)&_src[i], sizeof(value));
+        value = __builtin_bswap64(value);
+        memcpy((void *)&_dst[i], (const void *)&value, sizeof(value));
+      }
+      break;
+    default:
+      break;
+  }
+  if (_dst != _src && i < _size) {
+    memcpy((void *)&_dst[i], (const void *)&_src[i], _size - i);
+  }
+}
+
+void translate(Byte *_dst, const Byte *_src, U64 _size, const Byte *_table)
+{
+  for (U64 i = 0; i < _size; i++) {
+    _dst[i] = _table[_src[i]];
+  }
+}
+
+// Byte j of a vector lane, moved to reverse the bytes of its element
+inline Byte swapIndex(U32 _j, U32 _width)
+{
+  return (Byte)((_j & ~(_width - 1)) + (_width - 1) - (_j & (_width - 1)));
+}
+
+// The bytes before 'dst' reaches a 'vector' byte boundary, when that is a
+// whole number of elements; otherwise the vector loop stores unaligned
+inline U64 head(const Byte *_dst, U64 _size, U64 _vector, U32 _width)
+{
+  U64 n = (U64)((_vector - ((uintptr_t)_dst & (_vector - 1))) & (_vector - 1));
+  if (n % _width != 0) {
+    return 0;
+  }
+  return n < _size ? n : _size;
+}
+
+} // namespace Portable
+
+#ifdef UTIL_TRANSFORM_AVX2
+#ifdef UTIL_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+namespace Avx2 {
+
+inline __m256i load(const Byte *_p)
+{
+  return _mm256_loadu_si256((const __m256i *)_p);
+}
+
+inline void store(Byte *_p, __m256i _v)
+{
+  _mm256_storeu_si256((__m256i *)_p, _v);
+}
+
+void bitwise(Byte *_dst, const Byte *_src, const Byte *_operand, U64 _size, BitOp _op)
+{
+  U64 i = Portable::head(_dst, _size, 32, 1);
+  Portable::bitwise(_dst, _src, _operand, i, _op);
+  for (; i + 32 <= _size; i += 32) {
+    __m256i a = load(&_src[i]);
+    __m256i b = load(&_operand[i]);
+    store(&_dst[i], _op == BitOp::AND ? _mm256_and_si256(a, b) :
+      (_op == BitOp::OR ? _mm256_or_si256(a, b) : _mm256_xor_si256(a, b)));
+  }
+  Portable::bitwise(&_dst[i], &_src[i], &_operand[i], _size - i, _op);
+}
+
+void invert(Byte *_dst, const Byte *_src, U64 _size)
+{
+  const __m256i ones = _mm256_set1_epi8(-1);
+  U64 i = Portable::head(_dst, _size, 32, 1);
+  Portable::invert(_dst, _src, i);
+  for (; i + 32 <= _size; i += 32) {
+    store(&_dst[i], _mm256_xor_si256(load(&_src[i]), ones));
+  }
+  Portable::invert(&_dst[i], &_src[i], _size - i);
+}
+
+void byteSwap(Byte *_dst, const Byte *_src, U64 _size, U32 _width)
+{
+  if (_width != 2 && _width != 4 && _width != 8) {
+    Portable::byteSwap(_dst, _src, _size, _width);
+    return;
+  }
+  Byte indices[16];
+  for (U32 j = 0; j < 16; j++) {
+    indices[j] = Portable::swapIndex(j, _width);
+  }
+  const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)indices));
+  U64 i = Portable::head(_dst, _size, 32, _width);
+  Portable::byteSwap(_dst, _src, i, _width);
+  for (; i + 32 <= _size; i += 32) {
+    store(&_dst[i], _mm256_shuffle_epi8(load(&_src[i]), shuffle));
+  }
+  Portable::byteSwap(&_dst[i], &_src[i], _size - i, _width);
+}
+
+// Each 16 byte row of the table is looked up by the low nibbles and kept
+// where the high nibble selects that row
+void translate(Byte *_dst, const Byte *_src, U64 _size, const Byte *_table)
+{
+  __m256i rows[16];
+  for (U32 k = 0; k < 16; k++) {
+    rows[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&_table[16 * k]));
+  }
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  U64 i = Portable::head(_dst, _size, 32, 1);
+  Portable::translate(_dst, _src, i, _table);
+  for (; i + 32 <= _size; i += 32) {
+    __m256i v = load(&_src[i]);
+    __m256i lo = _mm256_and_si256(v, nibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    __m256i result = _mm256_setzero_si256();
+    for (U32 k = 0; k < 16; k++) {
+      __m256i row = _mm256_cmpeq_epi8(hi, _mm256_set1_epi8((char)k));
+      result = _mm256_or_si256(result, _mm256_and_si256(row, _mm256_shuffle_epi8(rows[k], lo)));
+    }
+    store(&_dst[i], result);
+  }
+  Portable::translate(&_dst[i], &_src[i], _size - i, _table);
+}
+
+} // namespace Avx2
+#ifdef UTIL_DISPATCH
+#pragma GCC pop_options
+#endif
+#endif
+
+#ifdef UTIL_TRANSFORM_SSSE3
+#ifdef UTIL_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+#endif
+namespace Ssse3 {
+
+inline __m128i load(const Byte *_p)
+{
+  return _mm_loadu_si128((const __m128i *)_p);
+}
+
+inline void store(Byte *_p, __m128i _v)
+{
+  _mm_storeu_si128((__m128i *)_p, _v);
+}
+
+void bitwise(Byte *_dst, const Byte *_src, const Byte *_operand, U64 _size, BitOp _op)
+{
+  U64 i = Portable::head(_dst, _size, 16, 1);
+  Portable::bitwise(_dst, _src, _operand, i, _op);
+  for (; i + 16 <= _size; i += 16) {
+    __m128i a = load(&_src[i]);
+    __m128i b = load(&_operand[i]);
+    store(&_dst[i], _op == BitOp::AND ? _mm_and_si128(a, b) :
+      (_op == BitOp::OR ? _mm_or_si128(a, b) : _mm_xor_si128(a, b)));
+  }
+  Portable::bitwise(&_dst[i], &_src[i], &_operand[i], _size - i, _op);
+}
+
+void invert(Byte *_dst, const Byte *_src, U64 _size)
+{
+  const __m128i ones = _mm_set1_epi8(-1);
+  U64 i = Portable::head(_dst, _size, 16, 1);
+  Portable::invert(_dst, _src, i);
+  for (; i + 16 <= _size; i += 16) {
+    store(&_dst[i], _mm_xor_si128(load(&_src[i]), ones));
+  }
+  Portable::invert(&_dst[i], &_src[i], _size - i);
+}
+
+void byteSwap(Byte *_dst, const Byte *_src, U64 _size, U32 _width)
+{
+  if (_width != 2 && _width != 4 && _width != 8) {
+    Portable::byteSwap(_dst, _src, _size, _width);
+    return;
+  }
+  Byte indices[16];
+  for (U32 j = 0; j < 16; j++) {
+    indices[j] = Portable::swapIndex(j, _width);
+  }
+  const __m128i shuffle = _mm_loadu_si128((const __m128i *)indices);
+  U64 i = Portable::head(_dst, _size, 16, _width);
+  Portable::byteSwap(_dst, _src, i, _width);
+  for (; i + 16 <= _size; i += 16) {
+    store(&_dst[i], _mm_shuffle_epi8(load(&_src[i]), shuffle));
+  }
+  Portable::byteSwap(&_dst[i], &_src[i], _size - i, _width);
+}
+
+void translate(Byte *_dst, const Byte *_src, U64 _size, const Byte *_table)
+{
+  __m128i rows[16];
+  for (U32 k = 0; k < 16; k++) {
+    rows[k] = _mm_loadu_si128((const __m128i *)&_table[16 * k]);
+  }
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  U64 i = Portable::head(_dst, _size, 16, 1);
+  Portable::translate(_dst, _src, i, _table);
+  for (; i + 16 <= _size; i += 16) {
+    __m128i v = load(&_src[i]);
+    __m128i lo = _mm_and_si128(v, nibble);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+    __m128i result = _mm_setzero_si128();
+    for (U32 k = 0; k < 16; k++) {
+      __m128i row = _mm_cmpeq_epi8(hi, _mm_set1_epi8((char)k));
+      result = _mm_or_si128(result, _mm_and_si128(row, _mm_shuffle_epi8(rows[k], lo)));
+    }
+    store(&_dst[i], result);
+  }
+  Portable::translate(&_dst[i], &_src[i], _size - i, _table);
+}
+
+} // namespace Ssse3
+#ifdef UTIL_DISPATCH
+#pragma GCC pop_options
+#endif
+#endif
+
+} // anonymous namespace
+
+
+#ifdef UTIL_DISPATCH
+extern "C" {
+
+UTIL_RESOLVER
+static decltype(&Portable::bitwise) util_resolve_transform_bitwise()
+{
+  return Cpu::hasAvx2() ? &Avx2::bitwise : (Cpu::hasSsse3() ? &Ssse3::bitwise : &Portable::bitwise);
+}
+
+UTIL_RESOLVER
+static decltype(&Portable::invert) util_resolve_transform_invert()
+{
+  return Cpu::hasAvx2() ? &Avx2::invert : (Cpu::hasSsse3() ? &Ssse3::invert : &Portable::invert);
+}
+
+UTIL_RESOLVER
+static decltype(&Portable::byteSwap) util_resolve_transform_byteSwap()
+{
+  return Cpu::hasAvx2() ? &Avx2::byteSwap :
+    (Cpu::hasSsse3() ? &Ssse3::byteSwap : &Portable::byteSwap);
+}
+
+UTIL_RESOLVER
+static decltype(&Portable::translate) util_resolve_transform_translate()
+{
+  return Cpu::hasAvx2() ? &Avx2::translate :
+    (Cpu::hasSsse3() ? &Ssse3::translate : &Portable::translate);
+}
+
+} // extern "C"
+
+namespace {
+namespace Selected {
+
+void bitwise(Byte *, const Byte *, const Byte *, U64, BitOp)
+  __attribute__((ifunc("util_resolve_transform_bitwise")));
+void invert(Byte *, const Byte *, U64) __attribute__((ifunc("util_resolve_transform_invert")));
+void byteSwap(Byte *, const Byte *, U64, U32)
+  __attribute__((ifunc("util_resolve_transform_byteSwap")));
+void translate(Byte *, const Byte *, U64, const Byte *)
+  __attribute__((ifunc("util_resolve_transform_translate")));
+
+} // namespace Selected
+} // anonymous namespace
+#else
+#if defined(UTIL_TRANSFORM_AVX2)
+namespace Selected = Avx2;
+#elif defined(UTIL_TRANSFORM_SSSE3)
+namespace Selected = Ssse3;
+#else
+namespace Selected = Portable;
+#endif
+#endif
+
+namespace {
+
+// One share of a repeating key transform, starting 'phase' bytes into the key
+void bitwiseRepeatingShare(Byte *_dst, const Byte *_src, U64 _size, const Byte *_key,
+  U64 _keySize, U64 _phase, BitOp _op)
+{
+  if (_keySize >= kKeyBlock) {
+    while (_size > 0) {
+      U64 n = (_keySize - _phase < _size) ? _keySize - _phase : _size;
+      Selected::bitwise(_dst, _src, &_key[_phase], n, _op);
+      _dst += n;
+      _src += n;
+      _size -= n;
+      _phase = 0;
+    }
+    return;
+  }
+
+  // The key repeated far enough to read a block from any phase. Blocks are
+  // a whole number of vectors, so only the first has an unaligned head.
+  Byte expanded[2 * kKeyBlock];
+  U64 length = kKeyBlock + _keySize;
+  memcpy((void *)expanded, (const void *)_key, _keySize);
+  for (U64 filled = _keySize; filled < length; ) {
+    U64 n = (length - filled < filled) ? length - filled : filled;
+    memcpy((void *)&expanded[filled], (const void *)expanded, n);
+    filled += n;
+  }
+  for (U64 offset = 0; offset < _size; offset += kKeyBlock) {
+    U64 n = (_size - offset < kKeyBlock) ? _size - offset : kKeyBlock;
+    Selected::bitwise(&_dst[offset], &_src[offset], &expanded[_phase], n, _op);
+    _phase = (_phase + kKeyBlock) % _keySize;
+  }
+  scrub_zeros(expanded, length);
+}
+
+// The size of an operand applied to a Blob
+inline U64 overlap(U64 _size, U64 _operandSize)
+{
+  return _operandSize < _size ? _operandSize : _size;
+}
+
+// The bytes of 'src' past 'offset', unchanged in 'output'
+inline void copyRest(MutableBlob &_output, const BlobView &_src, U64 _offset)
+{
+  if (_offset < _src.size()) {
+    memcpy((void *)&_output.data()[_offset], (const void *)&_src.data()[_offset],
+      _src.size() - _offset);
+  }
+}
+
+} // anonymous namespace
+
+
+void Util::bitwise(Byte *_dst, const Byte *_src, const Byte *_operand, U64 _size, BitOp _op)
+{
+  ParallelCopy::forShares(_size, [=] (U64 _offset, U64 _share) {
+    Selected::bitwise(&_dst[_offset], &_src[_offset], &_operand[_offset], _share, _op);
+  });
+}
+
+void Util::bitwise(MutableBlob &_blob, const BlobView &_operand, BitOp _op)
+{
+  Byte *data = _blob.data();
+  bitwise(data, data, _operand.data(), overlap(_blob.size(), _operand.size()), _op);
+}
+
+Blob Util::bitwise(const BlobView &_src, const BlobView &_operand, BitOp _op)
+{
+  MutableBlob output(_src.size(), _src.scrubType(), _src.compareType());
+  U64 size = overlap(_src.size(), _operand.size());
+  bitwise(output.data(), _src.data(), _operand.data(), size, _op);
+  copyRest(output, _src, size);
+  return Blob(output, output.size());
+}
+
+void Util::bitwiseRepeating(Byte *_dst, const Byte *_src, U64 _size, const Byte *_key,
+  U64 _keySize, BitOp _op)
+{
+  if (_keySize == 0) {
+    if (_dst != _src && _size > 0) {
+      memcpy((void *)_dst, (const void *)_src, _size);
+    }
+    return;
+  }
+  ParallelCopy::forShares(_size, [=] (U64 _offset, U64 _share) {
+    bitwiseRepeatingShare(&_dst[_offset], &_src[_offset], _share, _key, _keySize,
+      _offset % _keySize, _op);
+  });
+}
+
+void Util::bitwiseRepeating(MutableBlob &_blob, const BlobView &_key, BitOp _op)
+{
+  Byte *data = _blob.data();
+  bitwiseRepeating(data, data, _blob.size(), _key.data(), _key.size(), _op);
+}
+
+Blob Util::bitwiseRepeating(const BlobView &_src, const BlobView &_key, BitOp _op)
+{
+  MutableBlob output(_src.size(), _src.scrubType(), _src.compareType());
+  bitwiseRepeating(output.data(), _src.data(), _src.size(), _key.data(), _key.size(), _op);
+  return Blob(output, output.size());
+}
+
+void Util::invert(Byte *_dst, const Byte *_src, U64 _size)
+{
+  ParallelCopy::forShares(_size, [=] (U64 _offset, U64 _share) {
+    Selected::invert(&_dst[_offset], &_src[_offset], _share);
+  });
+}
+
+void Util::invert(MutableBlob &_blob)
+{
+  Byte *data = _blob.data();
+  invert(data, data, _blob.size());
+}
+
+Blob Util::invert(const BlobView &_src)
+{
+  MutableBlob output(_src.size(), _src.scrubType(), _src.compareType());
+  invert(output.data(), _src.data(), _src.size());
+  return Blob(output, output.size());
+}
+
+// Shares start on cache lines, so they split no element
+void Util::byteSwap(Byte *_dst, const Byte *_src, U64 _size, U32 _width)
+{
+  ParallelCopy::forShares(_size, [=] (U64 _offset, U64 _share) {
+    Selected::byteSwap(&_dst[_offset], &_src[_offset], _share, _width);
+  });
+}
+
+void Util::byteSwap(MutableBlob &_blob, U32 _width)
+{
+  Byte *data = _blob.data();
+  byteSwap(data, data, _blob.size(), _width);
+}
+
+Blob Util::byteSwap(const BlobView &_src, U32 _width)
+{
+  MutableBlob output(_src.size(), _src.scrubType(), _src.compareType());
+  byteSwap(output.data(), _src.data(), _src.size(), _width);
+  return Blob(output, output.size());
+}
+
+void Util::translate(Byte *_dst, const Byte *_src, U64 _size, const Byte _table[256])
+{
+  ParallelCopy::forShares(_size, [=] (U64 _offset, U64 _share) {
+    Selected::translate(&_dst[_offset], &_src[_offset], _share, _table);
+  });
+}
+
+void Util::translate(MutableBlob &_blob, const Byte _table[256])
+{
+  Byte *data = _blob.data();
+  translate(data, data, _blob.size(), _table);
+}
+
+Blob Util::translate(const BlobView &_src, const Byte _table[256])
+{
+  MutableBlob output(_src.size(), _src.scrubType(), _src.compareType());
+  translate(output.data(), _src.data(), _src.size(), _table);
+  return Blob(output, output.size());
+}
@@ -0,0 +1,68 @@
+#ifndef UTIL_TRANSFORM_H
+#define UTIL_TRANSFORM_H
+
+#include "util/blob.h"
+#include "util/fixed_types.h"
+
+namespace Util {
+
+/*
+   Byte-wise transforms: bitwise operations with another buffer or with a
+   repeating key, bitwise not, endian swaps of 16, 32 or 64-bit elements and
+   translation through a 256 byte table.
+
+   Each transform comes in three forms. The pointer form writes 'size' bytes
+   to 'dst', which may be 'src' itself (in place) but must not otherwise
+   overlap its inputs. The MutableBlob form transforms the Blob in place. The
+   BlobView form returns a new Blob, which inherits the scrub and compare
+   types of its source.
+
+   The kernels are vectorized with AVX2, or SSSE3, chosen at load time (see
+   dispatch.h). Stores are aligned once the destination reaches a vector
+   boundary, so slices at any offset only cost a scalar head and tail.
+   Inputs of at least ParallelCopy::threshold() bytes are split across the
+   ParallelCopy thread pool, since the transforms are bound by memory
+   bandwidth just as a copy is.
+
+     Util::MutableBlob packet(payload);
+     Util::bitwiseRepeating(packet, mask, Util::BitOp::XOR);
+     Util::byteSwap(packet, 4);                // Big-endian U32s to native
+*/
+
+enum class BitOp
+{
+  AND, OR, XOR
+};
+
+// dst = src op operand. Where the operand is shorter than the source (Blob
+// forms), the bytes past its end are unchanged.
+void bitwise(Byte *dst, const Byte *src, const Byte *operand, U64 size, BitOp op);
+void bitwise(MutableBlob &blob, const BlobView &operand, BitOp op);
+Blob bitwise(const BlobView &src, const BlobView &operand, BitOp op);
+
+// dst = src op key, where the key repeats from src[0] (an empty key changes
+// nothing). The key is expanded into a stack buffer, which is scrubbed.
+void bitwiseRepeating(Byte *dst, const Byte *src, U64 size, const Byte *key, U64 keySize,
+  BitOp op);
+void bitwiseRepeating(MutableBlob &blob, const BlobView &key, BitOp op);
+Blob bitwiseRepeating(const BlobView &src, const BlobView &key, BitOp op);
+
+// dst = ~src
+void invert(Byte *dst, const Byte *src, U64 size);
+void invert(MutableBlob &blob);
+Blob invert(const BlobView &src);
+
+// Reverses the bytes of each 'width' byte element (2, 4 or 8; otherwise
+// the data is unchanged). Bytes past the last whole element are unchanged.
+void byteSwap(Byte *dst, const Byte *src, U64 size, U32 width);
+void byteSwap(MutableBlob &blob, U32 width);
+Blob byteSwap(const BlobView &src, U32 width);
+
+// dst[i] = table[src[i]]
+void translate(Byte *dst, const Byte *src, U64 size, const Byte table[256]);
+void translate(MutableBlob &blob, const Byte table[256]);
+Blob translate(const BlobView &src, const Byte table[256]);
+
+} // namespace Util
+
+#endif // UTIL_TRANSFORM_H
@@ -0,0 +1,190 @@
+#include "gtest/gtest.h"
+#include "util/transform.h"
+#include "util/parallel_copy.h"
+#include "util/blob.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Util;
+using std::string;
+
+namespace {
+
+std::vector<Byte> randomBytes(U64 size, U32 seed)
+{
+  std::default_random_engine gen(seed);
+  std::uniform_int_distribution<U32> dist(0, 255);
+  std::vector<Byte> bytes(size);
+  for (U64 i = 0; i < size; i++) {
+    bytes[i] = (Byte)dist(gen);
+  }
+  return bytes;
+}
+
+Byte apply(Byte a, Byte b, BitOp op)
+{
+  return op == BitOp::AND ? (Byte)(a & b) : (op == BitOp::OR ? (Byte)(a | b) : (Byte)(a ^ b));
+}
+
+std::vector<Byte> swapped(const std::vector<Byte> &src, U64 offset, U64 size, U32 width)
+{
+  std::vector<Byte> out(src.begin() + (long)offset, src.begin() + (long)(offset + size));
+  for (U64 i = 0; i + width <= size; i += width) {
+    for (U32 j = 0; j < width; j++) {
+      out[i + j] = src[offset + i + width - 1 - j];
+    }
+  }
+  return out;
+}
+
+// Sizes around the vector widths, at offsets which misalign the slices
+const U64 kSizes[] = {0, 1, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 257, 1000};
+const U64 kOffsets[] = {0, 1, 3, 8, 13};
+
+// Runs the transforms on the pool for anything over 64 bytes
+struct Parallel
+{
+  Parallel()
+    : threads_(ParallelCopy::threads()), threshold_(ParallelCopy::threshold())
+  {
+    ParallelCopy::threadsIs(4);
+    ParallelCopy::thresholdIs(64);
+  }
+
+  ~Parallel()
+  {
+    ParallelCopy::threadsIs(threads_);
+    ParallelCopy::thresholdIs(threshold_);
+  }
+
+  U32 threads_;
+  U64 threshold_;
+};
+
+} // anonymous namespace
+
+
+TEST(TransformTest, Bitwise) {
+  std::vector<Byte> a = randomBytes(1100, 1);
+  std::vector<Byte> b = randomBytes(1100, 2);
+  for (BitOp op : {BitOp::AND, BitOp::OR, BitOp::XOR}) {
+    for (U64 size : kSizes) {
+      for (U64 offset : kOffsets) {
+        std::vector<Byte> dst(size + 1, 0xee);
+        bitwise(dst.data(), &a[offset], &b[offset + 1], size, op);
+        std::vector<Byte> inPlace(a.begin() + (long)offset, a.begin() + (long)(offset + size));
+        bitwise(inPlace.data(), inPlace.data(), &b[offset + 1], size, op);
+        for (U64 i = 0; i < size; i++) {
+          ASSERT_EQ(apply(a[offset + i], b[offset + 1 + i], op), dst[i]) << size << " " << i;
+          ASSERT_EQ(dst[i], inPlace[i]);
+        }
+        EXPECT_EQ(0xee, dst[size]);
+      }
+    }
+  }
+}
+
+TEST(TransformTest, Repeating) {
+  std::vector<Byte> src = randomBytes(5000, 3);
+  for (U64 keySize : {1UL, 3UL, 16UL, 33UL, 1000UL, 1024UL, 1500UL}) {
+    std::vector<Byte> key = randomBytes(keySize, 4);
+    for (U64 size : {0UL, 5UL, 64UL, 999UL, 4321UL}) {
+      std::vector<Byte> dst(size);
+      bitwiseRepeating(dst.data(), &src[1], size, key.data(), keySize, BitOp::XOR);
+      for (U64 i = 0; i < size; i++) {
+        ASSERT_EQ((Byte)(src[1 + i] ^ key[i % keySize]), dst[i]) << keySize << " " << i;
+      }
+    }
+  }
+
+  // An empty key changes nothing
+  Blob blob(string("unchanged"));
+  EXPECT_EQ(blob, bitwiseRepeating(blob.view(), BlobView(), BitOp::XOR));
+}
+
+TEST(TransformTest, InvertTranslate) {
+  std::vector<Byte> src = randomBytes(1100, 5);
+  Byte table[256];
+  for (U32 i = 0; i < 256; i++) {
+    table[i] = (Byte)(i * 167 + 13);
+  }
+  for (U64 size : kSizes) {
+    for (U64 offset : kOffsets) {
+      std::vector<Byte> inverted(size);
+      std::vector<Byte> translated(size);
+      invert(inverted.data(), &src[offset], size);
+      translate(translated.data(), &src[offset], size, table);
+      for (U64 i = 0; i < size; i++) {
+        ASSERT_EQ((Byte)~src[offset + i], inverted[i]);
+        ASSERT_EQ(table[src[offset + i]], translated[i]);
+      }
+    }
+  }
+}
+
+TEST(TransformTest, ByteSwap) {
+  std::vector<Byte> src = randomBytes(1100, 6);
+  for (U32 width : {2U, 4U, 8U}) {
+    for (U64 size : kSizes) {
+      for (U64 offset : kOffsets) {
+        std::vector<Byte> dst(size);
+        byteSwap(dst.data(), &src[offset], size, width);
+        EXPECT_EQ(swapped(src, offset, size, width), dst) << width << " " << size;
+        std::vector<Byte> inPlace(src.begin() + (long)offset, src.begin() + (long)(offset + size));
+        byteSwap(inPlace.data(), inPlace.data(), size, width);
+        EXPECT_EQ(dst, inPlace);
+      }
+    }
+  }
+
+  // Other widths leave the data as it is
+  Blob blob(string("abcdef"));
+  EXPECT_EQ(blob, byteSwap(blob.view(), 3));
+}
+
+TEST(TransformTest, Blobs) {
+  Blob text(string("Hello, World"), Blob::ScrubType::ZEROS, Blob::CompareType::CONST);
+  Blob mask(string("    "));
+
+  // Bytes past a shorter operand are unchanged
+  Blob lower = bitwise(text.view(), mask.view(), BitOp::OR);
+  EXPECT_EQ(Blob(string("hello, World")), lower);
+  EXPECT_EQ(Blob::ScrubType::ZEROS, lower.scrubType());
+  EXPECT_EQ(Blob::CompareType::CONST, lower.compareType());
+
+  MutableBlob inPlace(text);
+  bitwiseRepeating(inPlace, mask.view(), BitOp::XOR);
+  EXPECT_EQ(Blob(string("hELLO\x0c\0wORLD", 12)), inPlace);
+  bitwiseRepeating(inPlace, mask.view(), BitOp::XOR);
+  EXPECT_EQ(text, inPlace);
+
+  invert(inPlace);
+  EXPECT_EQ(invert(text.view()), inPlace);
+  invert(inPlace);
+
+  U32 checksum = inPlace.crc32c();
+  byteSwap(inPlace, 2);
+  EXPECT_EQ(Blob(string("eHll,oW rodl")), inPlace);
+  EXPECT_NE(checksum, inPlace.crc32c());
+
+  Byte upper[256];
+  for (U32 i = 0; i < 256; i++) {
+    upper[i] = (Byte)((i >= 'a' && i <= 'z') ? i - 32 : i);
+  }
+  EXPECT_EQ(Blob(string("HELLO, WORLD")), translate(text.view(), upper));
+}
+
+TEST(TransformTest, Parallel) {
+  Parallel parallel;
+  std::vector<Byte> src = randomBytes(100003, 7);
+  std::vector<Byte> key = randomBytes(100, 8);
+  std::vector<Byte> dst(src.size());
+
+  bitwiseRepeating(dst.data(), src.data(), src.size(), key.data(), key.size(), BitOp::XOR);
+  for (U64 i = 0; i < src.size(); i++) {
+    ASSERT_EQ((Byte)(src[i] ^ key[i % key.size()]), dst[i]) << i;
+  }
+  byteSwap(dst.data(), src.data(), src.size(), 8);
+  EXPECT_EQ(swapped(src, 0, src.size(), 8), dst);
+}